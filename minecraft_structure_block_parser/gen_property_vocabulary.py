@@ -0,0 +1,123 @@
+import os
+import re
+import sys
+
+# Reads the block property names and values that nbt.cpp documents and uses, and writes
+# src_code_in_mineways/propertyVocabulary.h: an id for each, and a perfect hash table for each set,
+# so a palette entry's properties are recognized with one hash and one compare instead of a chain
+# of string comparisons. Run again whenever the property comments or rules in nbt.cpp change.
+
+# Java property words that nbt.cpp reads past without documenting them; a state's other properties
+# are still recognized when one of these is present, but knowing them lets a caller tell "ignored"
+# from "misspelled".
+EXTRA_KEYS = ['waterlogged', 'north', 'south', 'east', 'west', 'up', 'down', 'instrument', 'note',
+              'thickness', 'vertical_direction', 'tilt', 'orientation', 'sculk_sensor_phase', 'flower_amount']
+EXTRA_VALUES = ['true', 'false', 'none', 'low', 'tall', 'side', 'partial', 'unstable', 'full',
+                'tip', 'tip_merge', 'frustum', 'middle', 'base', 'inactive', 'active', 'cooldown']
+
+def collect_vocabulary(nbt_cpp_path):
+    with open(nbt_cpp_path, 'r', encoding='utf-8') as f:
+        source = f.read()
+    keys = set(EXTRA_KEYS)
+    values = set(EXTRA_VALUES)
+
+    # the property comments: "// facing: north|south|east|west", "// north|east|south|west[|up|down]: VINE_PROP"
+    for match in re.finditer(r'^//\s*([a-z_]+(?:\s*[|,]\s*[a-z_]+)*)(?:\[\|([a-z_|]+)\])?:\s*(.*)$', source, re.MULTILINE):
+        for key in re.split(r'\s*[|,]\s*', match.group(1)):
+            keys.add(key)
+        if match.group(2):
+            keys.update(match.group(2).split('|'))
+        listed = re.match(r'([a-z_]+(?:[|/][a-z_]+)+)', match.group(3))
+        if listed:
+            values.update(re.split(r'[|/]', listed.group(1)))
+        elif re.match(r'(true|false)\b', match.group(3)):
+            values.update(['true', 'false'])
+
+    # what the reverse table writes: addProperty(props, "key", ...) and the value arrays it indexes
+    for match in re.finditer(r'addProperty\(props,\s*"([a-z_]+)",\s*([^;]*)\);', source):
+        keys.add(match.group(1))
+        values.update(re.findall(r'"([a-z_]+)"', match.group(2)))
+    for match in re.finditer(r'static const char\* g\w+\[\d+\]\s*=\s*\{([^}]*)\}', source):
+        values.update(re.findall(r'"([a-z_]+)"', match.group(1)))
+    for match in re.finditer(r'\{\s*\w+_PROP,\s*-?\d+,\s*"([a-z_]+)",\s*"([a-z_]+)"\s*\}', source):
+        keys.add(match.group(1))
+        values.add(match.group(2))
+
+    return sorted(keys), sorted(values)
+
+BUCKET_SEED = 2166136261
+
+def property_hash(s, seed):
+    # keep in step with propertyHash() in propertyParser.cpp
+    h = seed
+    for c in s.encode('ascii'):
+        h = ((h ^ c) * 16777619) & 0xffffffff
+    return h
+
+def make_perfect_hash(words):
+    # hash and displace: a first hash picks a bucket, and each bucket has its own seed for the second
+    # hash, chosen (biggest buckets first) so its words land in free slots
+    bits = 1
+    while (1 << bits) < 2 * len(words):
+        bits += 1
+    bucket_count = (len(words) + 1) // 2
+    buckets = [[] for _ in range(bucket_count)]
+    for i, word in enumerate(words):
+        buckets[property_hash(word, BUCKET_SEED) % bucket_count].append(i)
+    slots = [-1] * (1 << bits)
+    seeds = [0] * bucket_count
+    for b in sorted(range(bucket_count), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        for seed in range(1, 65536):
+            taken = [property_hash(words[i], seed) >> (32 - bits) for i in buckets[b]]
+            if len(set(taken)) == len(taken) and all(slots[t] < 0 for t in taken):
+                for i, t in zip(buckets[b], taken):
+                    slots[t] = i
+                seeds[b] = seed
+                break
+        else:
+            raise RuntimeError('no perfect hash seed found')
+    return seeds, bits, slots
+
+def write_table(out, prefix, label, words, seeds, bits, slots):
+    out.write(f'#define PROPERTY_{label}_COUNT {len(words)}\n')
+    for i, word in enumerate(words):
+        out.write(f'#define {prefix}_{word.upper():<24} {i}\n')
+    out.write('\n')
+    out.write(f'static const char* const gProperty{label.capitalize()}Names[PROPERTY_{label}_COUNT] = {{\n')
+    for i in range(0, len(words), 8):
+        out.write('    ' + ' '.join(f'"{w}",' for w in words[i:i + 8]) + '\n')
+    out.write('};\n')
+    out.write(f'#define PROPERTY_{label}_BUCKETS {len(seeds)}\n')
+    out.write(f'static const unsigned short gProperty{label.capitalize()}Seeds[PROPERTY_{label}_BUCKETS] = {{\n')
+    for i in range(0, len(seeds), 16):
+        out.write('    ' + ' '.join(f'{s},' for s in seeds[i:i + 16]) + '\n')
+    out.write('};\n')
+    out.write(f'#define PROPERTY_{label}_HASH_BITS {bits}\n')
+    out.write(f'static const short gProperty{label.capitalize()}Slots[1 << PROPERTY_{label}_HASH_BITS] = {{\n')
+    for i in range(0, len(slots), 16):
+        out.write('    ' + ' '.join(f'{s},' for s in slots[i:i + 16]) + '\n')
+    out.write('};\n\n')
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    src = os.path.join(here, 'src_code_in_mineways')
+    keys, values = collect_vocabulary(os.path.join(src, 'nbt.cpp'))
+    print(f"Found {len(keys)} property keys and {len(values)} values in nbt.cpp.")
+
+    out_path = os.path.join(src, 'propertyVocabulary.h')
+    with open(out_path, 'w', encoding='utf-8', newline='\n') as out:
+        out.write('// propertyVocabulary.h - block property keys and values, with perfect hash tables for them; made by\n')
+        out.write('// ../gen_property_vocabulary.py from nbt.cpp, so do not edit by hand\n\n')
+        out.write('#pragma once\n\n')
+        out.write('// Values that are whole numbers, such as age=3 and power=15, are not listed; see findPropertyValue().\n\n')
+        out.write(f'#define PROPERTY_BUCKET_SEED {BUCKET_SEED}u\n\n')
+        seeds, bits, slots = make_perfect_hash(keys)
+        write_table(out, 'PK', 'KEY', keys, seeds, bits, slots)
+        seeds, bits, slots = make_perfect_hash(values)
+        write_table(out, 'PV', 'VALUE', values, seeds, bits, slots)
+    print(f"Wrote {out_path}.")
+
+if __name__ == '__main__':
+    sys.exit(main())
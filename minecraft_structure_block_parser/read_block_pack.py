@@ -0,0 +1,59 @@
+import mmap
+import struct
+import sys
+
+# Layout is documented in src_code_in_mineways/blockPack.h; keep the two in step.
+BLOCK_PACK_MAGIC = b'MWBLKPAK'
+BLOCK_PACK_VERSION_MAJOR = 1
+HEADER_FORMAT = '<8sHH13I'
+
+def read_block_pack(path):
+    """
+    Reads a block pack written by Mineways' writeBlockPack() and returns its three tables
+    as lists of dicts: blocks (indexed by type), translations, and tiles.
+    """
+    with open(path, 'rb') as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+    (magic, version_major, version_minor, header_size,
+     block_count, block_stride, block_offset,
+     translation_count, translation_stride, translation_offset,
+     tile_count, tile_stride, tile_offset,
+     strings_size, strings_offset, checksum) = struct.unpack_from(HEADER_FORMAT, data, 0)
+    if magic != BLOCK_PACK_MAGIC or version_major != BLOCK_PACK_VERSION_MAJOR:
+        raise ValueError(f"{path} is not a version {BLOCK_PACK_VERSION_MAJOR} block pack")
+
+    def string_at(offset):
+        start = strings_offset + offset
+        return data[start:data.find(b'\0', start)].decode('utf-8')
+
+    # records may be longer than these formats in later minor versions, so always step by the stride
+    blocks = []
+    for i in range(block_count):
+        name, read_color, read_alpha, flags, txr_x, txr_y, subtype_mask = \
+            struct.unpack_from('<IIfIhhB', data, block_offset + i * block_stride)
+        blocks.append({'name': string_at(name), 'read_color': read_color, 'read_alpha': read_alpha,
+                       'flags': flags, 'txrX': txr_x, 'txrY': txr_y, 'subtype_mask': subtype_mask})
+
+    translations = []
+    for i in range(translation_count):
+        name, block_type, data_val, _, translate_flags = \
+            struct.unpack_from('<IHBBI', data, translation_offset + i * translation_stride)
+        translations.append({'name': string_at(name), 'type': block_type, 'dataVal': data_val,
+                             'translateFlags': translate_flags})
+
+    tiles = []
+    for i in range(tile_count):
+        filename, alt_filename, txr_x, txr_y, type_for_mtl, data_val_for_mtl, flags = \
+            struct.unpack_from('<IIhhhhI', data, tile_offset + i * tile_stride)
+        tiles.append({'filename': string_at(filename), 'altFilename': string_at(alt_filename),
+                      'txrX': txr_x, 'txrY': txr_y, 'typeForMtl': type_for_mtl,
+                      'dataValForMtl': data_val_for_mtl, 'flags': flags})
+
+    return {'version': (version_major, version_minor), 'blocks': blocks,
+            'translations': translations, 'tiles': tiles}
+
+if __name__ == '__main__':
+    pack = read_block_pack(sys.argv[1])
+    print(f"Block pack version {pack['version'][0]}.{pack['version'][1]}: {len(pack['blocks'])} blocks, "
+          f"{len(pack['translations'])} translations, {len(pack['tiles'])} tiles.")
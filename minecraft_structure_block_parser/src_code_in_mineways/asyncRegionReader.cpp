@@ -0,0 +1,645 @@
+// asyncRegionReader.cpp - read every chunk of many region files with many reads in flight, decoding on a pool of threads
+
+#include "stdafx.h"
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mappedFile.h"
+#include "chunkCompression.h"
+#include "regionFile.h"
+#include "asyncRegionReader.h"
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && !defined(REGION_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define ASYNC_READ_IO_URING
+#endif
+#endif
+#endif
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// threads issuing reads when io_uring can't be used; more only add contention
+#define MAX_READER_THREADS 16
+
+typedef struct SourceFile {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+#endif
+    unsigned long long size;
+    std::wstring directory;     // for .mcc files
+    int regionX;
+    int regionZ;
+    bool named;
+} SourceFile;
+
+typedef struct ReadRequest {
+    int fileIndex;
+    int chunkIndex;             // z * 32 + x
+    unsigned int timestamp;
+    unsigned long long offset;
+    size_t length;              // 0 if the location table entry is damaged, so there's nothing to read
+} ReadRequest;
+
+typedef struct ReadSlot {
+    std::vector<unsigned char> buffer;
+    const ReadRequest* request;
+    long long bytesRead;        // negative if the read failed
+#ifdef ASYNC_READ_IO_URING
+    struct iovec iov;
+#endif
+} ReadSlot;
+
+// what the reading and decoding threads share; reads take free slots and give them, filled, to the decoders
+typedef struct AsyncReader {
+    std::vector<SourceFile> files;
+    std::vector<ReadRequest> requests;
+    std::vector<ReadSlot> slots;
+    ChunkReadCallback callback;
+    void* context;
+
+    std::mutex lock;
+    std::condition_variable slotFreed;
+    std::condition_variable slotFilled;
+    std::vector<ReadSlot*> freeSlots;
+    std::deque<ReadSlot*> filledSlots;
+    size_t nextRequest;         // for the reader threads
+    bool reading;               // false once every request has been read
+} AsyncReader;
+
+static unsigned int readBigInt(const unsigned char* p)
+{
+    return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+static bool openSourceFile(const wchar_t* filename, SourceFile& file)
+{
+#ifdef _WIN32
+    file.handle = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file.handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file.handle, &fileSize)) {
+        CloseHandle(file.handle);
+        file.handle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    file.size = (unsigned long long)fileSize.QuadPart;
+#else
+    char path[MAX_PATH * 4];
+    if (wcstombs(path, filename, sizeof(path)) == (size_t)-1) {
+        return false;
+    }
+    path[sizeof(path) - 1] = '\0';
+    file.fd = open(path, O_RDONLY);
+    if (file.fd < 0) {
+        return false;
+    }
+    off_t end = lseek(file.fd, 0, SEEK_END);
+    if (end < 0) {
+        close(file.fd);
+        file.fd = -1;
+        return false;
+    }
+    file.size = (unsigned long long)end;
+#endif
+    file.named = parseRegionFilename(filename, file.directory, file.regionX, file.regionZ);
+    return true;
+}
+
+static void closeSourceFile(SourceFile& file)
+{
+#ifdef _WIN32
+    if (file.handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(file.handle);
+        file.handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (file.fd >= 0) {
+        close(file.fd);
+        file.fd = -1;
+    }
+#endif
+}
+
+// A blocking read of length bytes at offset, continuing after short reads. Returns the bytes read, fewer
+// only at the end of the file, or negative on error.
+static long long readAt(const SourceFile& file, unsigned char* buffer, size_t length, unsigned long long offset)
+{
+    size_t done = 0;
+    while (done < length) {
+#ifdef _WIN32
+        // a synchronous handle still reads at the OVERLAPPED offset
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = (DWORD)(offset + done);
+        overlapped.OffsetHigh = (DWORD)((offset + done) >> 32);
+        DWORD br = 0;
+        if (!ReadFile(file.handle, buffer + done, (DWORD)(length - done), &br, &overlapped)) {
+            return (GetLastError() == ERROR_HANDLE_EOF) ? (long long)done : LINE_ERROR;
+        }
+        long long got = br;
+#else
+        long long got = pread(file.fd, buffer + done, length - done, (off_t)(offset + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            return LINE_ERROR;
+        }
+#endif
+        if (got == 0) {
+            break;
+        }
+        done += (size_t)got;
+    }
+    return (long long)done;
+}
+
+// Opens the files and reads their location tables into requests, sorted by file and offset so each file
+// is read front to back. Returns 0, or negative on error.
+static int planReads(AsyncReader& reader, const wchar_t* const* regionFilenames, int fileCount)
+{
+    unsigned char tables[2 * REGION_SECTOR_SIZE];
+    for (int f = 0; f < fileCount; f++) {
+        SourceFile opened;
+        if (!openSourceFile(regionFilenames[f], opened)) {
+            return LINE_ERROR;
+        }
+        // kept from here on, so it's closed with the rest
+        reader.files.push_back(opened);
+        const SourceFile& file = reader.files.back();
+        // a region with no chunks may be an empty file
+        if (file.size == 0) {
+            continue;
+        }
+        if (file.size < sizeof(tables) || readAt(file, tables, sizeof(tables), 0) != (long long)sizeof(tables)) {
+            return LINE_ERROR;
+        }
+        for (int i = 0; i < REGION_CHUNKS; i++) {
+            unsigned int location = readBigInt(tables + i * 4);
+            if (location == 0) {
+                continue;
+            }
+            ReadRequest request;
+            request.fileIndex = f;
+            request.chunkIndex = i;
+            request.timestamp = readBigInt(tables + REGION_SECTOR_SIZE + i * 4);
+            request.offset = (unsigned long long)(location >> 8) * REGION_SECTOR_SIZE;
+            request.length = (size_t)(location & 0xff) * REGION_SECTOR_SIZE;
+            // the first two sectors are the tables; a chunk cut short by the file's end is caught when decoded
+            if ((location >> 8) < 2 || request.length == 0 || request.offset >= file.size) {
+                request.length = 0;
+            }
+            else if (request.offset + request.length > file.size) {
+                request.length = (size_t)(file.size - request.offset);
+            }
+            reader.requests.push_back(request);
+        }
+    }
+    std::sort(reader.requests.begin(), reader.requests.end(), [](const ReadRequest& a, const ReadRequest& b) {
+        return (a.fileIndex != b.fileIndex) ? a.fileIndex < b.fileIndex : a.offset < b.offset;
+        });
+    return 0;
+}
+
+// a free slot, waiting for one if wait is set; NULL if none is free and wait isn't set
+static ReadSlot* takeFreeSlot(AsyncReader& reader, bool wait)
+{
+    std::unique_lock<std::mutex> guard(reader.lock);
+    if (wait) {
+        reader.slotFreed.wait(guard, [&reader] { return !reader.freeSlots.empty(); });
+    }
+    else if (reader.freeSlots.empty()) {
+        return NULL;
+    }
+    ReadSlot* slot = reader.freeSlots.back();
+    reader.freeSlots.pop_back();
+    return slot;
+}
+
+static void giveFilledSlot(AsyncReader& reader, ReadSlot* slot)
+{
+    {
+        std::lock_guard<std::mutex> guard(reader.lock);
+        reader.filledSlots.push_back(slot);
+    }
+    reader.slotFilled.notify_one();
+}
+
+// ready a slot for a request; false if there's nothing to read
+static bool prepareSlot(ReadSlot* slot, const ReadRequest* request)
+{
+    slot->request = request;
+    slot->bytesRead = LINE_ERROR;
+    if (request->length == 0) {
+        return false;
+    }
+    if (slot->buffer.size() < request->length) {
+        slot->buffer.resize(request->length);
+    }
+    return true;
+}
+
+static void decodeChunks(AsyncReader* reader)
+{
+    std::vector<unsigned char> nbt;
+    for (;;) {
+        ReadSlot* slot;
+        {
+            std::unique_lock<std::mutex> guard(reader->lock);
+            reader->slotFilled.wait(guard, [reader] { return !reader->filledSlots.empty() || !reader->reading; });
+            if (reader->filledSlots.empty()) {
+                return;
+            }
+            slot = reader->filledSlots.front();
+            reader->filledSlots.pop_front();
+        }
+        const ReadRequest* request = slot->request;
+        const SourceFile& file = reader->files[request->fileIndex];
+        ChunkReadResult result;
+        result.fileIndex = request->fileIndex;
+        result.chunkX = request->chunkIndex % 32;
+        result.chunkZ = request->chunkIndex / 32;
+        result.timestamp = request->timestamp;
+        result.nbt = NULL;
+        result.nbtSize = 0;
+        result.status = (int)slot->bytesRead;
+        if (slot->bytesRead >= 5) {
+            const unsigned char* p = slot->buffer.data();
+            size_t length = readBigInt(p);
+            if (length < 1 || length + 4 > (size_t)slot->bytesRead) {
+                result.status = LINE_ERROR;
+            }
+            else if (p[4] & CHUNK_COMPRESSION_EXTERNAL) {
+                MappedFile mcc;
+                if (!file.named || openMappedFile(getExternalChunkFilename(file.directory,
+                    file.regionX * 32 + result.chunkX, file.regionZ * 32 + result.chunkZ).c_str(), mcc) < 0) {
+                    result.status = LINE_ERROR;
+                }
+                else {
+                    result.status = decompressChunk(p[4], mcc.data, mcc.size, nbt);
+                    closeMappedFile(mcc);
+                }
+            }
+            else {
+                result.status = decompressChunk(p[4], p + 5, length - 1, nbt);
+            }
+        }
+        else if (slot->bytesRead >= 0) {
+            result.status = LINE_ERROR;
+        }
+        if (result.status >= 0) {
+            result.status = 0;
+            result.nbt = nbt.data();
+            result.nbtSize = nbt.size();
+        }
+        reader->callback(result, reader->context);
+        {
+            std::lock_guard<std::mutex> guard(reader->lock);
+            reader->freeSlots.push_back(slot);
+        }
+        reader->slotFreed.notify_one();
+    }
+}
+
+static void readChunks(AsyncReader* reader)
+{
+    for (;;) {
+        ReadSlot* slot = takeFreeSlot(*reader, true);
+        const ReadRequest* request;
+        {
+            std::lock_guard<std::mutex> guard(reader->lock);
+            if (reader->nextRequest == reader->requests.size()) {
+                reader->freeSlots.push_back(slot);
+                break;
+            }
+            request = &reader->requests[reader->nextRequest++];
+        }
+        if (prepareSlot(slot, request)) {
+            slot->bytesRead = readAt(reader->files[request->fileIndex], slot->buffer.data(), request->length, request->offset);
+        }
+        giveFilledSlot(*reader, slot);
+    }
+    // another reader may be waiting for a slot that will never be needed
+    reader->slotFreed.notify_all();
+}
+
+// from nextRequest on
+static void readWithThreads(AsyncReader& reader, int threadCount)
+{
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.push_back(std::thread(readChunks, &reader));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+#ifdef ASYNC_READ_IO_URING
+
+// Just enough of io_uring to queue reads and collect them, as liburing would: the submission and completion
+// rings are shared with the kernel, which moves their heads while this side moves their tails.
+typedef struct IoRing {
+    int fd;
+    void* sqMap;
+    size_t sqMapSize;
+    void* cqMap;
+    size_t cqMapSize;
+    struct io_uring_sqe* sqes;
+    size_t sqesSize;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe* cqes;
+} IoRing;
+
+static void closeIoRing(IoRing& ring)
+{
+    if (ring.sqes != NULL) {
+        munmap(ring.sqes, ring.sqesSize);
+    }
+    if (ring.cqMap != NULL && ring.cqMap != ring.sqMap) {
+        munmap(ring.cqMap, ring.cqMapSize);
+    }
+    if (ring.sqMap != NULL) {
+        munmap(ring.sqMap, ring.sqMapSize);
+    }
+    close(ring.fd);
+}
+
+// false if the kernel is too old, or io_uring is turned off or blocked
+static bool openIoRing(unsigned entries, IoRing& ring)
+{
+    memset(&ring, 0, sizeof(ring));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring.fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring.fd < 0) {
+        return false;
+    }
+    ring.sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        ring.sqMapSize = ring.cqMapSize = std::max(ring.sqMapSize, ring.cqMapSize);
+    }
+    void* map = mmap(NULL, ring.sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    if (map == MAP_FAILED) {
+        closeIoRing(ring);
+        return false;
+    }
+    ring.sqMap = map;
+    if (single) {
+        ring.cqMap = ring.sqMap;
+    }
+    else {
+        map = mmap(NULL, ring.cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+        if (map == MAP_FAILED) {
+            closeIoRing(ring);
+            return false;
+        }
+        ring.cqMap = map;
+    }
+    ring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    map = mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (map == MAP_FAILED) {
+        closeIoRing(ring);
+        return false;
+    }
+    ring.sqes = (struct io_uring_sqe*)map;
+    unsigned char* sq = (unsigned char*)ring.sqMap;
+    unsigned char* cq = (unsigned char*)ring.cqMap;
+    ring.sqHead = (unsigned*)(sq + params.sq_off.head);
+    ring.sqTail = (unsigned*)(sq + params.sq_off.tail);
+    ring.sqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    ring.sqArray = (unsigned*)(sq + params.sq_off.array);
+    ring.cqHead = (unsigned*)(cq + params.cq_off.head);
+    ring.cqTail = (unsigned*)(cq + params.cq_off.tail);
+    ring.cqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+static void queueRead(IoRing& ring, int fd, ReadSlot* slot)
+{
+    unsigned tail = *ring.sqTail;
+    unsigned index = tail & ring.sqMask;
+    struct io_uring_sqe* sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    slot->iov.iov_base = slot->buffer.data();
+    slot->iov.iov_len = slot->request->length;
+    // READV rather than READ, which needs Linux 5.6
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long)(uintptr_t)&slot->iov;
+    sqe->len = 1;
+    sqe->off = slot->request->offset;
+    sqe->user_data = (unsigned long long)(uintptr_t)slot;
+    ring.sqArray[index] = index;
+    // the kernel must see the entry before the new tail
+    __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// Submits what's queued and, if wait is set, waits for at least one read to finish. Returns false on error.
+static bool enterIoRing(IoRing& ring, unsigned toSubmit, bool wait)
+{
+    while (toSubmit > 0 || wait) {
+        long submitted = syscall(__NR_io_uring_enter, ring.fd, toSubmit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            return false;
+        }
+        toSubmit -= (unsigned)submitted;
+        // a wait is satisfied by the call that made it
+        wait = false;
+    }
+    return true;
+}
+
+// Gives each finished read to the decoders. Returns how many there were.
+static unsigned reapIoRing(AsyncReader& reader, IoRing& ring)
+{
+    unsigned head = *ring.cqHead;
+    unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+    unsigned reaped = tail - head;
+    for (; head != tail; head++) {
+        struct io_uring_cqe* cqe = &ring.cqes[head & ring.cqMask];
+        ReadSlot* slot = (ReadSlot*)(uintptr_t)cqe->user_data;
+        const ReadRequest* request = slot->request;
+        slot->bytesRead = (cqe->res < 0) ? LINE_ERROR : cqe->res;
+        // a short read isn't an error; finish it the slow way
+        if (cqe->res > 0 && (size_t)cqe->res < request->length) {
+            long long more = readAt(reader.files[request->fileIndex], slot->buffer.data() + cqe->res,
+                request->length - cqe->res, request->offset + cqe->res);
+            slot->bytesRead = (more < 0) ? more : cqe->res + more;
+        }
+        giveFilledSlot(reader, slot);
+    }
+    // the kernel may reuse the entries once it sees the new head
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+// Reads, the slow way, what was queued but that the kernel didn't take. Returns how many there were.
+static unsigned readUnsubmitted(AsyncReader& reader, IoRing& ring)
+{
+    unsigned head = __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+    unsigned tail = *ring.sqTail;
+    for (unsigned i = head; i != tail; i++) {
+        ReadSlot* slot = (ReadSlot*)(uintptr_t)ring.sqes[ring.sqArray[i & ring.sqMask]].user_data;
+        const ReadRequest* request = slot->request;
+        slot->bytesRead = readAt(reader.files[request->fileIndex], slot->buffer.data(), request->length, request->offset);
+        giveFilledSlot(reader, slot);
+    }
+    return tail - head;
+}
+
+// Issues reads from this thread with up to queueDepth in flight, giving each to the decoders as it
+// finishes. Returns false if io_uring can't be used, before anything has been read.
+static bool readWithIoRing(AsyncReader& reader, unsigned queueDepth)
+{
+    IoRing ring;
+    if (!openIoRing(queueDepth, ring)) {
+        return false;
+    }
+    size_t next = 0;
+    unsigned inFlight = 0;
+    bool failed = false;
+    while (next < reader.requests.size() || inFlight > 0) {
+        unsigned queued = 0;
+        while (!failed && next < reader.requests.size() && inFlight + queued < queueDepth) {
+            // if nothing is being read, a slot must come back from the decoders
+            ReadSlot* slot = takeFreeSlot(reader, inFlight + queued == 0);
+            if (slot == NULL) {
+                break;
+            }
+            const ReadRequest* request = &reader.requests[next++];
+            if (prepareSlot(slot, request)) {
+                queueRead(ring, reader.files[request->fileIndex].fd, slot);
+                queued++;
+            }
+            else {
+                giveFilledSlot(reader, slot);
+            }
+        }
+        inFlight += queued;
+        if (!enterIoRing(ring, queued, inFlight > 0)) {
+            failed = true;
+            inFlight -= readUnsubmitted(reader, ring);
+        }
+        inFlight -= reapIoRing(reader, ring);
+        if (failed) {
+            // no more waiting in the kernel, so wait here for the reads it has
+            while (inFlight > 0) {
+                std::this_thread::yield();
+                inFlight -= reapIoRing(reader, ring);
+            }
+            break;
+        }
+    }
+    closeIoRing(ring);
+    if (failed) {
+        // the ring broke partway; the threads read what's left
+        std::lock_guard<std::mutex> guard(reader.lock);
+        reader.nextRequest = next;
+    }
+    return !failed;
+}
+
+#endif
+
+int readRegionChunksAsync(const wchar_t* const* regionFilenames, int fileCount, const AsyncReadOptions* options,
+    ChunkReadCallback callback, void* context, bool* usedIoUring)
+{
+    if (usedIoUring != NULL) {
+        *usedIoUring = false;
+    }
+    if (fileCount < 0 || (fileCount > 0 && regionFilenames == NULL) || callback == NULL) {
+        return LINE_ERROR;
+    }
+    int queueDepth = (options != NULL && options->queueDepth > 0) ? options->queueDepth : ASYNC_READ_QUEUE_DEPTH;
+    int decodeThreads = (options != NULL) ? options->decodeThreads : 0;
+    if (decodeThreads <= 0) {
+        decodeThreads = (int)std::thread::hardware_concurrency();
+        if (decodeThreads <= 0) {
+            decodeThreads = 1;
+        }
+    }
+    bool allowIoUring = (options == NULL) || options->allowIoUring;
+
+    AsyncReader reader;
+    reader.callback = callback;
+    reader.context = context;
+    int retCode = planReads(reader, regionFilenames, fileCount);
+    if (retCode < 0) {
+        for (size_t f = 0; f < reader.files.size(); f++) {
+            closeSourceFile(reader.files[f]);
+        }
+        return retCode;
+    }
+    // reads and decodes have the same slots between them, which bounds memory to queueDepth chunks
+    reader.slots.resize(queueDepth);
+    for (int i = 0; i < queueDepth; i++) {
+        reader.freeSlots.push_back(&reader.slots[i]);
+    }
+    reader.nextRequest = 0;
+    reader.reading = true;
+
+    std::vector<std::thread> decoders;
+    for (int i = 0; i < decodeThreads; i++) {
+        decoders.push_back(std::thread(decodeChunks, &reader));
+    }
+    bool ringRead = false;
+#ifdef ASYNC_READ_IO_URING
+    if (allowIoUring) {
+        ringRead = readWithIoRing(reader, (unsigned)queueDepth);
+    }
+#else
+    (void)allowIoUring;
+#endif
+    if (!ringRead) {
+        readWithThreads(reader, std::min(queueDepth, MAX_READER_THREADS));
+    }
+    {
+        std::lock_guard<std::mutex> guard(reader.lock);
+        reader.reading = false;
+    }
+    reader.slotFilled.notify_all();
+    for (size_t i = 0; i < decoders.size(); i++) {
+        decoders[i].join();
+    }
+    for (size_t f = 0; f < reader.files.size(); f++) {
+        closeSourceFile(reader.files[f]);
+    }
+    if (usedIoUring != NULL) {
+        *usedIoUring = ringRead;
+    }
+    return (int)reader.requests.size();
+}
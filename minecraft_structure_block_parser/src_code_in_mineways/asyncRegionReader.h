@@ -0,0 +1,41 @@
+// asyncRegionReader.h - read every chunk of many region files with many reads in flight, decoding on a pool of threads
+
+#pragma once
+
+#include <stddef.h>
+
+// Reading a whole world is one small read per chunk across hundreds of region files. Each file's location
+// table is read first; then all chunk reads are sorted by file and offset and issued with up to queueDepth
+// in flight. On Linux they go through io_uring, with one system call submitting a batch and collecting
+// what's done; elsewhere, or if the kernel refuses io_uring, a pool of threads issues them with pread()
+// (ReadFile on Windows). Each finished read goes straight to a pool of decode threads, which decompress
+// the chunk (chunkCompression.h), reading its .mcc file if it has one, and hand the NBT to the callback.
+// Define REGION_NO_IO_URING to build without io_uring.
+
+#define ASYNC_READ_QUEUE_DEPTH 64
+
+typedef struct AsyncReadOptions {
+    int queueDepth;         // reads in flight, and chunks waiting to be decoded; 0 for ASYNC_READ_QUEUE_DEPTH
+    int decodeThreads;      // 0 for one per core
+    bool allowIoUring;      // false to always use the thread pool, as for measuring
+} AsyncReadOptions;
+
+typedef struct ChunkReadResult {
+    int fileIndex;                  // into the list of region files
+    int chunkX;                     // within the region, 0-31
+    int chunkZ;
+    unsigned int timestamp;
+    int status;                     // 0, or negative if the chunk couldn't be read or decompressed
+    const unsigned char* nbt;       // valid only during the callback
+    size_t nbtSize;
+} ChunkReadResult;
+
+// Called on the decode threads, several at once, in no particular order.
+typedef void (*ChunkReadCallback)(const ChunkReadResult& result, void* context);
+
+// Reads every saved chunk of the files. options may be NULL for the defaults. usedIoUring, if not NULL, is
+// set to whether io_uring did the reading. Returns the number of chunks given to the callback, including
+// ones with errors, or negative if a file can't be opened or its location table read, in which case no
+// chunks are read.
+int readRegionChunksAsync(const wchar_t* const* regionFilenames, int fileCount, const AsyncReadOptions* options,
+    ChunkReadCallback callback, void* context, bool* usedIoUring);
@@ -0,0 +1,216 @@
+// atlasMipmap.cpp - build a mipmap chain for an exported texture atlas, one tile at a time, so tiles never bleed together
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include "tiles.h"
+#include "blockCompress.h"
+#include "atlasMipmap.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// 1-3-3-1 tent filter: each output texel covers 4x4 input texels, centered on its 2x2 footprint
+static const int gTent[4] = { 1, 3, 3, 1 };
+
+void getAtlasTileFlags(int* tileFlags)
+{
+    for (int i = 0; i < TOTAL_TILES; i++) {
+        tileFlags[i] = SWATCH_CLAMP_ALL;
+    }
+    for (int i = 0; i < TOTAL_TILES; i++) {
+        tileFlags[gTilesTable[i].txrY * 16 + gTilesTable[i].txrX] = gTilesTable[i].flags;
+    }
+}
+
+// Map a coordinate that may be off the edge of an n-texel tile interior back into it, following the tile's
+// SWATCH_* bits. Returns -1 if the texel is off the edge and neither repeated nor clamped, i.e. transparent.
+static int addressTexel(int v, int n, bool repeat, bool clampLow, bool clampHigh)
+{
+    if (v >= 0 && v < n) {
+        return v;
+    }
+    if (repeat) {
+        return ((v % n) + n) % n;
+    }
+    if (v < 0) {
+        return clampLow ? 0 : -1;
+    }
+    return clampHigh ? n - 1 : -1;
+}
+
+static unsigned char* tileOrigin(AtlasImage& img, int col, int row)
+{
+    return &img.rgba[((size_t)row * img.tileSize * img.width + (size_t)col * img.tileSize) * 4];
+}
+
+static void downsampleTile(AtlasImage& src, AtlasImage& dst, int col, int row, int flags)
+{
+    int ns = src.tileSize;
+    int nd = dst.tileSize;
+    const unsigned char* in = tileOrigin(src, col, row);
+    unsigned char* out = tileOrigin(dst, col, row);
+    bool repeatX = (flags & SBIT_REPEAT_SIDES) != 0;
+    bool repeatY = (flags & SBIT_REPEAT_TOP_BOTTOM) != 0;
+
+    for (int y = 0; y < nd; y++) {
+        int sy[4];
+        for (int j = 0; j < 4; j++) {
+            sy[j] = addressTexel(2 * y - 1 + j, ns, repeatY, (flags & SBIT_CLAMP_TOP) != 0, (flags & SBIT_CLAMP_BOTTOM) != 0);
+        }
+        for (int x = 0; x < nd; x++) {
+            int sx[4];
+            for (int i = 0; i < 4; i++) {
+                sx[i] = addressTexel(2 * x - 1 + i, ns, repeatX, (flags & SBIT_CLAMP_LEFT) != 0, (flags & SBIT_CLAMP_RIGHT) != 0);
+            }
+            // weighted by alpha, so a texel's color counts only as much as it shows;
+            // plain sums are kept in case everything is transparent
+            int sumA = 0, sumValid = 0;
+            int sumC[3] = { 0, 0, 0 }, sumPlain[3] = { 0, 0, 0 };
+            for (int j = 0; j < 4; j++) {
+                if (sy[j] < 0) {
+                    continue;
+                }
+                for (int i = 0; i < 4; i++) {
+                    if (sx[i] < 0) {
+                        continue;
+                    }
+                    const unsigned char* px = &in[((size_t)sy[j] * src.width + sx[i]) * 4];
+                    int w = gTent[i] * gTent[j];
+                    int wa = w * px[3];
+                    for (int c = 0; c < 3; c++) {
+                        sumC[c] += wa * px[c];
+                        sumPlain[c] += w * px[c];
+                    }
+                    sumA += wa;
+                    sumValid += w;
+                }
+            }
+            unsigned char* po = &out[((size_t)y * dst.width + x) * 4];
+            for (int c = 0; c < 3; c++) {
+                if (sumA > 0) {
+                    po[c] = (unsigned char)((sumC[c] + sumA / 2) / sumA);
+                }
+                else {
+                    po[c] = (unsigned char)(sumValid ? (sumPlain[c] + sumValid / 2) / sumValid : 0);
+                }
+            }
+            // off-edge transparent texels count toward the total weight of 64, with zero alpha
+            int alpha = (sumA + 32) / 64;
+            if (flags & SBIT_CUTOUT_GEOMETRY) {
+                alpha = (alpha >= 128) ? 255 : 0;
+            }
+            po[3] = (unsigned char)alpha;
+        }
+    }
+}
+
+int stripAtlasBorders(const unsigned char* rgba, int width, int height, int tileSize, int border, std::vector<unsigned char>& stripped, int& strippedWidth, int& strippedHeight)
+{
+    int interior = tileSize - 2 * border;
+    if (border < 0 || interior <= 0 || (width % tileSize) != 0 || (height % tileSize) != 0) {
+        return LINE_ERROR;
+    }
+    int tilesPerRow = width / tileSize;
+    int tileRows = height / tileSize;
+    strippedWidth = tilesPerRow * interior;
+    strippedHeight = tileRows * interior;
+    stripped.resize((size_t)strippedWidth * strippedHeight * 4);
+    for (int y = 0; y < strippedHeight; y++) {
+        int srcY = (y / interior) * tileSize + border + (y % interior);
+        for (int col = 0; col < tilesPerRow; col++) {
+            memcpy(&stripped[((size_t)y * strippedWidth + (size_t)col * interior) * 4],
+                &rgba[((size_t)srcY * width + (size_t)col * tileSize + border) * 4], (size_t)interior * 4);
+        }
+    }
+    return 0;
+}
+
+int buildAtlasMipChain(const unsigned char* rgba, int width, int height, int tileSize, const int* tileFlags, int threadCount, std::vector<AtlasImage>& mips)
+{
+    // only tiles of a power of two halve all the way down, as a GPU mip chain must
+    if (tileSize <= 0 || (tileSize & (tileSize - 1)) != 0 || (width % tileSize) != 0 || (height % tileSize) != 0) {
+        return LINE_ERROR;
+    }
+    int tilesPerRow = width / tileSize;
+    int tileRows = height / tileSize;
+    int tileCount = tilesPerRow * tileRows;
+
+    std::vector<int> defaultFlags;
+    if (tileFlags == NULL) {
+        defaultFlags.assign(tileCount, SWATCH_CLAMP_ALL);
+        if (tilesPerRow == 16 && tileRows <= VERTICAL_TILES) {
+            std::vector<int> allFlags(TOTAL_TILES);
+            getAtlasTileFlags(allFlags.data());
+            memcpy(defaultFlags.data(), allFlags.data(), tileCount * sizeof(int));
+        }
+        tileFlags = defaultFlags.data();
+    }
+
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+
+    mips.clear();
+    mips.reserve(32);
+    AtlasImage base;
+    base.width = width;
+    base.height = height;
+    base.tileSize = tileSize;
+    base.rgba.assign(rgba, rgba + (size_t)width * height * 4);
+    mips.push_back(base);
+
+    for (int size = tileSize / 2; size >= 1; size /= 2) {
+        AtlasImage& src = mips.back();
+        AtlasImage dst;
+        dst.tileSize = size;
+        dst.width = tilesPerRow * dst.tileSize;
+        dst.height = tileRows * dst.tileSize;
+        dst.rgba.assign((size_t)dst.width * dst.height * 4, 0);
+
+        // each tile is independent, so threads just take the next tile
+        std::atomic<int> nextTile(0);
+        auto worker = [&]() {
+            int tile;
+            while ((tile = nextTile++) < tileCount) {
+                int col = tile % tilesPerRow;
+                int row = tile / tilesPerRow;
+                downsampleTile(src, dst, col, row, tileFlags[tile]);
+            }
+        };
+        int levelThreads = (threadCount > tileCount) ? tileCount : threadCount;
+        std::vector<std::thread> threads;
+        for (int t = 1; t < levelThreads; t++) {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+        mips.push_back(dst);
+    }
+    return 0;
+}
+
+int writeCompressedMipChain(const wchar_t* filename, int container, int format, const std::vector<AtlasImage>& mips, const unsigned char* alphaModes, int threadCount)
+{
+    std::vector<CompressedLevel> levels;
+    for (size_t i = 0; i < mips.size(); i++) {
+        if (mips[i].tileSize < 4 || (mips[i].tileSize % 4) != 0) {
+            break;
+        }
+        CompressedLevel level;
+        int retCode = compressAtlas(mips[i].rgba.data(), mips[i].width, mips[i].height, mips[i].tileSize, format, alphaModes, threadCount, level);
+        if (retCode < 0) {
+            return retCode;
+        }
+        levels.push_back(level);
+    }
+    if (levels.empty()) {
+        return LINE_ERROR;
+    }
+    return writeCompressedAtlas(filename, container, format, levels);
+}
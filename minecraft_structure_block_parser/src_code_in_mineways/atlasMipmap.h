@@ -0,0 +1,36 @@
+// atlasMipmap.h - build a mipmap chain for an exported texture atlas, one tile at a time, so tiles never bleed together
+
+#pragma once
+
+#include <vector>
+
+typedef struct AtlasImage {
+    int width;
+    int height;
+    int tileSize;   // size of each tile at this level
+    std::vector<unsigned char> rgba;
+} AtlasImage;
+
+// Build the mip chain for an atlas of tileSize x tileSize tiles, any number per row. mips[0] is a copy of the input.
+// Each tile is filtered on its own: samples falling off the tile's edge follow its gTilesTable SWATCH_* bits
+// (repeat, clamp, or transparent), color is weighted by alpha so cutouts don't pick up the color of their
+// transparent texels, and SBIT_CUTOUT_GEOMETRY tiles get their alpha snapped back to 0 or 255.
+// tileSize must be a power of two, so each level is exactly half the last, down to 1-pixel tiles, as DDS and
+// KTX2 mip chains must be. Bordered swatches, such as Mineways' 18x18-from-16x16 ones, can't halve like that
+// (18, 10, 6, ...); take their borders off with stripAtlasBorders() first, and mip the 16x16 tiles.
+// tileFlags gives the SBIT_* flags per tile, indexed by row*(width/tileSize)+column; pass NULL to use gTilesTable,
+// which assumes the 16-wide terrainExt.png layout. threadCount of 0 means use all cores.
+// Returns 0 on success, negative on error, including a tileSize that isn't a power of two.
+int buildAtlasMipChain(const unsigned char* rgba, int width, int height, int tileSize, const int* tileFlags, int threadCount, std::vector<AtlasImage>& mips);
+
+// The atlas with the border ring of width border taken off each tileSize x tileSize tile, leaving tiles of
+// tileSize - 2*border, in the same places. Returns 0 on success, negative on error.
+int stripAtlasBorders(const unsigned char* rgba, int width, int height, int tileSize, int border, std::vector<unsigned char>& stripped, int& strippedWidth, int& strippedHeight);
+
+// Fill tileFlags (TOTAL_TILES entries, indexed by txrY*16+txrX) with each tile's flags from gTilesTable.
+// Tile slots that nothing uses are given SWATCH_CLAMP_ALL.
+void getAtlasTileFlags(int* tileFlags);
+
+// Block-compress the chain (see blockCompress.h) and write it as one .dds or .ktx2 file. Levels whose tiles
+// are smaller than 4x4 are left off, since BC blocks would then straddle tiles. Returns 0 on success, negative on error.
+int writeCompressedMipChain(const wchar_t* filename, int container, int format, const std::vector<AtlasImage>& mips, const unsigned char* alphaModes, int threadCount);
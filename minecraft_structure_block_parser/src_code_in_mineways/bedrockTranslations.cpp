@@ -0,0 +1,477 @@
+// bedrockTranslations.cpp - Bedrock block names and states to Mineways types and data values, next to the Java BlockTranslations
+
+#include "stdafx.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "blockStateCache.h"
+#include "propertyVocabulary.h"
+#include "propertyParser.h"
+#include "unknownBlocks.h"
+#include "bedrockTranslations.h"
+
+// most states an entry is translated with
+#define MAX_BEDROCK_STATES 32
+
+////////////////////////////////////////////////////////////////////////////////
+// Names
+
+// A Bedrock name that is not the Java one. If stateKey is given, the entry applies only when that state
+// has stateValue, e.g. stone with stone_type=granite. A javaName starting with % is a pattern: the state's
+// value, with Bedrock's color names made Java's, goes in front of the rest, e.g. wool with color=red is red_wool.
+// Names that are a state of the Java block, such as lit_furnace, also give that property.
+typedef struct BedrockName {
+    const char* bedrockName;
+    const char* stateKey;
+    const char* stateValue;
+    const char* javaName;
+    const char* javaKey;
+    const char* javaValue;
+} BedrockName;
+
+static const BedrockName gBedrockNames[] = {
+    { "grass", NULL, NULL, "grass_block", NULL, NULL },
+    { "melon_block", NULL, NULL, "melon", NULL, NULL },
+    { "lit_pumpkin", NULL, NULL, "jack_o_lantern", NULL, NULL },
+    { "snow_layer", NULL, NULL, "snow", NULL, NULL },
+    { "snow", NULL, NULL, "snow_block", NULL, NULL },
+    { "golden_rail", NULL, NULL, "powered_rail", NULL, NULL },
+    { "web", NULL, NULL, "cobweb", NULL, NULL },
+    { "deadbush", NULL, NULL, "dead_bush", NULL, NULL },
+    { "waterlily", NULL, NULL, "lily_pad", NULL, NULL },
+    { "reeds", NULL, NULL, "sugar_cane", NULL, NULL },
+    { "hardened_clay", NULL, NULL, "terracotta", NULL, NULL },
+    { "brick_block", NULL, NULL, "bricks", NULL, NULL },
+    { "yellow_flower", NULL, NULL, "dandelion", NULL, NULL },
+    { "mob_spawner", NULL, NULL, "spawner", NULL, NULL },
+    { "quartz_ore", NULL, NULL, "nether_quartz_ore", NULL, NULL },
+    { "end_bricks", NULL, NULL, "end_stone_bricks", NULL, NULL },
+    { "nether_brick", NULL, NULL, "nether_bricks", NULL, NULL },
+    { "red_nether_brick", NULL, NULL, "red_nether_bricks", NULL, NULL },
+    { "slime", NULL, NULL, "slime_block", NULL, NULL },
+    { "noteblock", NULL, NULL, "note_block", NULL, NULL },
+    { "magma", NULL, NULL, "magma_block", NULL, NULL },
+    { "portal", NULL, NULL, "nether_portal", NULL, NULL },
+    { "grass_path", NULL, NULL, "dirt_path", NULL, NULL },
+    { "stone_stairs", NULL, NULL, "cobblestone_stairs", NULL, NULL },
+    { "normal_stone_stairs", NULL, NULL, "stone_stairs", NULL, NULL },
+    { "trapdoor", NULL, NULL, "oak_trapdoor", NULL, NULL },
+    { "wooden_door", NULL, NULL, "oak_door", NULL, NULL },
+    { "fence_gate", NULL, NULL, "oak_fence_gate", NULL, NULL },
+    { "wooden_pressure_plate", NULL, NULL, "oak_pressure_plate", NULL, NULL },
+    { "wooden_button", NULL, NULL, "oak_button", NULL, NULL },
+    { "standing_sign", NULL, NULL, "oak_sign", NULL, NULL },
+    { "wall_sign", NULL, NULL, "oak_wall_sign", NULL, NULL },
+    { "unpowered_repeater", NULL, NULL, "repeater", NULL, NULL },
+    { "powered_repeater", NULL, NULL, "repeater", "powered", "true" },
+    { "unpowered_comparator", NULL, NULL, "comparator", NULL, NULL },
+    { "powered_comparator", NULL, NULL, "comparator", "powered", "true" },
+    { "lit_furnace", NULL, NULL, "furnace", "lit", "true" },
+    { "lit_blast_furnace", NULL, NULL, "blast_furnace", "lit", "true" },
+    { "lit_smoker", NULL, NULL, "smoker", "lit", "true" },
+    { "lit_redstone_ore", NULL, NULL, "redstone_ore", "lit", "true" },
+    { "lit_deepslate_redstone_ore", NULL, NULL, "deepslate_redstone_ore", "lit", "true" },
+    { "lit_redstone_lamp", NULL, NULL, "redstone_lamp", "lit", "true" },
+    { "unlit_redstone_torch", NULL, NULL, "redstone_torch", "lit", "false" },
+    { "redstone_wire", NULL, NULL, "redstone_wire", NULL, NULL },
+    { "flowing_water", NULL, NULL, "water", NULL, NULL },
+    { "flowing_lava", NULL, NULL, "lava", NULL, NULL },
+    { "piston_arm_collision", NULL, NULL, "piston_head", NULL, NULL },
+    { "sticky_piston_arm_collision", NULL, NULL, "piston_head", "type", "sticky" },
+    { "trip_wire", NULL, NULL, "tripwire", NULL, NULL },
+    { "seaLantern", NULL, NULL, "sea_lantern", NULL, NULL },
+    { "invisible_bedrock", NULL, NULL, "barrier", NULL, NULL },
+    { "undyed_shulker_box", NULL, NULL, "shulker_box", NULL, NULL },
+    { "frog_spawn", NULL, NULL, "frogspawn", NULL, NULL },
+    { "concretePowder", "color", NULL, "%_concrete_powder", NULL, NULL },
+    { "concrete_powder", "color", NULL, "%_concrete_powder", NULL, NULL },
+    { "wool", "color", NULL, "%_wool", NULL, NULL },
+    { "carpet", "color", NULL, "%_carpet", NULL, NULL },
+    { "concrete", "color", NULL, "%_concrete", NULL, NULL },
+    { "stained_glass", "color", NULL, "%_stained_glass", NULL, NULL },
+    { "stained_glass_pane", "color", NULL, "%_stained_glass_pane", NULL, NULL },
+    { "stained_hardened_clay", "color", NULL, "%_terracotta", NULL, NULL },
+    { "shulker_box", "color", NULL, "%_shulker_box", NULL, NULL },
+    { "planks", "wood_type", NULL, "%_planks", NULL, NULL },
+    { "fence", "wood_type", NULL, "%_fence", NULL, NULL },
+    { "wooden_slab", "wood_type", NULL, "%_slab", NULL, NULL },
+    { "sapling", "sapling_type", NULL, "%_sapling", NULL, NULL },
+    { "log", "old_log_type", NULL, "%_log", NULL, NULL },
+    { "log2", "new_log_type", NULL, "%_log", NULL, NULL },
+    { "leaves", "old_leaf_type", NULL, "%_leaves", NULL, NULL },
+    { "leaves2", "new_leaf_type", NULL, "%_leaves", NULL, NULL },
+    { "stone", "stone_type", "granite", "granite", NULL, NULL },
+    { "stone", "stone_type", "granite_smooth", "polished_granite", NULL, NULL },
+    { "stone", "stone_type", "diorite", "diorite", NULL, NULL },
+    { "stone", "stone_type", "diorite_smooth", "polished_diorite", NULL, NULL },
+    { "stone", "stone_type", "andesite", "andesite", NULL, NULL },
+    { "stone", "stone_type", "andesite_smooth", "polished_andesite", NULL, NULL },
+    { "dirt", "dirt_type", "coarse", "coarse_dirt", NULL, NULL },
+    { "sand", "sand_type", "red", "red_sand", NULL, NULL },
+    { "sandstone", "sand_stone_type", "heiroglyphs", "chiseled_sandstone", NULL, NULL },
+    { "sandstone", "sand_stone_type", "cut", "cut_sandstone", NULL, NULL },
+    { "sandstone", "sand_stone_type", "smooth", "smooth_sandstone", NULL, NULL },
+    { "red_sandstone", "sand_stone_type", "heiroglyphs", "chiseled_red_sandstone", NULL, NULL },
+    { "red_sandstone", "sand_stone_type", "cut", "cut_red_sandstone", NULL, NULL },
+    { "red_sandstone", "sand_stone_type", "smooth", "smooth_red_sandstone", NULL, NULL },
+    { "stonebrick", "stone_brick_type", "default", "stone_bricks", NULL, NULL },
+    { "stonebrick", "stone_brick_type", "mossy", "mossy_stone_bricks", NULL, NULL },
+    { "stonebrick", "stone_brick_type", "cracked", "cracked_stone_bricks", NULL, NULL },
+    { "stonebrick", "stone_brick_type", "chiseled", "chiseled_stone_bricks", NULL, NULL },
+    { "prismarine", "prismarine_block_type", "default", "prismarine", NULL, NULL },
+    { "prismarine", "prismarine_block_type", "dark", "dark_prismarine", NULL, NULL },
+    { "prismarine", "prismarine_block_type", "bricks", "prismarine_bricks", NULL, NULL },
+    { "quartz_block", "chisel_type", "chiseled", "chiseled_quartz_block", NULL, NULL },
+    { "quartz_block", "chisel_type", "lines", "quartz_pillar", NULL, NULL },
+    { "quartz_block", "chisel_type", "smooth", "smooth_quartz", NULL, NULL },
+    { "purpur_block", "chisel_type", "lines", "purpur_pillar", NULL, NULL },
+    { "sponge", "sponge_type", "wet", "wet_sponge", NULL, NULL },
+    { "tallgrass", "tall_grass_type", "fern", "fern", NULL, NULL },
+    { "tallgrass", "tall_grass_type", "default", "short_grass", NULL, NULL },
+    { "tallgrass", "tall_grass_type", "tall", "short_grass", NULL, NULL },
+    { "red_flower", "flower_type", "poppy", "poppy", NULL, NULL },
+    { "red_flower", "flower_type", "orchid", "blue_orchid", NULL, NULL },
+    { "red_flower", "flower_type", "allium", "allium", NULL, NULL },
+    { "red_flower", "flower_type", "houstonia", "azure_bluet", NULL, NULL },
+    { "red_flower", "flower_type", "tulip_red", "red_tulip", NULL, NULL },
+    { "red_flower", "flower_type", "tulip_orange", "orange_tulip", NULL, NULL },
+    { "red_flower", "flower_type", "tulip_white", "white_tulip", NULL, NULL },
+    { "red_flower", "flower_type", "tulip_pink", "pink_tulip", NULL, NULL },
+    { "red_flower", "flower_type", "oxeye", "oxeye_daisy", NULL, NULL },
+    { "red_flower", "flower_type", "cornflower", "cornflower", NULL, NULL },
+    { "red_flower", "flower_type", "lily_of_the_valley", "lily_of_the_valley", NULL, NULL },
+    { "double_plant", "double_plant_type", "sunflower", "sunflower", NULL, NULL },
+    { "double_plant", "double_plant_type", "syringa", "lilac", NULL, NULL },
+    { "double_plant", "double_plant_type", "grass", "tall_grass", NULL, NULL },
+    { "double_plant", "double_plant_type", "fern", "large_fern", NULL, NULL },
+    { "double_plant", "double_plant_type", "rose", "rose_bush", NULL, NULL },
+    { "double_plant", "double_plant_type", "paeonia", "peony", NULL, NULL },
+    { "monster_egg", "monster_egg_stone_type", "stone", "infested_stone", NULL, NULL },
+    { "monster_egg", "monster_egg_stone_type", "cobblestone", "infested_cobblestone", NULL, NULL },
+    { "monster_egg", "monster_egg_stone_type", "stone_brick", "infested_stone_bricks", NULL, NULL },
+    { "monster_egg", "monster_egg_stone_type", "mossy_stone_brick", "infested_mossy_stone_bricks", NULL, NULL },
+    { "monster_egg", "monster_egg_stone_type", "cracked_stone_brick", "infested_cracked_stone_bricks", NULL, NULL },
+    { "monster_egg", "monster_egg_stone_type", "chiseled_stone_brick", "infested_chiseled_stone_bricks", NULL, NULL },
+    { "cobblestone_wall", "wall_block_type", "cobblestone", "cobblestone_wall", NULL, NULL },
+    { "cobblestone_wall", "wall_block_type", "mossy_cobblestone", "mossy_cobblestone_wall", NULL, NULL },
+    { "anvil", "damage", "slightly_damaged", "chipped_anvil", NULL, NULL },
+    { "anvil", "damage", "very_damaged", "damaged_anvil", NULL, NULL },
+    { "stone_block_slab", "stone_slab_type", "smooth_stone", "smooth_stone_slab", NULL, NULL },
+    { "stone_block_slab", "stone_slab_type", "sandstone", "sandstone_slab", NULL, NULL },
+    { "stone_block_slab", "stone_slab_type", "wood", "petrified_oak_slab", NULL, NULL },
+    { "stone_block_slab", "stone_slab_type", "cobblestone", "cobblestone_slab", NULL, NULL },
+    { "stone_block_slab", "stone_slab_type", "brick", "brick_slab", NULL, NULL },
+    { "stone_block_slab", "stone_slab_type", "stone_brick", "stone_brick_slab", NULL, NULL },
+    { "stone_block_slab", "stone_slab_type", "quartz", "quartz_slab", NULL, NULL },
+    { "stone_block_slab", "stone_slab_type", "nether_brick", "nether_brick_slab", NULL, NULL },
+    { "double_stone_block_slab", "stone_slab_type", "smooth_stone", "smooth_stone_slab", "type", "double" },
+    { "double_stone_block_slab", "stone_slab_type", "sandstone", "sandstone_slab", "type", "double" },
+    { "double_stone_block_slab", "stone_slab_type", "cobblestone", "cobblestone_slab", "type", "double" },
+    { "double_stone_block_slab", "stone_slab_type", "brick", "brick_slab", "type", "double" },
+    { "double_stone_block_slab", "stone_slab_type", "stone_brick", "stone_brick_slab", "type", "double" },
+    { "double_stone_block_slab", "stone_slab_type", "quartz", "quartz_slab", "type", "double" },
+    { "double_stone_block_slab", "stone_slab_type", "nether_brick", "nether_brick_slab", "type", "double" },
+};
+
+// Bedrock color names that differ from Java's
+static const char* gBedrockColors[][2] = {
+    { "silver", "light_gray" },
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// States
+
+#define BS_RENAME       0   // same value, Java key
+#define BS_BOOL         1   // 0 or 1 to false or true
+#define BS_TWO_VALUES   2   // 0 or 1 to javaValues[0] or [1]
+#define BS_NUMBER       3   // number plus offset
+#define BS_ENUM         4   // number indexes javaValues
+#define BS_DATA_BITS    5   // already Mineways data bits: (number & offset) goes straight into dataVal
+
+typedef struct BedrockStateRule {
+    const char* bedrockKey;
+    const char* javaKey;
+    int kind;               // BS_*
+    int offset;             // BS_NUMBER: added; BS_DATA_BITS: mask
+    const char* javaValues[10];
+} BedrockStateRule;
+
+static const BedrockStateRule gBedrockStateRules[] = {
+    { "pillar_axis", "axis", BS_RENAME, 0, {} },
+    { "minecraft:cardinal_direction", "facing", BS_RENAME, 0, {} },
+    { "minecraft:facing_direction", "facing", BS_RENAME, 0, {} },
+    { "minecraft:block_face", "facing", BS_RENAME, 0, {} },
+    { "minecraft:vertical_half", "type", BS_RENAME, 0, {} },
+    { "structure_block_type", "mode", BS_RENAME, 0, {} },
+    { "attachment", "attachment", BS_RENAME, 0, {} },
+    { "open_bit", "open", BS_BOOL, 0, {} },
+    { "powered_bit", "powered", BS_BOOL, 0, {} },
+    { "button_pressed_bit", "powered", BS_BOOL, 0, {} },
+    { "rail_data_bit", "powered", BS_BOOL, 0, {} },
+    { "output_lit_bit", "powered", BS_BOOL, 0, {} },
+    { "in_wall_bit", "in_wall", BS_BOOL, 0, {} },
+    { "occupied_bit", "occupied", BS_BOOL, 0, {} },
+    { "persistent_bit", "persistent", BS_BOOL, 0, {} },
+    { "attached_bit", "attached", BS_BOOL, 0, {} },
+    { "disarmed_bit", "disarmed", BS_BOOL, 0, {} },
+    { "hanging", "hanging", BS_BOOL, 0, {} },
+    { "lit", "lit", BS_BOOL, 0, {} },
+    { "extinguished", "lit", BS_TWO_VALUES, 0, { "true", "false" } },
+    { "end_portal_eye_bit", "eye", BS_BOOL, 0, {} },
+    { "upside_down_bit", "half", BS_TWO_VALUES, 0, { "bottom", "top" } },
+    { "top_slot_bit", "type", BS_TWO_VALUES, 0, { "bottom", "top" } },
+    { "upper_block_bit", "half", BS_TWO_VALUES, 0, { "lower", "upper" } },
+    { "head_piece_bit", "part", BS_TWO_VALUES, 0, { "foot", "head" } },
+    { "door_hinge_bit", "hinge", BS_TWO_VALUES, 0, { "left", "right" } },
+    { "output_subtract_bit", "mode", BS_TWO_VALUES, 0, { "compare", "subtract" } },
+    { "growth", "age", BS_NUMBER, 0, {} },
+    { "age", "age", BS_NUMBER, 0, {} },
+    { "liquid_depth", "level", BS_NUMBER, 0, {} },
+    { "redstone_signal", "power", BS_NUMBER, 0, {} },
+    { "moisturized_amount", "moisture", BS_NUMBER, 0, {} },
+    { "bite_counter", "bites", BS_NUMBER, 0, {} },
+    { "ground_sign_direction", "rotation", BS_NUMBER, 0, {} },
+    { "height", "layers", BS_NUMBER, 1, {} },
+    { "repeater_delay", "delay", BS_NUMBER, 1, {} },
+    { "cluster_count", "pickles", BS_NUMBER, 1, {} },
+    { "candles", "candles", BS_NUMBER, 1, {} },
+    { "facing_direction", "facing", BS_ENUM, 0, { "down", "up", "north", "south", "west", "east" } },
+    { "direction", "facing", BS_ENUM, 0, { "south", "west", "north", "east" } },
+    { "weirdo_direction", "facing", BS_ENUM, 0, { "east", "west", "south", "north" } },
+    { "rail_direction", "shape", BS_ENUM, 0, { "north_south", "east_west", "ascending_east", "ascending_west", "ascending_north",
+        "ascending_south", "south_east", "south_west", "north_west", "north_east" } },
+    { "vine_direction_bits", NULL, BS_DATA_BITS, 0xf, {} },
+};
+
+// doors count direction from east rather than south
+static const char* gBedrockDoorDirection[4] = { "east", "south", "west", "north" };
+
+////////////////////////////////////////////////////////////////////////////////
+// Lookup tables, made on first use
+
+typedef struct BedrockTables {
+    // bedrock name to the gBedrockNames entries for it, in table order
+    std::unordered_map<std::string, std::vector<int>> names;
+    std::unordered_map<std::string, int> rules;
+} BedrockTables;
+
+static const BedrockTables& getBedrockTables()
+{
+    static BedrockTables* tables = NULL;
+    static bool built = [] {
+        tables = new BedrockTables;
+        for (int i = 0; i < (int)(sizeof(gBedrockNames) / sizeof(gBedrockNames[0])); i++) {
+            tables->names[gBedrockNames[i].bedrockName].push_back(i);
+        }
+        for (int i = 0; i < (int)(sizeof(gBedrockStateRules) / sizeof(gBedrockStateRules[0])); i++) {
+            tables->rules[gBedrockStateRules[i].bedrockKey] = i;
+        }
+        return true;
+    }();
+    (void)built;
+    return *tables;
+}
+
+static bool stateIs(const BedrockState& state, const char* key)
+{
+    return (int)strlen(key) == state.keyLength && strncmp(state.key, key, state.keyLength) == 0;
+}
+
+static bool stringIs(const BedrockState& state, const char* value)
+{
+    return state.string != NULL && (int)strlen(value) == state.stringLength && strncmp(state.string, value, state.stringLength) == 0;
+}
+
+// The Java name for a Bedrock one, which is the same name unless gBedrockNames says otherwise,
+// and the gBedrockNames entry used, or NULL
+static std::string getJavaName(const std::string& bedrockName, const BedrockState* states, int count, const BedrockName*& used)
+{
+    const BedrockTables& tables = getBedrockTables();
+    used = NULL;
+    std::unordered_map<std::string, std::vector<int>>::const_iterator it = tables.names.find(bedrockName);
+    if (it == tables.names.end()) {
+        return bedrockName;
+    }
+    for (size_t e = 0; e < it->second.size(); e++) {
+        const BedrockName& bn = gBedrockNames[it->second[e]];
+        if (bn.stateKey == NULL) {
+            used = &bn;
+            return bn.javaName;
+        }
+        for (int s = 0; s < count; s++) {
+            if (!stateIs(states[s], bn.stateKey) || states[s].string == NULL) {
+                continue;
+            }
+            if (bn.javaName[0] == '%') {
+                std::string value(states[s].string, states[s].stringLength);
+                for (size_t c = 0; c < sizeof(gBedrockColors) / sizeof(gBedrockColors[0]); c++) {
+                    if (value == gBedrockColors[c][0]) {
+                        value = gBedrockColors[c][1];
+                    }
+                }
+                used = &bn;
+                return value + (bn.javaName + 1);
+            }
+            if (stringIs(states[s], bn.stateValue)) {
+                used = &bn;
+                return bn.javaName;
+            }
+        }
+    }
+    return bedrockName;
+}
+
+bool translateBedrockState(const char* name, int nameLength, const BedrockState* states, int count, int& type, int& dataVal)
+{
+    if (nameLength >= 10 && strncmp(name, "minecraft:", 10) == 0) {
+        name += 10;
+        nameLength -= 10;
+    }
+    const BedrockName* bedrockName;
+    std::string javaName = getJavaName(std::string(name, nameLength), states, count, bedrockName);
+    bool isDoor = javaName.size() > 5 && javaName.compare(javaName.size() - 5, 5, "_door") == 0;
+
+    const BedrockTables& tables = getBedrockTables();
+    int keys[MAX_BEDROCK_STATES];
+    int values[MAX_BEDROCK_STATES];
+    int propertyCount = 0;
+    int dataBits = 0;
+    for (int s = 0; s < count && propertyCount < MAX_BEDROCK_STATES; s++) {
+        std::unordered_map<std::string, int>::const_iterator it = tables.rules.find(std::string(states[s].key, states[s].keyLength));
+        if (it == tables.rules.end()) {
+            continue;
+        }
+        const BedrockStateRule& rule = gBedrockStateRules[it->second];
+        const BedrockState& state = states[s];
+        int value = -1;
+        char number[16];
+        switch (rule.kind) {
+        case BS_RENAME:
+            if (state.string != NULL) {
+                value = findPropertyValue(state.string, state.stringLength);
+            }
+            else {
+                value = findPropertyValue(number, sprintf_s(number, 16, "%d", state.number));
+            }
+            break;
+        case BS_BOOL:
+            value = state.number ? PV_TRUE : PV_FALSE;
+            break;
+        case BS_TWO_VALUES:
+            value = findPropertyValue(rule.javaValues[state.number ? 1 : 0], (int)strlen(rule.javaValues[state.number ? 1 : 0]));
+            break;
+        case BS_NUMBER:
+            value = findPropertyValue(number, sprintf_s(number, 16, "%d", state.number + rule.offset));
+            break;
+        case BS_ENUM:
+        {
+            const char* const* list = rule.javaValues;
+            int listLength = 0;
+            if (isDoor && stateIs(state, "direction")) {
+                list = gBedrockDoorDirection;
+                listLength = 4;
+            }
+            else {
+                while (listLength < 10 && list[listLength] != NULL) {
+                    listLength++;
+                }
+            }
+            if (state.number >= 0 && state.number < listLength) {
+                value = findPropertyValue(list[state.number], (int)strlen(list[state.number]));
+            }
+            break;
+        }
+        case BS_DATA_BITS:
+            dataBits |= state.number & rule.offset;
+            continue;
+        }
+        keys[propertyCount] = findPropertyKey(rule.javaKey, (int)strlen(rule.javaKey));
+        values[propertyCount] = value;
+        propertyCount++;
+    }
+    if (bedrockName != NULL && bedrockName->javaKey != NULL && propertyCount < MAX_BEDROCK_STATES) {
+        keys[propertyCount] = findPropertyKey(bedrockName->javaKey, (int)strlen(bedrockName->javaKey));
+        values[propertyCount] = findPropertyValue(bedrockName->javaValue, (int)strlen(bedrockName->javaValue));
+        propertyCount++;
+    }
+    if (!packBlockState(javaName.c_str(), (int)javaName.length(), keys, values, propertyCount, type, dataVal)) {
+        return false;
+    }
+    dataVal |= dataBits;
+    return true;
+}
+
+bool translateBedrockPaletteEntry(const NbtView& view, const NbtTag& entry, int& type, int& dataVal)
+{
+    NbtTag nameTag, statesTag, stateTag;
+    const char* name;
+    int nameLength;
+    if (!nbtFindChild(view, entry, "name", nameTag) || !nbtGetString(view, nameTag, name, nameLength)) {
+        return false;
+    }
+    BedrockState states[MAX_BEDROCK_STATES];
+    int count = 0;
+    NbtIterator it;
+    if (nbtFindChild(view, entry, "states", statesTag) && nbtIterate(view, statesTag, it)) {
+        while (count < MAX_BEDROCK_STATES && nbtNext(view, it, stateTag)) {
+            BedrockState& state = states[count];
+            state.key = stateTag.name;
+            state.keyLength = stateTag.nameLength;
+            state.string = NULL;
+            state.stringLength = 0;
+            state.number = 0;
+            if (stateTag.type == NBT_TAG_STRING) {
+                nbtGetString(view, stateTag, state.string, state.stringLength);
+            }
+            else {
+                state.number = nbtGetInt(view, stateTag);
+            }
+            count++;
+        }
+    }
+
+    // the whole entry, as "bedrock:name[key=value,...]", is the cache key; the prefix keeps it apart from Java states
+    char key[BLOCK_STATE_KEY_MAX];
+    int keyLength = -1;
+    {
+        std::string fullName = "bedrock:" + std::string(name, nameLength);
+        std::string stateKeys[MAX_BEDROCK_STATES];
+        std::string stateValues[MAX_BEDROCK_STATES];
+        const char* keyPointers[MAX_BEDROCK_STATES];
+        const char* valuePointers[MAX_BEDROCK_STATES];
+        for (int s = 0; s < count; s++) {
+            stateKeys[s].assign(states[s].key, states[s].keyLength);
+            stateValues[s] = states[s].string ? std::string(states[s].string, states[s].stringLength) : std::to_string(states[s].number);
+            keyPointers[s] = stateKeys[s].c_str();
+            valuePointers[s] = stateValues[s].c_str();
+        }
+        keyLength = makeBlockStateKey(fullName.c_str(), count, keyPointers, valuePointers, key, BLOCK_STATE_KEY_MAX);
+    }
+    BlockStateCache* cache = getPaletteStateCache();
+    unsigned short cachedType;
+    unsigned char cachedData;
+    if (keyLength > 0 && cache != NULL && findBlockState(cache, key, keyLength, cachedType, cachedData)) {
+        type = cachedType;
+        dataVal = cachedData;
+        return true;
+    }
+
+    if (nameLength >= 10 && strncmp(name, "minecraft:", 10) == 0) {
+        name += 10;
+        nameLength -= 10;
+    }
+    UnknownBlockLog* log = getSessionUnknownBlockLog();
+    if (isUnknownBlock(log, name, nameLength)) {
+        return false;
+    }
+    if (!translateBedrockState(name, nameLength, states, count, type, dataVal)) {
+        addUnknownBlock(log, name, nameLength);
+        return false;
+    }
+    if (keyLength > 0 && cache != NULL) {
+        addBlockState(cache, key, keyLength, (unsigned short)type, (unsigned char)dataVal);
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+// bedrockTranslations.h - Bedrock block names and states to Mineways types and data values, next to the Java BlockTranslations
+
+#pragma once
+
+#include "nbtView.h"
+
+// Bedrock palette entries are {name, states}. Most names are now the same as Java's; older ones differ
+// ("melon_block", "snow_layer") or pick the block by a state ("wool" with color=red). States are renamed
+// and converted to the Java properties they stand for (pillar_axis to axis, upside_down_bit to half,
+// direction 0-3 to facing), and the result goes through the same table as Java palettes, packBlockState()
+// (propertyParser.h). A few states, such as vine_direction_bits, are already Mineways data bits and are
+// used as is. States not listed are left at their default, as Java properties Mineways ignores are.
+
+// one entry of a states compound
+typedef struct BedrockState {
+    const char* key;
+    int keyLength;
+    const char* string;     // for string states; NULL for numbers and bytes
+    int stringLength;
+    int number;
+} BedrockState;
+
+// Returns true with the type and data value, false if the name is not known.
+bool translateBedrockState(const char* name, int nameLength, const BedrockState* states, int count, int& type, int& dataVal);
+
+// A palette entry compound, as in .mcstructure files and Bedrock worlds. The result is remembered in a
+// block-state cache (blockStateCache.h) keyed by the whole entry, and unknown names go to the session's
+// unknown-block log (unknownBlocks.h), as for Java palettes.
+bool translateBedrockPaletteEntry(const NbtView& view, const NbtTag& entry, int& type, int& dataVal);
@@ -0,0 +1,710 @@
+// blockCompress.cpp - CPU block compression (BC1, BC3, BC7) of exported texture atlases, saved as DDS or KTX2
+//
+// The encoders are simple "principal axis" fitters: find the main direction of the 16 colors in the block,
+// put the endpoints at its extremes, and pick the nearest palette entry for each pixel. This is far from the
+// best possible quality, but it is fast, runs offline, and is plenty for Minecraft's blocky textures.
+
+#include "stdafx.h"
+#include <assert.h>
+#include <math.h>
+#include <atomic>
+#include <thread>
+#include "portafile.h"
+#include "tiles.h"
+#include "blockCompress.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+int bcBlockBytes(int format)
+{
+    return (format == BC_FORMAT_BC1) ? 8 : 16;
+}
+
+///////////////////////////////////////////////////////////////////
+// Shared fitting code
+
+// Find the mean and main axis of count points of dims (3 or 4) channels, by power iteration on the covariance matrix.
+static void principalAxis(const float(*pts)[4], int count, int dims, float mean[4], float axis[4])
+{
+    int i, c, r;
+    for (c = 0; c < 4; c++) {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+    if (count == 0) {
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        for (c = 0; c < dims; c++) {
+            mean[c] += pts[i][c];
+        }
+    }
+    for (c = 0; c < dims; c++) {
+        mean[c] /= (float)count;
+    }
+    float cov[4][4];
+    memset(cov, 0, sizeof(cov));
+    for (i = 0; i < count; i++) {
+        float d[4];
+        for (c = 0; c < dims; c++) {
+            d[c] = pts[i][c] - mean[c];
+        }
+        for (r = 0; r < dims; r++) {
+            for (c = 0; c < dims; c++) {
+                cov[r][c] += d[r] * d[c];
+            }
+        }
+    }
+    float v[4] = { 1.0f, 1.0f, 1.0f, (dims == 4) ? 1.0f : 0.0f };
+    for (int iter = 0; iter < 8; iter++) {
+        float nv[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float len = 0.0f;
+        for (r = 0; r < dims; r++) {
+            for (c = 0; c < dims; c++) {
+                nv[r] += cov[r][c] * v[c];
+            }
+            len += nv[r] * nv[r];
+        }
+        if (len < 1e-12f) {
+            // all points the same (or nearly), any axis will do
+            break;
+        }
+        len = 1.0f / sqrtf(len);
+        for (c = 0; c < dims; c++) {
+            v[c] = nv[c] * len;
+        }
+    }
+    for (c = 0; c < dims; c++) {
+        axis[c] = v[c];
+    }
+}
+
+// endpoints at the extremes of the points' projections onto the axis
+static void fitEndpoints(const float(*pts)[4], int count, int dims, float e0[4], float e1[4])
+{
+    float mean[4], axis[4];
+    principalAxis(pts, count, dims, mean, axis);
+    float tmin = 0.0f, tmax = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < dims; c++) {
+            t += (pts[i][c] - mean[c]) * axis[c];
+        }
+        if (i == 0 || t < tmin) tmin = t;
+        if (i == 0 || t > tmax) tmax = t;
+    }
+    for (int c = 0; c < 4; c++) {
+        e0[c] = mean[c] + axis[c] * tmin;
+        e1[c] = mean[c] + axis[c] * tmax;
+    }
+}
+
+static inline int clampInt(int v, int lo, int hi)
+{
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+static int colorDistance(const unsigned char* a, const int* b, int dims)
+{
+    int dist = 0;
+    for (int c = 0; c < dims; c++) {
+        int d = (int)a[c] - b[c];
+        dist += d * d;
+    }
+    return dist;
+}
+
+// LSB-first bit packing, as BC7 wants
+static void putBits(unsigned char* out, int& pos, unsigned int value, int count)
+{
+    for (int i = 0; i < count; i++, pos++) {
+        if ((value >> i) & 1) {
+            out[pos >> 3] |= (unsigned char)(1 << (pos & 7));
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////
+// BC1 color block, also used as the color half of BC3
+
+static inline int expand565(int v, int bits)
+{
+    return (bits == 5) ? ((v << 3) | (v >> 2)) : ((v << 2) | (v >> 4));
+}
+
+static unsigned short quantize565(const float e[4])
+{
+    int r = clampInt((int)(e[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = clampInt((int)(e[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = clampInt((int)(e[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+// pixels are RGBA; if allowTransparent, pixels with alpha < 128 use the 3-color mode's transparent index
+static void encodeColorBlock(const unsigned char* pixels, bool allowTransparent, unsigned char* out)
+{
+    float pts[16][4];
+    int count = 0;
+    bool hasTransparent = false;
+    int i;
+    for (i = 0; i < 16; i++) {
+        if (allowTransparent && pixels[i * 4 + 3] < 128) {
+            hasTransparent = true;
+        }
+        else {
+            for (int c = 0; c < 4; c++) {
+                pts[count][c] = (float)pixels[i * 4 + c];
+            }
+            count++;
+        }
+    }
+
+    unsigned short c0 = 0, c1 = 0;
+    if (count > 0) {
+        float e0[4], e1[4];
+        fitEndpoints(pts, count, 3, e0, e1);
+        c0 = quantize565(e1);
+        c1 = quantize565(e0);
+    }
+    // c0 > c1 selects 4-color mode, c0 <= c1 the 3-color + transparent mode
+    if ((hasTransparent && c0 > c1) || (!hasTransparent && c0 < c1)) {
+        unsigned short swap = c0;
+        c0 = c1;
+        c1 = swap;
+    }
+
+    int palette[4][3];
+    int entries = (c0 > c1) ? 4 : 3;
+    palette[0][0] = expand565(c0 >> 11, 5); palette[0][1] = expand565((c0 >> 5) & 0x3f, 6); palette[0][2] = expand565(c0 & 0x1f, 5);
+    palette[1][0] = expand565(c1 >> 11, 5); palette[1][1] = expand565((c1 >> 5) & 0x3f, 6); palette[1][2] = expand565(c1 & 0x1f, 5);
+    for (int c = 0; c < 3; c++) {
+        if (entries == 4) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    unsigned int indices = 0;
+    for (i = 0; i < 16; i++) {
+        int best = 0;
+        if (hasTransparent && pixels[i * 4 + 3] < 128) {
+            best = 3;
+        }
+        else {
+            int bestDist = colorDistance(&pixels[i * 4], palette[0], 3);
+            for (int p = 1; p < entries; p++) {
+                int dist = colorDistance(&pixels[i * 4], palette[p], 3);
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+        }
+        indices |= (unsigned int)best << (i * 2);
+    }
+
+    out[0] = (unsigned char)(c0 & 0xff);
+    out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xff);
+    out[3] = (unsigned char)(c1 >> 8);
+    for (i = 0; i < 4; i++) {
+        out[4 + i] = (unsigned char)(indices >> (i * 8));
+    }
+}
+
+///////////////////////////////////////////////////////////////////
+// BC3 alpha block: two 8-bit endpoints, 3-bit indices
+
+static void encodeAlphaBlock(const unsigned char* pixels, unsigned char* out)
+{
+    int amin = 255, amax = 0, i;
+    for (i = 0; i < 16; i++) {
+        int a = pixels[i * 4 + 3];
+        if (a < amin) amin = a;
+        if (a > amax) amax = a;
+    }
+    // a0 > a1 gives the 8-value mode: index 0 is a0, 1 is a1, 2-7 step from a0 toward a1
+    out[0] = (unsigned char)amax;
+    out[1] = (unsigned char)amin;
+    unsigned long long bits = 0;
+    if (amax > amin) {
+        for (i = 0; i < 16; i++) {
+            int k = ((amax - pixels[i * 4 + 3]) * 7 + (amax - amin) / 2) / (amax - amin);
+            int index = (k == 0) ? 0 : ((k == 7) ? 1 : k + 1);
+            bits |= (unsigned long long)index << (i * 3);
+        }
+    }
+    for (i = 0; i < 6; i++) {
+        out[2 + i] = (unsigned char)(bits >> (i * 8));
+    }
+}
+
+///////////////////////////////////////////////////////////////////
+// BC7. Only two of the eight modes are used:
+// mode 6 - one subset, RGBA 7.7.7.7 endpoints plus a p-bit each, 4-bit indices. Good for almost everything.
+// mode 5 - RGB 7.7.7 and A8 endpoints with separate 2-bit color and alpha indices. Used for cutout blocks
+//          that are partly transparent, so that alpha can be exactly 0 or 255 whatever the colors are doing.
+
+static const int gBC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+static const int gBC7Weights2[4] = { 0, 21, 43, 64 };
+
+static inline int bc7Interpolate(int e0, int e1, int weight)
+{
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+// quantize an RGBA endpoint to 7 bits per channel plus a shared p-bit, choosing whichever p-bit fits best
+static void quantizeMode6Endpoint(const float e[4], int q[4], int& pbit)
+{
+    int bestErr = 0x7fffffff;
+    for (int p = 0; p < 2; p++) {
+        int tq[4], err = 0;
+        for (int c = 0; c < 4; c++) {
+            tq[c] = clampInt((int)((e[c] - (float)p) * 0.5f + 0.5f), 0, 127);
+            int d = ((tq[c] << 1) | p) - (int)(e[c] + 0.5f);
+            err += d * d;
+        }
+        if (err < bestErr) {
+            bestErr = err;
+            pbit = p;
+            for (int c = 0; c < 4; c++) {
+                q[c] = tq[c];
+            }
+        }
+    }
+}
+
+static void encodeBC7Mode6(const unsigned char* pixels, unsigned char* out)
+{
+    float pts[16][4];
+    int i, c;
+    for (i = 0; i < 16; i++) {
+        for (c = 0; c < 4; c++) {
+            pts[i][c] = (float)pixels[i * 4 + c];
+        }
+    }
+    float e0[4], e1[4];
+    fitEndpoints(pts, 16, 4, e0, e1);
+
+    int q[2][4], p[2];
+    quantizeMode6Endpoint(e0, q[0], p[0]);
+    quantizeMode6Endpoint(e1, q[1], p[1]);
+
+    int palette[16][4];
+    for (i = 0; i < 16; i++) {
+        for (c = 0; c < 4; c++) {
+            palette[i][c] = bc7Interpolate((q[0][c] << 1) | p[0], (q[1][c] << 1) | p[1], gBC7Weights4[i]);
+        }
+    }
+    int indices[16];
+    for (i = 0; i < 16; i++) {
+        int best = 0, bestDist = colorDistance(&pixels[i * 4], palette[0], 4);
+        for (int k = 1; k < 16; k++) {
+            int dist = colorDistance(&pixels[i * 4], palette[k], 4);
+            if (dist < bestDist) {
+                bestDist = dist;
+                best = k;
+            }
+        }
+        indices[i] = best;
+    }
+    // the first pixel's index is stored with its top bit implied zero, so swap endpoints if needed
+    if (indices[0] & 0x8) {
+        for (c = 0; c < 4; c++) {
+            int swap = q[0][c];
+            q[0][c] = q[1][c];
+            q[1][c] = swap;
+        }
+        int swap = p[0];
+        p[0] = p[1];
+        p[1] = swap;
+        for (i = 0; i < 16; i++) {
+            indices[i] = 15 - indices[i];
+        }
+    }
+
+    memset(out, 0, 16);
+    int pos = 0;
+    putBits(out, pos, 1 << 6, 7);
+    for (c = 0; c < 4; c++) {
+        putBits(out, pos, q[0][c], 7);
+        putBits(out, pos, q[1][c], 7);
+    }
+    putBits(out, pos, p[0], 1);
+    putBits(out, pos, p[1], 1);
+    putBits(out, pos, indices[0], 3);
+    for (i = 1; i < 16; i++) {
+        putBits(out, pos, indices[i], 4);
+    }
+    assert(pos == 128);
+}
+
+// alpha must already be snapped to 0 or 255
+static void encodeBC7Mode5Cutout(const unsigned char* pixels, unsigned char* out)
+{
+    float pts[16][4];
+    int i, c, count = 0;
+    for (i = 0; i < 16; i++) {
+        if (pixels[i * 4 + 3]) {
+            for (c = 0; c < 4; c++) {
+                pts[count][c] = (float)pixels[i * 4 + c];
+            }
+            count++;
+        }
+    }
+    float e0[4], e1[4];
+    fitEndpoints(pts, count, 3, e0, e1);
+    int q[2][3];
+    for (c = 0; c < 3; c++) {
+        q[0][c] = clampInt((int)(e0[c] * 127.0f / 255.0f + 0.5f), 0, 127);
+        q[1][c] = clampInt((int)(e1[c] * 127.0f / 255.0f + 0.5f), 0, 127);
+    }
+    int palette[4][3];
+    for (i = 0; i < 4; i++) {
+        for (c = 0; c < 3; c++) {
+            palette[i][c] = bc7Interpolate((q[0][c] << 1) | (q[0][c] >> 6), (q[1][c] << 1) | (q[1][c] >> 6), gBC7Weights2[i]);
+        }
+    }
+    int colorIndex[16], alphaIndex[16];
+    // first pixel's alpha is endpoint 0, so its alpha index is 0 and no swap is ever needed for alpha
+    int a0 = pixels[3];
+    for (i = 0; i < 16; i++) {
+        int best = 0, bestDist = colorDistance(&pixels[i * 4], palette[0], 3);
+        for (int k = 1; k < 4; k++) {
+            int dist = colorDistance(&pixels[i * 4], palette[k], 3);
+            if (dist < bestDist) {
+                bestDist = dist;
+                best = k;
+            }
+        }
+        colorIndex[i] = best;
+        alphaIndex[i] = (pixels[i * 4 + 3] == a0) ? 0 : 3;
+    }
+    if (colorIndex[0] & 0x2) {
+        for (c = 0; c < 3; c++) {
+            int swap = q[0][c];
+            q[0][c] = q[1][c];
+            q[1][c] = swap;
+        }
+        for (i = 0; i < 16; i++) {
+            colorIndex[i] = 3 - colorIndex[i];
+        }
+    }
+
+    memset(out, 0, 16);
+    int pos = 0;
+    putBits(out, pos, 1 << 5, 6);
+    // rotation: none
+    putBits(out, pos, 0, 2);
+    for (c = 0; c < 3; c++) {
+        putBits(out, pos, q[0][c], 7);
+        putBits(out, pos, q[1][c], 7);
+    }
+    putBits(out, pos, a0, 8);
+    putBits(out, pos, 255 - a0, 8);
+    putBits(out, pos, colorIndex[0], 1);
+    for (i = 1; i < 16; i++) {
+        putBits(out, pos, colorIndex[i], 2);
+    }
+    putBits(out, pos, alphaIndex[0], 1);
+    for (i = 1; i < 16; i++) {
+        putBits(out, pos, alphaIndex[i], 2);
+    }
+    assert(pos == 128);
+}
+
+///////////////////////////////////////////////////////////////////
+
+void compressBlockBC(int format, const unsigned char* pixels, int alphaMode, unsigned char* out)
+{
+    unsigned char block[64];
+    bool partlyTransparent = false;
+    memcpy(block, pixels, 64);
+    if (alphaMode == BC_ALPHA_CUTOUT) {
+        for (int i = 0; i < 16; i++) {
+            block[i * 4 + 3] = (block[i * 4 + 3] >= 128) ? 255 : 0;
+            partlyTransparent |= (block[i * 4 + 3] == 0);
+        }
+    }
+
+    switch (format) {
+    case BC_FORMAT_BC1:
+        // BC1 has only one bit of alpha anyway
+        encodeColorBlock(block, true, out);
+        break;
+    case BC_FORMAT_BC3:
+        encodeAlphaBlock(block, out);
+        encodeColorBlock(block, false, out + 8);
+        break;
+    default:
+        assert(format == BC_FORMAT_BC7);
+        if (partlyTransparent) {
+            encodeBC7Mode5Cutout(block, out);
+        }
+        else {
+            encodeBC7Mode6(block, out);
+        }
+        break;
+    }
+}
+
+void getTileAlphaModes(unsigned char* alphaModes)
+{
+    memset(alphaModes, BC_ALPHA_KEEP, TOTAL_TILES);
+    for (int i = 0; i < TOTAL_TILES; i++) {
+        if (gTilesTable[i].flags & (SBIT_DECAL | SBIT_CUTOUT_GEOMETRY)) {
+            alphaModes[gTilesTable[i].txrY * 16 + gTilesTable[i].txrX] = BC_ALPHA_CUTOUT;
+        }
+    }
+}
+
+int compressAtlas(const unsigned char* rgba, int width, int height, int tileSize, int format, const unsigned char* alphaModes, int threadCount, CompressedLevel& level)
+{
+    if (format != BC_FORMAT_BC1 && format != BC_FORMAT_BC3 && format != BC_FORMAT_BC7) {
+        return LINE_ERROR;
+    }
+    // a 4x4 block must never cover parts of two tiles, else colors bleed across them
+    if (tileSize <= 0 || (tileSize % 4) != 0 || (width % tileSize) != 0 || (height % tileSize) != 0) {
+        return LINE_ERROR;
+    }
+
+    int tilesPerRow = width / tileSize;
+    unsigned char defaultModes[TOTAL_TILES];
+    if (alphaModes == NULL) {
+        if (tilesPerRow == 16 && height / tileSize <= VERTICAL_TILES) {
+            getTileAlphaModes(defaultModes);
+        }
+        else {
+            memset(defaultModes, BC_ALPHA_KEEP, TOTAL_TILES);
+        }
+        alphaModes = defaultModes;
+    }
+
+    int blockBytes = bcBlockBytes(format);
+    int blocksWide = width / 4;
+    int blocksHigh = height / 4;
+    level.width = width;
+    level.height = height;
+    level.data.assign((size_t)blocksWide * blocksHigh * blockBytes, 0);
+
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+    if (threadCount > blocksHigh) {
+        threadCount = blocksHigh;
+    }
+
+    // threads take block rows from a shared counter; rows all take about the same time
+    std::atomic<int> nextRow(0);
+    auto worker = [&]() {
+        unsigned char pixels[64];
+        int by;
+        while ((by = nextRow++) < blocksHigh) {
+            unsigned char* out = &level.data[(size_t)by * blocksWide * blockBytes];
+            int tileRow = (by * 4) / tileSize;
+            for (int bx = 0; bx < blocksWide; bx++, out += blockBytes) {
+                for (int row = 0; row < 4; row++) {
+                    memcpy(&pixels[row * 16], &rgba[((size_t)(by * 4 + row) * width + bx * 4) * 4], 16);
+                }
+                compressBlockBC(format, pixels, alphaModes[tileRow * tilesPerRow + (bx * 4) / tileSize], out);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////
+// Containers
+
+static void putU32(std::vector<unsigned char>& buf, unsigned int value)
+{
+    for (int i = 0; i < 4; i++) {
+        buf.push_back((unsigned char)(value >> (i * 8)));
+    }
+}
+
+static void putU64(std::vector<unsigned char>& buf, unsigned long long value)
+{
+    putU32(buf, (unsigned int)(value & 0xffffffff));
+    putU32(buf, (unsigned int)(value >> 32));
+}
+
+static void makeDDSHeader(std::vector<unsigned char>& buf, int format, const std::vector<CompressedLevel>& levels)
+{
+    int mipCount = (int)levels.size();
+    buf.insert(buf.end(), { 'D', 'D', 'S', ' ' });
+    putU32(buf, 124);
+    // CAPS | HEIGHT | WIDTH | PIXELFORMAT | LINEARSIZE, plus MIPMAPCOUNT
+    putU32(buf, 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | ((mipCount > 1) ? 0x20000 : 0));
+    putU32(buf, levels[0].height);
+    putU32(buf, levels[0].width);
+    putU32(buf, (unsigned int)levels[0].data.size());
+    putU32(buf, 0);
+    putU32(buf, mipCount);
+    for (int i = 0; i < 11; i++) {
+        putU32(buf, 0);
+    }
+    // pixel format: FOURCC, all formats through the DX10 extension, as the legacy DXT1 and DXT5 codes mean
+    // linear color and the atlas is sRGB, like KTX2's
+    putU32(buf, 32);
+    putU32(buf, 0x4);
+    buf.insert(buf.end(), { 'D', 'X', '1', '0' });
+    for (int i = 0; i < 5; i++) {
+        putU32(buf, 0);
+    }
+    // TEXTURE, plus COMPLEX | MIPMAP
+    putU32(buf, 0x1000 | ((mipCount > 1) ? (0x8 | 0x400000) : 0));
+    for (int i = 0; i < 4; i++) {
+        putU32(buf, 0);
+    }
+    // DX10 extension: DXGI_FORMAT_BC1_UNORM_SRGB, BC3_UNORM_SRGB or BC7_UNORM_SRGB, TEXTURE2D, no flags,
+    // array size 1, straight alpha
+    putU32(buf, (format == BC_FORMAT_BC1) ? 72 : ((format == BC_FORMAT_BC3) ? 78 : 99));
+    putU32(buf, 3);
+    putU32(buf, 0);
+    putU32(buf, 1);
+    putU32(buf, 1);
+}
+
+// the Khronos data format color models, from khr_df.h
+#define KHR_DF_MODEL_BC1A   128
+#define KHR_DF_MODEL_BC3    130
+#define KHR_DF_MODEL_BC7    134
+
+static constexpr int getKTX2ColorModel(int format)
+{
+    return (format == BC_FORMAT_BC1) ? KHR_DF_MODEL_BC1A : ((format == BC_FORMAT_BC3) ? KHR_DF_MODEL_BC3 : KHR_DF_MODEL_BC7);
+}
+
+// checked here, as a loader rejects a descriptor with any other model for the format
+static_assert(getKTX2ColorModel(BC_FORMAT_BC1) == 128, "BC1 must use KHR_DF_MODEL_BC1A");
+static_assert(getKTX2ColorModel(BC_FORMAT_BC3) == 130, "BC3 must use KHR_DF_MODEL_BC3");
+static_assert(getKTX2ColorModel(BC_FORMAT_BC7) == 134, "BC7 must use KHR_DF_MODEL_BC7");
+
+// KTX2 needs a data format descriptor; these are the standard ones for the sRGB BC formats
+static void makeKTX2DataFormatDescriptor(std::vector<unsigned char>& dfd, int format)
+{
+    int samples = (format == BC_FORMAT_BC3) ? 2 : 1;
+    int blockBytes = bcBlockBytes(format);
+    int colorModel = getKTX2ColorModel(format);
+    putU32(dfd, 4 + 24 + 16 * samples);
+    putU32(dfd, 0);
+    putU32(dfd, 2 | ((24 + 16 * samples) << 16));
+    // model, BT.709 primaries, sRGB transfer, straight alpha
+    putU32(dfd, colorModel | (1 << 8) | (2 << 16));
+    // 4x4x1x1 texel block, stored as dimension - 1
+    putU32(dfd, 3 | (3 << 8));
+    putU32(dfd, blockBytes);
+    putU32(dfd, 0);
+    for (int s = 0; s < samples; s++) {
+        int bitOffset = 0, bitLength = blockBytes * 8 - 1, channel = 0;
+        if (format == BC_FORMAT_BC1) {
+            // KHR_DF_CHANNEL_BC1A_ALPHAPRESENT
+            channel = 1;
+        }
+        else if (format == BC_FORMAT_BC3) {
+            // alpha block first, then color: KHR_DF_CHANNEL_BC3_ALPHA, KHR_DF_CHANNEL_BC3_COLOR
+            bitLength = 63;
+            bitOffset = (s == 0) ? 0 : 64;
+            channel = (s == 0) ? 15 : 0;
+        }
+        putU32(dfd, bitOffset | (bitLength << 16) | (channel << 24));
+        putU32(dfd, 0);
+        putU32(dfd, 0);
+        putU32(dfd, 0xffffffff);
+    }
+}
+
+static void makeKTX2(std::vector<unsigned char>& buf, int format, const std::vector<CompressedLevel>& levels)
+{
+    static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    int levelCount = (int)levels.size();
+    int blockBytes = bcBlockBytes(format);
+    // VK_FORMAT_BC1_RGBA_SRGB_BLOCK, BC3_SRGB, BC7_SRGB
+    int vkFormat = (format == BC_FORMAT_BC1) ? 134 : ((format == BC_FORMAT_BC3) ? 138 : 146);
+
+    std::vector<unsigned char> dfd;
+    makeKTX2DataFormatDescriptor(dfd, format);
+
+    // header, index, level index, DFD; then level data, smallest level first, each aligned to the block size
+    size_t dfdOffset = 12 + 9 * 4 + 4 * 4 + 2 * 8 + (size_t)levelCount * 3 * 8;
+    size_t dataOffset = dfdOffset + dfd.size();
+    std::vector<unsigned long long> levelOffset(levelCount);
+    for (int i = levelCount - 1; i >= 0; i--) {
+        dataOffset = (dataOffset + blockBytes - 1) / blockBytes * blockBytes;
+        levelOffset[i] = dataOffset;
+        dataOffset += levels[i].data.size();
+    }
+
+    buf.insert(buf.end(), identifier, identifier + 12);
+    putU32(buf, vkFormat);
+    putU32(buf, 1);     // typeSize
+    putU32(buf, levels[0].width);
+    putU32(buf, levels[0].height);
+    putU32(buf, 0);     // depth
+    putU32(buf, 0);     // layers
+    putU32(buf, 1);     // faces
+    putU32(buf, levelCount);
+    putU32(buf, 0);     // no supercompression
+    putU32(buf, (unsigned int)dfdOffset);
+    putU32(buf, (unsigned int)dfd.size());
+    putU32(buf, 0);     // no key/value data
+    putU32(buf, 0);
+    putU64(buf, 0);     // no supercompression global data
+    putU64(buf, 0);
+    for (int i = 0; i < levelCount; i++) {
+        putU64(buf, levelOffset[i]);
+        putU64(buf, levels[i].data.size());
+        putU64(buf, levels[i].data.size());
+    }
+    buf.insert(buf.end(), dfd.begin(), dfd.end());
+    for (int i = levelCount - 1; i >= 0; i--) {
+        buf.resize((size_t)levelOffset[i], 0);
+        buf.insert(buf.end(), levels[i].data.begin(), levels[i].data.end());
+    }
+}
+
+int writeCompressedAtlas(const wchar_t* filename, int container, int format, const std::vector<CompressedLevel>& levels)
+{
+    if (levels.empty()) {
+        return LINE_ERROR;
+    }
+    std::vector<unsigned char> buf;
+    if (container == BC_CONTAINER_KTX2) {
+        makeKTX2(buf, format, levels);
+    }
+    else {
+        makeDDSHeader(buf, format, levels);
+        for (size_t i = 0; i < levels.size(); i++) {
+            buf.insert(buf.end(), levels[i].data.begin(), levels[i].data.end());
+        }
+    }
+
+    DWORD br;
+    PORTAFILE fh = PortaCreate(filename);
+    if (fh == INVALID_HANDLE_VALUE) {
+        return LINE_ERROR;
+    }
+    if (PortaWrite(fh, buf.data(), (DWORD)buf.size())) {
+        PortaClose(fh);
+        return LINE_ERROR;
+    }
+    PortaClose(fh);
+    return 0;
+}
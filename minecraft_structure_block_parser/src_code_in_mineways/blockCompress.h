@@ -0,0 +1,45 @@
+// blockCompress.h - CPU block compression (BC1, BC3, BC7) of exported texture atlases, saved as DDS or KTX2
+
+#pragma once
+
+#include <vector>
+
+#define BC_FORMAT_BC1   1
+#define BC_FORMAT_BC3   3
+#define BC_FORMAT_BC7   7
+
+#define BC_CONTAINER_DDS    0
+#define BC_CONTAINER_KTX2   1
+
+// How a tile's alpha is compressed. Derived from the tile's gTilesTable flags:
+// SBIT_DECAL and SBIT_CUTOUT_GEOMETRY tiles get their alpha snapped to 0 or 255, so that
+// cutouts stay crisp instead of picking up in-between alphas from block interpolation.
+#define BC_ALPHA_KEEP       0
+#define BC_ALPHA_CUTOUT     1
+
+typedef struct CompressedLevel {
+    int width;      // in pixels
+    int height;
+    std::vector<unsigned char> data;    // blocks, row by row, 4x4 pixels per block
+} CompressedLevel;
+
+// bytes per 4x4 block for the format: 8 for BC1, 16 for the others
+int bcBlockBytes(int format);
+
+// Compress one 4x4 block of RGBA pixels (64 bytes, row by row) to out, bcBlockBytes(format) long.
+void compressBlockBC(int format, const unsigned char* pixels, int alphaMode, unsigned char* out);
+
+// Fill alphaModes (TOTAL_TILES entries, one per tile slot of terrainExt.png, i.e. txrY*16+txrX) with BC_ALPHA_* from gTilesTable.
+void getTileAlphaModes(unsigned char* alphaModes);
+
+// Compress an RGBA atlas laid out like terrainExt.png: tileSize x tileSize tiles, any number per row.
+// tileSize must be a multiple of 4, so that no 4x4 block ever straddles two tiles. Mineways' 18x18 bordered
+// swatches aren't, and are rejected; take their borders off with stripAtlasBorders() (atlasMipmap.h) and
+// compress the 16x16 tiles, leaving the renderer's sampler to clamp or repeat at their edges.
+// alphaModes gives BC_ALPHA_* for each tile, indexed by row*(width/tileSize)+column; pass NULL to
+// use getTileAlphaModes(), which assumes the 16-wide terrainExt.png layout.
+// threadCount of 0 means use all cores. Returns 0 on success, negative on error.
+int compressAtlas(const unsigned char* rgba, int width, int height, int tileSize, int format, const unsigned char* alphaModes, int threadCount, CompressedLevel& level);
+
+// Write the levels (largest first) to a .dds or .ktx2 file, as sRGB in either. Returns 0 on success, negative on error.
+int writeCompressedAtlas(const wchar_t* filename, int container, int format, const std::vector<CompressedLevel>& levels);
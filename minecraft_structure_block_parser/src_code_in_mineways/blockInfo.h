@@ -400,6 +400,7 @@ typedef struct ExportFileData
 } ExportFileData;
 
 // USDA + 5 MDL files + color/normal/MER files
+// This is the worst case; identical tiles are written only once (see tileDedup.h), so usually far fewer are used.
 #define MAX_OUTPUT_FILES (6+5*TOTAL_TILES)
 
 typedef struct FileList {
@@ -534,7 +535,7 @@ That means that if the color is #ffffff, and alpha is 0.5, then the color,alpha,
 // on and off someday.
 typedef struct BlockDefinition {
     const char* name;
-    unsigned int read_color;	// r,g,b, locked in place, never written to: used for initial setting of color for map (and light source emission color)
+    unsigned int read_color;	// r,g,b, from the table, or from the resource pack's tiles by setBlockColorsFromTiles(), which is the only writer; color schemes never change it: used for initial setting of color for map (and light source emission color)
     float read_alpha;
     unsigned int color;	// r,g,b, NOT multiplied by alpha - input by the user, result of color scheme application
     unsigned int pcolor;	// r,g,b, premultiplied by alpha (basically, unmultColor * alpha) - used (only) in mapping
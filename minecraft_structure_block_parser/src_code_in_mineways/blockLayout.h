@@ -0,0 +1,19 @@
+// blockLayout.h - a box of blocks as Mineways types and data values, as made from images and read from structure files
+
+#pragma once
+
+#include <vector>
+
+// Blocks in a box, x fastest, then z, then y, the same order as a Sponge schematic. Type 0 is air.
+typedef struct BlockLayout {
+    int sizeX;
+    int sizeY;
+    int sizeZ;
+    std::vector<unsigned short> type;
+    std::vector<unsigned char> dataVal;
+} BlockLayout;
+
+inline size_t getBlockLayoutIndex(const BlockLayout& layout, int x, int y, int z)
+{
+    return ((size_t)y * layout.sizeZ + z) * layout.sizeX + x;
+}
@@ -0,0 +1,18 @@
+// blockNames.h - go from Mineways' (type, dataVal) back to Minecraft block names; implemented in nbt.cpp, next to BlockTranslations
+
+#pragma once
+
+// The Java name (without "minecraft:") for a block type and data value, or NULL if the type has no name.
+// If no name has exactly this data value, the first name for the type is returned.
+const char* getBlockNameForType(int type, int dataVal);
+
+// The Java block state, "name[key=value,...]" (again without "minecraft:"), with properties sorted by key.
+// Only properties that the data value holds are given, so the rest take Minecraft's defaults; stairs shape
+// and fence connections, for example, come from the neighbors. NULL if the type has no name.
+// Both this and getBlockNameForType() are lookups in a table built the first time either is called.
+const char* getBlockStateForType(int type, int dataVal);
+
+// Entries of BlockTranslations, for writing the table out, e.g. to a block pack (blockPack.h)
+int getBlockTranslationCount();
+// Name of entry i, with its type and data value as IDBlock() would give them, and its *_PROP flags. NULL for an unused entry.
+const char* getBlockTranslation(int i, int& type, int& dataVal, unsigned long& translateFlags);
@@ -0,0 +1,227 @@
+// blockPack.cpp - gBlockDefinitions, BlockTranslations and gTilesTable in one binary file that is used straight from memory
+
+#include "stdafx.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "portafile.h"
+#include "tiles.h"
+#include "blockNames.h"
+#include "blockPack.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// records are written as their structs, so the structs must have no hidden padding
+static_assert(sizeof(BlockPackHeader) == 64, "BlockPackHeader layout changed");
+static_assert(sizeof(PackedBlock) == 24, "PackedBlock layout changed");
+static_assert(sizeof(PackedTranslation) == 12, "PackedTranslation layout changed");
+static_assert(sizeof(PackedTile) == 20, "PackedTile layout changed");
+
+static uint32_t fnv1a(const unsigned char* data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool isLittleEndian()
+{
+    const uint16_t one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+// each distinct string stored once
+class PackStrings {
+public:
+    PackStrings()
+    {
+        data.push_back('\0');
+    }
+    uint32_t add(const char* s)
+    {
+        if (s == NULL || *s == '\0') {
+            return 0;
+        }
+        std::unordered_map<std::string, uint32_t>::iterator it = offsets.find(s);
+        if (it != offsets.end()) {
+            return it->second;
+        }
+        uint32_t offset = (uint32_t)data.size();
+        data.insert(data.end(), s, s + strlen(s) + 1);
+        offsets[s] = offset;
+        return offset;
+    }
+    // tile names are ASCII
+    uint32_t add(const wchar_t* ws)
+    {
+        std::string s;
+        for (; ws != NULL && *ws != L'\0'; ws++) {
+            s.push_back((char)*ws);
+        }
+        return add(s.c_str());
+    }
+    std::vector<char> data;
+private:
+    std::unordered_map<std::string, uint32_t> offsets;
+};
+
+template <typename T>
+static void appendRecord(std::vector<unsigned char>& buf, const T& record)
+{
+    const unsigned char* p = (const unsigned char*)&record;
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+int writeBlockPack(const wchar_t* filename)
+{
+    // records are written as they sit in memory
+    if (!isLittleEndian()) {
+        return LINE_ERROR;
+    }
+    PackStrings strings;
+    std::vector<unsigned char> blocks, translations, tiles;
+
+    for (int type = 0; type < NUM_BLOCKS_DEFINED; type++) {
+        const BlockDefinition& def = gBlockDefinitions[type];
+        PackedBlock pb;
+        memset(&pb, 0, sizeof(pb));
+        pb.name = strings.add(def.name);
+        pb.readColor = def.read_color;
+        pb.readAlpha = def.read_alpha;
+        pb.flags = def.flags;
+        pb.txrX = (int16_t)def.txrX;
+        pb.txrY = (int16_t)def.txrY;
+        pb.subtypeMask = def.subtype_mask;
+        appendRecord(blocks, pb);
+    }
+
+    int translationCount = 0;
+    for (int i = 0; i < getBlockTranslationCount(); i++) {
+        int type, dataVal;
+        unsigned long translateFlags;
+        const char* name = getBlockTranslation(i, type, dataVal, translateFlags);
+        if (name == NULL) {
+            continue;
+        }
+        PackedTranslation pt;
+        memset(&pt, 0, sizeof(pt));
+        pt.name = strings.add(name);
+        pt.type = (uint16_t)type;
+        pt.dataVal = (uint8_t)dataVal;
+        pt.translateFlags = (uint32_t)translateFlags;
+        appendRecord(translations, pt);
+        translationCount++;
+    }
+
+    for (int i = 0; i < TOTAL_TILES; i++) {
+        PackedTile pt;
+        memset(&pt, 0, sizeof(pt));
+        pt.filename = strings.add(gTilesTable[i].filename);
+        pt.altFilename = strings.add(gTilesTable[i].altFilename);
+        pt.txrX = (int16_t)gTilesTable[i].txrX;
+        pt.txrY = (int16_t)gTilesTable[i].txrY;
+        pt.typeForMtl = (int16_t)gTilesTable[i].typeForMtl;
+        pt.dataValForMtl = (int16_t)gTilesTable[i].dataValForMtl;
+        pt.flags = (uint32_t)gTilesTable[i].flags;
+        appendRecord(tiles, pt);
+    }
+
+    BlockPackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BLOCK_PACK_MAGIC, sizeof(header.magic));
+    header.versionMajor = BLOCK_PACK_VERSION_MAJOR;
+    header.versionMinor = BLOCK_PACK_VERSION_MINOR;
+    header.headerSize = sizeof(BlockPackHeader);
+    header.blockCount = NUM_BLOCKS_DEFINED;
+    header.blockStride = sizeof(PackedBlock);
+    header.blockOffset = header.headerSize;
+    header.translationCount = translationCount;
+    header.translationStride = sizeof(PackedTranslation);
+    header.translationOffset = header.blockOffset + (uint32_t)blocks.size();
+    header.tileCount = TOTAL_TILES;
+    header.tileStride = sizeof(PackedTile);
+    header.tileOffset = header.translationOffset + (uint32_t)translations.size();
+    header.stringsSize = (uint32_t)strings.data.size();
+    header.stringsOffset = header.tileOffset + (uint32_t)tiles.size();
+
+    std::vector<unsigned char> body;
+    body.insert(body.end(), blocks.begin(), blocks.end());
+    body.insert(body.end(), translations.begin(), translations.end());
+    body.insert(body.end(), tiles.begin(), tiles.end());
+    body.insert(body.end(), strings.data.begin(), strings.data.end());
+    header.checksum = fnv1a(body.data(), body.size());
+
+    DWORD br;
+    PORTAFILE fh = PortaCreate(filename);
+    if (fh == INVALID_HANDLE_VALUE) {
+        return LINE_ERROR;
+    }
+    if (PortaWrite(fh, &header, sizeof(header)) || PortaWrite(fh, body.data(), (DWORD)body.size())) {
+        PortaClose(fh);
+        return LINE_ERROR;
+    }
+    PortaClose(fh);
+    return 0;
+}
+
+// true if count records of stride bytes, each holding at least minStride bytes, fit in the file at offset
+static bool sectionFits(size_t fileSize, uint32_t offset, uint32_t count, uint32_t stride, size_t minStride)
+{
+    if (count > 0 && stride < minStride) {
+        return false;
+    }
+    // 4-byte alignment, so records can be read in place
+    if ((offset & 3) != 0 || (stride & 3) != 0) {
+        return false;
+    }
+    return offset <= fileSize && (unsigned long long)count * stride <= fileSize - offset;
+}
+
+int loadBlockPack(const wchar_t* filename, BlockPack& pack, bool verifyChecksum)
+{
+    memset(&pack, 0, sizeof(pack));
+    if (!isLittleEndian()) {
+        return LINE_ERROR;
+    }
+    int retCode = openMappedFile(filename, pack.file);
+    if (retCode < 0) {
+        return retCode;
+    }
+    const unsigned char* data = pack.file.data;
+    size_t size = pack.file.size;
+    const BlockPackHeader* header = (const BlockPackHeader*)data;
+    if (size < sizeof(BlockPackHeader) ||
+        memcmp(header->magic, BLOCK_PACK_MAGIC, sizeof(header->magic)) != 0 ||
+        header->versionMajor != BLOCK_PACK_VERSION_MAJOR ||
+        header->headerSize < sizeof(BlockPackHeader) || header->headerSize > size ||
+        !sectionFits(size, header->blockOffset, header->blockCount, header->blockStride, sizeof(PackedBlock)) ||
+        !sectionFits(size, header->translationOffset, header->translationCount, header->translationStride, sizeof(PackedTranslation)) ||
+        !sectionFits(size, header->tileOffset, header->tileCount, header->tileStride, sizeof(PackedTile)) ||
+        header->stringsSize == 0 || header->stringsOffset > size || header->stringsSize > size - header->stringsOffset ||
+        // so no string can run off the end
+        data[header->stringsOffset + header->stringsSize - 1] != '\0') {
+        closeMappedFile(pack.file);
+        return LINE_ERROR;
+    }
+    if (verifyChecksum && fnv1a(data + header->headerSize, size - header->headerSize) != header->checksum) {
+        closeMappedFile(pack.file);
+        return LINE_ERROR;
+    }
+    pack.header = header;
+    pack.blocks = data + header->blockOffset;
+    pack.translations = data + header->translationOffset;
+    pack.tiles = data + header->tileOffset;
+    pack.strings = (const char*)(data + header->stringsOffset);
+    return 0;
+}
+
+void unloadBlockPack(BlockPack& pack)
+{
+    closeMappedFile(pack.file);
+    pack.header = NULL;
+    pack.blocks = pack.translations = pack.tiles = NULL;
+    pack.strings = NULL;
+}
@@ -0,0 +1,108 @@
+// blockPack.h - gBlockDefinitions, BlockTranslations and gTilesTable in one binary file that is used straight from memory
+
+#pragma once
+
+#include <stdint.h>
+#include "mappedFile.h"
+
+// Layout, all little-endian, all offsets from the start of the file so it can be mapped at any address:
+//   BlockPackHeader
+//   blocks:       blockCount records of blockStride bytes, each starting with a PackedBlock
+//   translations: translationCount records of translationStride bytes, each starting with a PackedTranslation
+//   tiles:        tileCount records of tileStride bytes, each starting with a PackedTile
+//   strings:      NUL-terminated UTF-8; names are offsets into this section, and offset 0 is always ""
+// A minor version only ever adds fields to the ends of records, so readers must step by the strides, not by sizeof,
+// and can read any file with the same major version. Python reading is in read_block_pack.py.
+
+#define BLOCK_PACK_MAGIC            "MWBLKPAK"
+#define BLOCK_PACK_VERSION_MAJOR    1
+#define BLOCK_PACK_VERSION_MINOR    0
+
+typedef struct BlockPackHeader {
+    char magic[8];
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    uint32_t headerSize;
+    uint32_t blockCount;
+    uint32_t blockStride;
+    uint32_t blockOffset;
+    uint32_t translationCount;
+    uint32_t translationStride;
+    uint32_t translationOffset;
+    uint32_t tileCount;
+    uint32_t tileStride;
+    uint32_t tileOffset;
+    uint32_t stringsSize;
+    uint32_t stringsOffset;
+    uint32_t checksum;          // FNV-1a of everything after the header
+} BlockPackHeader;
+
+// one per gBlockDefinitions entry, indexed by type
+typedef struct PackedBlock {
+    uint32_t name;
+    uint32_t readColor;
+    float readAlpha;
+    uint32_t flags;             // BLF_*
+    int16_t txrX;
+    int16_t txrY;
+    uint8_t subtypeMask;
+    uint8_t pad[3];
+} PackedBlock;
+
+// one per BlockTranslations entry, in table order; type and dataVal are as IDBlock() gives them
+typedef struct PackedTranslation {
+    uint32_t name;              // without "minecraft:"
+    uint16_t type;
+    uint8_t dataVal;
+    uint8_t pad;
+    uint32_t translateFlags;    // *_PROP
+} PackedTranslation;
+
+// one per gTilesTable entry, in table order
+typedef struct PackedTile {
+    uint32_t filename;
+    uint32_t altFilename;
+    int16_t txrX;
+    int16_t txrY;
+    int16_t typeForMtl;
+    int16_t dataValForMtl;
+    uint32_t flags;             // SBIT_* and SWATCH_*
+} PackedTile;
+
+typedef struct BlockPack {
+    MappedFile file;
+    const BlockPackHeader* header;
+    const unsigned char* blocks;
+    const unsigned char* translations;
+    const unsigned char* tiles;
+    const char* strings;
+} BlockPack;
+
+// Write the tables compiled into this program. Returns 0 on success, negative on error.
+int writeBlockPack(const wchar_t* filename);
+
+// Map a block pack and check its header and section bounds; verifyChecksum also reads every byte to check
+// the checksum. Nothing is copied or parsed. Returns 0 on success, negative on error.
+int loadBlockPack(const wchar_t* filename, BlockPack& pack, bool verifyChecksum);
+void unloadBlockPack(BlockPack& pack);
+
+inline const PackedBlock* getPackBlock(const BlockPack& pack, int i)
+{
+    return (const PackedBlock*)(pack.blocks + (size_t)i * pack.header->blockStride);
+}
+
+inline const PackedTranslation* getPackTranslation(const BlockPack& pack, int i)
+{
+    return (const PackedTranslation*)(pack.translations + (size_t)i * pack.header->translationStride);
+}
+
+inline const PackedTile* getPackTile(const BlockPack& pack, int i)
+{
+    return (const PackedTile*)(pack.tiles + (size_t)i * pack.header->tileStride);
+}
+
+// the string at a name offset; out-of-range offsets give ""
+inline const char* getPackString(const BlockPack& pack, uint32_t offset)
+{
+    return (offset < pack.header->stringsSize) ? pack.strings + offset : pack.strings;
+}
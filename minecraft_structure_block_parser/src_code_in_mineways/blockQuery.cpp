@@ -0,0 +1,215 @@
+// blockQuery.cpp - find every block of some types in a world, such as all spawners or chests, reading only the sections that have them
+
+#include "stdafx.h"
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "nbtView.h"
+#include "chunkSections.h"
+#include "asyncRegionReader.h"
+#include "blockQuery.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define BLOCK_QUERY_SSE
+#include <emmintrin.h>
+#endif
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// wanted palette entries compared at once; a section with more uses a lookup table
+#define MAX_COMPARED_ENTRIES 8
+
+void makeBlockQuery(const char* const* names, int nameCount, BlockQuery& query)
+{
+    query.names.clear();
+    for (int i = 0; i < nameCount; i++) {
+        const char* name = names[i];
+        if (strncmp(name, "minecraft:", 10) == 0) {
+            name += 10;
+        }
+        query.names.push_back(name);
+    }
+}
+
+static int findTarget(const BlockQuery& query, const char* name, int length)
+{
+    for (size_t t = 0; t < query.names.size(); t++) {
+        if (query.names[t].size() == (size_t)length && memcmp(query.names[t].data(), name, length) == 0) {
+            return (int)t;
+        }
+    }
+    return -1;
+}
+
+static void addMatch(std::vector<BlockMatch>& matches, int chunkX, int chunkZ, const ChunkSection& section, int i, int target)
+{
+    BlockMatch match;
+    match.x = chunkX * 16 + (i & 15);
+    match.y = section.sectionY * 16 + (i >> 8);
+    match.z = chunkZ * 16 + ((i >> 4) & 15);
+    match.target = target;
+    matches.push_back(match);
+}
+
+// the blocks whose index is one of entries, whose targets are in targetOf
+static void compareIndices(const unsigned short* indices, const short* targetOf, const unsigned short* entries, int entryCount,
+    int chunkX, int chunkZ, const ChunkSection& section, std::vector<BlockMatch>& matches)
+{
+#ifdef BLOCK_QUERY_SSE
+    if (entryCount <= MAX_COMPARED_ENTRIES) {
+        __m128i keys[MAX_COMPARED_ENTRIES];
+        for (int e = 0; e < entryCount; e++) {
+            keys[e] = _mm_set1_epi16((short)entries[e]);
+        }
+        for (int i = 0; i < SECTION_BLOCKS; i += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(indices + i));
+            __m128i hit = _mm_cmpeq_epi16(v, keys[0]);
+            for (int e = 1; e < entryCount; e++) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi16(v, keys[e]));
+            }
+            // two mask bits per 16-bit lane
+            int mask = _mm_movemask_epi8(hit);
+            if (mask != 0) {
+                for (int lane = 0; lane < 8; lane++) {
+                    if (mask & (1 << (lane * 2))) {
+                        addMatch(matches, chunkX, chunkZ, section, i + lane, targetOf[indices[i + lane]]);
+                    }
+                }
+            }
+        }
+        return;
+    }
+#else
+    (void)entries;
+    (void)entryCount;
+#endif
+    for (int i = 0; i < SECTION_BLOCKS; i++) {
+        if (targetOf[indices[i]] >= 0) {
+            addMatch(matches, chunkX, chunkZ, section, i, targetOf[indices[i]]);
+        }
+    }
+}
+
+int findBlocksInChunk(const unsigned char* nbt, size_t size, const BlockQuery& query, BlockMatchCallback callback, void* context, BlockQueryStats* stats)
+{
+    NbtView view = { nbt, size, false };
+    NbtTag sections;
+    NbtIterator it;
+    int chunkX, chunkZ;
+    if (!getChunkSections(view, chunkX, chunkZ, sections) || !nbtIterate(view, sections, it)) {
+        if (stats != NULL) {
+            stats->chunkErrors++;
+        }
+        return LINE_ERROR;
+    }
+    // the target for each palette index, -1 if not wanted; indices may go past the palette, up to 1 << bits
+    short targetOf[SECTION_BLOCKS];
+    unsigned short entries[SECTION_BLOCKS];
+    unsigned short indices[SECTION_BLOCKS];
+    std::vector<BlockMatch> matches;
+    int matchCount = 0;
+    long long sectionCount = 0;
+    long long sectionsSearched = 0;
+    ChunkSection section;
+    while (nextChunkSection(view, it, section)) {
+        sectionCount++;
+        int entryCount = 0;
+        NbtIterator paletteIt;
+        NbtTag entry;
+        nbtIterate(view, section.palette, paletteIt);
+        int p = 0;
+        for (; p < section.paletteCount && nbtNext(view, paletteIt, entry); p++) {
+            const char* name;
+            int length;
+            targetOf[p] = getPaletteEntryName(view, entry, name, length) ? (short)findTarget(query, name, length) : -1;
+            if (targetOf[p] >= 0) {
+                entries[entryCount++] = (unsigned short)p;
+            }
+        }
+        // damaged entries, and indices past the palette
+        for (; p < (1 << section.bits) || p < section.paletteCount; p++) {
+            targetOf[p] = -1;
+        }
+        // most sections stop here
+        if (entryCount == 0) {
+            continue;
+        }
+        sectionsSearched++;
+        matches.clear();
+        if (section.bits == 0) {
+            // the whole section is the one entry
+            for (int i = 0; i < SECTION_BLOCKS; i++) {
+                addMatch(matches, chunkX, chunkZ, section, i, targetOf[0]);
+            }
+        }
+        else {
+            unpackSectionIndices(section, indices);
+            compareIndices(indices, targetOf, entries, entryCount, chunkX, chunkZ, section, matches);
+        }
+        if (!matches.empty()) {
+            callback(matches.data(), (int)matches.size(), context);
+            matchCount += (int)matches.size();
+        }
+    }
+    if (stats != NULL) {
+        stats->chunkCount++;
+        stats->sectionCount += sectionCount;
+        stats->sectionsSearched += sectionsSearched;
+        stats->matchCount += matchCount;
+    }
+    return matchCount;
+}
+
+// what the decode threads share
+typedef struct RegionQuery {
+    const BlockQuery* query;
+    BlockMatchCallback callback;
+    void* context;
+    std::atomic<long long> chunkCount;
+    std::atomic<long long> sectionCount;
+    std::atomic<long long> sectionsSearched;
+    std::atomic<long long> matchCount;
+    std::atomic<int> chunkErrors;
+} RegionQuery;
+
+static void queryChunk(const ChunkReadResult& result, void* context)
+{
+    RegionQuery* regionQuery = (RegionQuery*)context;
+    if (result.status < 0) {
+        regionQuery->chunkErrors++;
+        return;
+    }
+    BlockQueryStats stats;
+    memset(&stats, 0, sizeof(stats));
+    findBlocksInChunk(result.nbt, result.nbtSize, *regionQuery->query, regionQuery->callback, regionQuery->context, &stats);
+    regionQuery->chunkCount += stats.chunkCount;
+    regionQuery->sectionCount += stats.sectionCount;
+    regionQuery->sectionsSearched += stats.sectionsSearched;
+    regionQuery->matchCount += stats.matchCount;
+    regionQuery->chunkErrors += stats.chunkErrors;
+}
+
+int findBlocksInRegions(const wchar_t* const* regionFilenames, int fileCount, const BlockQuery& query, const AsyncReadOptions* options,
+    BlockMatchCallback callback, void* context, BlockQueryStats* stats)
+{
+    RegionQuery regionQuery;
+    regionQuery.query = &query;
+    regionQuery.callback = callback;
+    regionQuery.context = context;
+    regionQuery.chunkCount = 0;
+    regionQuery.sectionCount = 0;
+    regionQuery.sectionsSearched = 0;
+    regionQuery.matchCount = 0;
+    regionQuery.chunkErrors = 0;
+    int retCode = readRegionChunksAsync(regionFilenames, fileCount, options, queryChunk, &regionQuery, NULL);
+    if (stats != NULL) {
+        stats->chunkCount = regionQuery.chunkCount;
+        stats->sectionCount = regionQuery.sectionCount;
+        stats->sectionsSearched = regionQuery.sectionsSearched;
+        stats->matchCount = regionQuery.matchCount;
+        stats->chunkErrors = regionQuery.chunkErrors;
+    }
+    return (retCode < 0) ? retCode : 0;
+}
@@ -0,0 +1,47 @@
+// blockQuery.h - find every block of some types in a world, such as all spawners or chests, reading only the sections that have them
+
+#pragma once
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "asyncRegionReader.h"
+
+// Each section's palette (chunkSections.h) is checked first, and a section none of whose palette entries
+// is asked for is passed over without unpacking its indices, which for rare blocks is nearly all of them.
+// A section that has one is unpacked and its indices compared against the wanted palette entries eight at a
+// time. Matches are handed back a section at a time, as they're found.
+
+typedef struct BlockQuery {
+    std::vector<std::string> names;     // without "minecraft:"
+} BlockQuery;
+
+typedef struct BlockMatch {
+    int x;                  // world block coordinates
+    int y;
+    int z;
+    int target;             // which of the query's names
+} BlockMatch;
+
+typedef struct BlockQueryStats {
+    long long chunkCount;
+    long long sectionCount;         // with palettes
+    long long sectionsSearched;     // whose palette had a name asked for, so were unpacked
+    long long matchCount;
+    int chunkErrors;                // chunks that couldn't be read, or have no palettes, as before 1.13
+} BlockQueryStats;
+
+// Matches for one section; for findBlocksInRegions(), called on its decode threads, several at once.
+typedef void (*BlockMatchCallback)(const BlockMatch* matches, int count, void* context);
+
+// names with or without "minecraft:"; properties are not matched, so "chest" finds chests facing any way
+void makeBlockQuery(const char* const* names, int nameCount, BlockQuery& query);
+
+// Searches one chunk's NBT. stats, which may be NULL, are added to. Returns the number of matches, or
+// negative if the chunk has no sections that can be read.
+int findBlocksInChunk(const unsigned char* nbt, size_t size, const BlockQuery& query, BlockMatchCallback callback, void* context, BlockQueryStats* stats);
+
+// Searches every chunk of the region files, read with readRegionChunksAsync(); options may be NULL.
+// stats, which may be NULL, are set. Returns 0 on success, negative if a region file can't be read.
+int findBlocksInRegions(const wchar_t* const* regionFilenames, int fileCount, const BlockQuery& query, const AsyncReadOptions* options,
+    BlockMatchCallback callback, void* context, BlockQueryStats* stats);
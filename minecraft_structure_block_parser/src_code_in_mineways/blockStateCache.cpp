@@ -0,0 +1,225 @@
+// blockStateCache.cpp - remember what each palette block state translated to, so a state is decoded only once
+
+#include "stdafx.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "blockStateCache.h"
+
+#define BLOCK_STATE_CACHE_SHARDS    16
+
+typedef struct CacheSlot {
+    std::string key;                    // empty if the slot is free
+    unsigned short blockId;
+    unsigned char dataVal;
+    std::atomic<unsigned char> referenced;  // the CLOCK bit; set by readers under the shared lock
+} CacheSlot;
+
+typedef struct CacheShard {
+    mutable std::shared_mutex lock;
+    // keys are views of the slots' own strings, which don't move while the slot holds them
+    std::unordered_map<std::string_view, int> index;
+    std::vector<CacheSlot> slots;
+    int hand;
+    int used;
+    std::atomic<unsigned long long> hits;
+    std::atomic<unsigned long long> misses;
+    std::atomic<unsigned long long> insertions;
+    std::atomic<unsigned long long> evictions;
+} CacheShard;
+
+struct BlockStateCache {
+    int capacity;
+    CacheShard shards[BLOCK_STATE_CACHE_SHARDS];
+};
+
+static unsigned int hashKey(const char* key, int keyLength)
+{
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < keyLength; i++) {
+        hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static CacheShard& getShard(BlockStateCache* cache, const char* key, int keyLength)
+{
+    return cache->shards[hashKey(key, keyLength) % BLOCK_STATE_CACHE_SHARDS];
+}
+
+BlockStateCache* createBlockStateCache(int capacity)
+{
+    if (capacity <= 0) {
+        capacity = BLOCK_STATE_CACHE_DEFAULT_CAPACITY;
+    }
+    BlockStateCache* cache = new (std::nothrow) BlockStateCache;
+    if (cache == NULL) {
+        return NULL;
+    }
+    // spread evenly, at least one slot per shard
+    int perShard = (capacity + BLOCK_STATE_CACHE_SHARDS - 1) / BLOCK_STATE_CACHE_SHARDS;
+    cache->capacity = perShard * BLOCK_STATE_CACHE_SHARDS;
+    for (int s = 0; s < BLOCK_STATE_CACHE_SHARDS; s++) {
+        CacheShard& shard = cache->shards[s];
+        shard.slots = std::vector<CacheSlot>(perShard);
+        for (int i = 0; i < perShard; i++) {
+            shard.slots[i].referenced.store(0);
+        }
+        shard.index.reserve(perShard);
+        shard.hand = 0;
+        shard.used = 0;
+        shard.hits.store(0);
+        shard.misses.store(0);
+        shard.insertions.store(0);
+        shard.evictions.store(0);
+    }
+    return cache;
+}
+
+void destroyBlockStateCache(BlockStateCache* cache)
+{
+    delete cache;
+}
+
+void clearBlockStateCache(BlockStateCache* cache)
+{
+    for (int s = 0; s < BLOCK_STATE_CACHE_SHARDS; s++) {
+        CacheShard& shard = cache->shards[s];
+        std::unique_lock<std::shared_mutex> writeLock(shard.lock);
+        shard.index.clear();
+        for (size_t i = 0; i < shard.slots.size(); i++) {
+            shard.slots[i].key.clear();
+            shard.slots[i].referenced.store(0, std::memory_order_relaxed);
+        }
+        shard.hand = 0;
+        shard.used = 0;
+    }
+}
+
+bool findBlockState(BlockStateCache* cache, const char* key, int keyLength, unsigned short& blockId, unsigned char& dataVal)
+{
+    CacheShard& shard = getShard(cache, key, keyLength);
+    std::shared_lock<std::shared_mutex> readLock(shard.lock);
+    std::unordered_map<std::string_view, int>::const_iterator it = shard.index.find(std::string_view(key, keyLength));
+    if (it == shard.index.end()) {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    CacheSlot& slot = shard.slots[it->second];
+    blockId = slot.blockId;
+    dataVal = slot.dataVal;
+    if (slot.referenced.load(std::memory_order_relaxed) == 0) {
+        slot.referenced.store(1, std::memory_order_relaxed);
+    }
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void addBlockState(BlockStateCache* cache, const char* key, int keyLength, unsigned short blockId, unsigned char dataVal)
+{
+    CacheShard& shard = getShard(cache, key, keyLength);
+    std::unique_lock<std::shared_mutex> writeLock(shard.lock);
+    std::unordered_map<std::string_view, int>::iterator it = shard.index.find(std::string_view(key, keyLength));
+    if (it != shard.index.end()) {
+        shard.slots[it->second].blockId = blockId;
+        shard.slots[it->second].dataVal = dataVal;
+        return;
+    }
+
+    int slotCount = (int)shard.slots.size();
+    int victim;
+    if (shard.used < slotCount) {
+        victim = shard.used++;
+    }
+    else {
+        // CLOCK: go around clearing reference bits until finding a slot not used since the last pass
+        while (shard.slots[shard.hand].referenced.load(std::memory_order_relaxed)) {
+            shard.slots[shard.hand].referenced.store(0, std::memory_order_relaxed);
+            shard.hand = (shard.hand + 1) % slotCount;
+        }
+        victim = shard.hand;
+        shard.hand = (shard.hand + 1) % slotCount;
+        shard.index.erase(std::string_view(shard.slots[victim].key));
+        shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+    CacheSlot& slot = shard.slots[victim];
+    slot.key.assign(key, keyLength);
+    slot.blockId = blockId;
+    slot.dataVal = dataVal;
+    slot.referenced.store(0, std::memory_order_relaxed);
+    shard.index[std::string_view(slot.key)] = victim;
+    shard.insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void getBlockStateCacheStats(const BlockStateCache* cache, BlockStateCacheStats& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.capacity = cache->capacity;
+    for (int s = 0; s < BLOCK_STATE_CACHE_SHARDS; s++) {
+        const CacheShard& shard = cache->shards[s];
+        stats.hits += shard.hits.load(std::memory_order_relaxed);
+        stats.misses += shard.misses.load(std::memory_order_relaxed);
+        stats.insertions += shard.insertions.load(std::memory_order_relaxed);
+        stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+        std::shared_lock<std::shared_mutex> readLock(shard.lock);
+        stats.size += shard.used;
+    }
+    unsigned long long lookups = stats.hits + stats.misses;
+    stats.hitRate = lookups ? (double)stats.hits / (double)lookups : 0.0;
+}
+
+int makeBlockStateKey(const char* name, int propertyCount, const char* const* keys, const char* const* values, char* key, int keySize)
+{
+    if (strncmp(name, "minecraft:", 10) == 0) {
+        name += 10;
+    }
+    // palettes have a handful of properties, so an insertion sort of indices is plenty
+    int order[32];
+    if (propertyCount > 32) {
+        return -1;
+    }
+    for (int i = 0; i < propertyCount; i++) {
+        int j = i;
+        while (j > 0 && strcmp(keys[order[j - 1]], keys[i]) > 0) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    int length = 0;
+    auto append = [&](const char* s) {
+        int n = (int)strlen(s);
+        if (length + n >= keySize) {
+            length = keySize;
+            return;
+        }
+        memcpy(key + length, s, n);
+        length += n;
+    };
+    append(name);
+    for (int i = 0; i < propertyCount; i++) {
+        append(i == 0 ? "[" : ",");
+        append(keys[order[i]]);
+        append("=");
+        append(values[order[i]]);
+    }
+    if (propertyCount > 0) {
+        append("]");
+    }
+    if (length >= keySize) {
+        return -1;
+    }
+    key[length] = '\0';
+    return length;
+}
+
+BlockStateCache* getPaletteStateCache()
+{
+    static BlockStateCache* cache = createBlockStateCache(0);
+    return cache;
+}
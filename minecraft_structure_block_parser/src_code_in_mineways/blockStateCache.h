@@ -0,0 +1,46 @@
+// blockStateCache.h - remember what each palette block state translated to, so a state is decoded only once
+
+#pragma once
+
+// Keys are canonical block states, "name[key=value,...]" with properties sorted by key, the same form
+// getBlockStateForType() gives; makeBlockStateKey() builds one from a palette entry. The value is the
+// (blockId, dataVal) pair the entry translates to; blockId is wide enough for a full type, which is what
+// Bedrock palettes (bedrockTranslations.h) store, under keys starting "bedrock:". The cache holds at most its
+// capacity in states; when full, the CLOCK policy (second chance) picks which to drop. It is split into
+// shards, each with its own reader-writer lock, so many threads reading chunks can use one cache.
+
+typedef struct BlockStateCache BlockStateCache;
+
+typedef struct BlockStateCacheStats {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long insertions;
+    unsigned long long evictions;
+    int size;
+    int capacity;
+    double hitRate;     // hits / (hits + misses), 0 if nothing was looked up
+} BlockStateCacheStats;
+
+#define BLOCK_STATE_CACHE_DEFAULT_CAPACITY  16384
+// longest key makeBlockStateKey() will build
+#define BLOCK_STATE_KEY_MAX                 512
+
+// capacity 0 means BLOCK_STATE_CACHE_DEFAULT_CAPACITY; NULL if out of memory
+BlockStateCache* createBlockStateCache(int capacity);
+void destroyBlockStateCache(BlockStateCache* cache);
+// drop everything, e.g. when mod translations change what names mean; the counters are kept
+void clearBlockStateCache(BlockStateCache* cache);
+
+// true, and the pair, if the state is in the cache
+bool findBlockState(BlockStateCache* cache, const char* key, int keyLength, unsigned short& blockId, unsigned char& dataVal);
+// add a state, or update it if already there
+void addBlockState(BlockStateCache* cache, const char* key, int keyLength, unsigned short blockId, unsigned char dataVal);
+
+void getBlockStateCacheStats(const BlockStateCache* cache, BlockStateCacheStats& stats);
+
+// Build the canonical key from a name ("minecraft:" is dropped) and its properties, in any order.
+// Returns the key length, or -1 if it would not fit in keySize bytes.
+int makeBlockStateKey(const char* name, int propertyCount, const char* const* keys, const char* const* values, char* key, int keySize);
+
+// the one cache Java structure and Bedrock palettes use, made on first use
+BlockStateCache* getPaletteStateCache();
@@ -0,0 +1,251 @@
+// chunkBenchmark.cpp - time each chunk decompression backend on the chunks of a real region file
+
+#include "stdafx.h"
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <zlib.h>
+#include "chunkCompression.h"
+#include "regionFile.h"
+#include "chunkBenchmark.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// as lz4-java's LZ4BlockOutputStream, which Minecraft uses
+#define LZ4_BLOCK_SIZE          (64 * 1024)
+#define LZ4_BLOCK_LEVEL         6       // log2(LZ4_BLOCK_SIZE) - 10, in the token's low bits
+#define LZ4_METHOD_RAW          0x10
+#define LZ4_METHOD_LZ4          0x20
+#define LZ4_HASH_BITS           12
+
+static void putLittleInt(std::vector<unsigned char>& out, unsigned int value)
+{
+    for (int i = 0; i < 4; i++) {
+        out.push_back((unsigned char)(value >> (8 * i)));
+    }
+}
+
+static void putLz4Length(std::vector<unsigned char>& out, size_t length)
+{
+    for (; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back((unsigned char)length);
+}
+
+static void putLz4Sequence(std::vector<unsigned char>& out, const unsigned char* literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+    size_t matchCode = (matchLength > 0) ? matchLength - 4 : 0;
+    out.push_back((unsigned char)(((literalLength < 15 ? literalLength : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+    if (literalLength >= 15) {
+        putLz4Length(out, literalLength - 15);
+    }
+    out.insert(out.end(), literals, literals + literalLength);
+    if (matchLength > 0) {
+        out.push_back((unsigned char)offset);
+        out.push_back((unsigned char)(offset >> 8));
+        if (matchCode >= 15) {
+            putLz4Length(out, matchCode - 15);
+        }
+    }
+}
+
+static unsigned int read32(const unsigned char* p)
+{
+    unsigned int value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+// A greedy LZ4 block encoder, one hash probe per position, which is close to what lz4-java's fast
+// compressor makes. Only for making test data: decoding speed is what's measured.
+static void encodeLz4Block(const unsigned char* in, size_t size, std::vector<unsigned char>& out)
+{
+    std::vector<int> table((size_t)1 << LZ4_HASH_BITS, -1);
+    size_t anchor = 0;
+    // the format wants the last match to start 12 bytes or more before the end, and the last 5 to be literals
+    size_t matchStartLimit = (size > 12) ? size - 12 : 0;
+    size_t matchEndLimit = (size > 5) ? size - 5 : 0;
+    size_t i = 0;
+    while (i < matchStartLimit) {
+        unsigned int sequence = read32(in + i);
+        unsigned int hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        int candidate = table[hash];
+        table[hash] = (int)i;
+        if (candidate >= 0 && i - candidate <= 65535 && read32(in + candidate) == sequence) {
+            size_t length = 4;
+            while (i + length < matchEndLimit && in[candidate + length] == in[i + length]) {
+                length++;
+            }
+            putLz4Sequence(out, in + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        }
+        else {
+            i++;
+        }
+    }
+    putLz4Sequence(out, in + anchor, size - anchor, 0, 0);
+}
+
+static void putLz4BlockHeader(std::vector<unsigned char>& out, int method, size_t compressedLength, size_t originalLength)
+{
+    out.insert(out.end(), "LZ4Block", "LZ4Block" + 8);
+    out.push_back((unsigned char)(method | LZ4_BLOCK_LEVEL));
+    putLittleInt(out, (unsigned int)compressedLength);
+    putLittleInt(out, (unsigned int)originalLength);
+    // the checksum, which the decoder doesn't check
+    putLittleInt(out, 0);
+}
+
+static void encodeLz4(const std::vector<unsigned char>& nbt, std::vector<unsigned char>& out)
+{
+    out.clear();
+    std::vector<unsigned char> block;
+    for (size_t start = 0; start < nbt.size(); start += LZ4_BLOCK_SIZE) {
+        size_t length = (nbt.size() - start < LZ4_BLOCK_SIZE) ? nbt.size() - start : LZ4_BLOCK_SIZE;
+        block.clear();
+        encodeLz4Block(nbt.data() + start, length, block);
+        if (block.size() < length) {
+            putLz4BlockHeader(out, LZ4_METHOD_LZ4, block.size(), length);
+            out.insert(out.end(), block.begin(), block.end());
+        }
+        else {
+            putLz4BlockHeader(out, LZ4_METHOD_RAW, length, length);
+            out.insert(out.end(), nbt.begin() + start, nbt.begin() + start + length);
+        }
+    }
+    putLz4BlockHeader(out, LZ4_METHOD_RAW, 0, 0);
+}
+
+static int encodeDeflate(const std::vector<unsigned char>& nbt, bool gzip, std::vector<unsigned char>& out)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // 16 more window bits asks for a gzip wrapper
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return LINE_ERROR;
+    }
+    out.resize(deflateBound(&zs, (uLong)nbt.size()));
+    zs.next_in = (Bytef*)nbt.data();
+    zs.avail_in = (uInt)nbt.size();
+    zs.next_out = out.data();
+    zs.avail_out = (uInt)out.size();
+    int status = deflate(&zs, Z_FINISH);
+    out.resize(out.size() - zs.avail_out);
+    deflateEnd(&zs);
+    return (status == Z_STREAM_END) ? 0 : LINE_ERROR;
+}
+
+int benchmarkChunkDecompression(const wchar_t* regionFilename, int rounds, std::vector<ChunkBenchmarkResult>& results)
+{
+    static const int types[] = { CHUNK_COMPRESSION_GZIP, CHUNK_COMPRESSION_ZLIB, CHUNK_COMPRESSION_NONE, CHUNK_COMPRESSION_LZ4 };
+    const int typeCount = sizeof(types) / sizeof(types[0]);
+    results.clear();
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    RegionFile region;
+    int retCode = openRegionFile(regionFilename, region);
+    if (retCode < 0) {
+        return retCode;
+    }
+    // every chunk, stored each way
+    std::vector<std::vector<unsigned char>> stored[typeCount];
+    std::vector<unsigned char> nbt;
+    size_t nbtBytes = 0;
+    for (int z = 0; z < 32; z++) {
+        for (int x = 0; x < 32; x++) {
+            retCode = readRegionChunk(region, x, z, nbt);
+            if (retCode == 1) {
+                continue;
+            }
+            if (retCode < 0) {
+                closeRegionFile(region);
+                return retCode;
+            }
+            nbtBytes += nbt.size();
+            for (int t = 0; t < typeCount; t++) {
+                stored[t].push_back(std::vector<unsigned char>());
+                std::vector<unsigned char>& out = stored[t].back();
+                if (types[t] == CHUNK_COMPRESSION_LZ4) {
+                    encodeLz4(nbt, out);
+                }
+                else if (types[t] == CHUNK_COMPRESSION_NONE) {
+                    out = nbt;
+                }
+                else if (encodeDeflate(nbt, types[t] == CHUNK_COMPRESSION_GZIP, out) < 0) {
+                    closeRegionFile(region);
+                    return LINE_ERROR;
+                }
+            }
+        }
+    }
+    closeRegionFile(region);
+
+    for (int t = 0; t < typeCount; t++) {
+        const ChunkDecompressor* decompressor = getChunkDecompressor(types[t]);
+        if (decompressor == NULL) {
+            continue;
+        }
+        ChunkBenchmarkResult result;
+        memset(&result, 0, sizeof(result));
+        result.backend = decompressor->name;
+        result.compressionType = types[t];
+        result.chunkCount = (int)stored[t].size();
+        result.nbtBytes = nbtBytes;
+        for (size_t c = 0; c < stored[t].size(); c++) {
+            result.compressedBytes += stored[t][c].size();
+        }
+        for (int r = 0; r < rounds; r++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            size_t produced = 0;
+            for (size_t c = 0; c < stored[t].size(); c++) {
+                if (decompressor->decompress(stored[t][c].data(), stored[t][c].size(), nbt) < 0) {
+                    return LINE_ERROR;
+                }
+                produced += nbt.size();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            // a backend that gives back different NBT is broken, not fast
+            if (produced != nbtBytes) {
+                return LINE_ERROR;
+            }
+            if (r == 0 || seconds < result.seconds) {
+                result.seconds = seconds;
+            }
+        }
+        result.megabytesPerSecond = (result.seconds > 0.0) ? (double)nbtBytes / (1024.0 * 1024.0) / result.seconds : 0.0;
+        results.push_back(result);
+    }
+    return (int)results.size();
+}
+
+#ifdef CHUNK_BENCHMARK_MAIN
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s region.mca [rounds]\n", argv[0]);
+        return 1;
+    }
+    wchar_t filename[MAX_PATH];
+    if (mbstowcs(filename, argv[1], MAX_PATH) == (size_t)-1) {
+        return 1;
+    }
+    filename[MAX_PATH - 1] = L'\0';
+    std::vector<ChunkBenchmarkResult> results;
+    int retCode = benchmarkChunkDecompression(filename, (argc > 2) ? atoi(argv[2]) : 5, results);
+    if (retCode < 0) {
+        printf("Benchmark failed, error %d\n", retCode);
+        return 1;
+    }
+    printf("%-20s %8s %12s %12s %10s %10s\n", "backend", "chunks", "stored", "NBT", "ms", "MB/s");
+    for (size_t i = 0; i < results.size(); i++) {
+        const ChunkBenchmarkResult& r = results[i];
+        printf("%-20s %8d %12zu %12zu %10.2f %10.1f\n", r.backend, r.chunkCount, r.compressedBytes, r.nbtBytes, r.seconds * 1000.0, r.megabytesPerSecond);
+    }
+    return 0;
+}
+#endif
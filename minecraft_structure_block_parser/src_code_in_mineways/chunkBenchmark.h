@@ -0,0 +1,23 @@
+// chunkBenchmark.h - time each chunk decompression backend on the chunks of a real region file
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+typedef struct ChunkBenchmarkResult {
+    const char* backend;        // the ChunkDecompressor's name
+    int compressionType;        // CHUNK_COMPRESSION_*
+    int chunkCount;
+    size_t compressedBytes;     // all chunks, as stored
+    size_t nbtBytes;            // all chunks, decompressed
+    double seconds;             // to decompress all chunks, best of the rounds
+    double megabytesPerSecond;  // of NBT produced
+} ChunkBenchmarkResult;
+
+// Decompresses every chunk of the region file, stores each again with gzip, zlib, no compression and LZ4,
+// as Minecraft writes them, and times decompressing all of them with the backend for each type
+// (chunkCompression.h), best of rounds. Returns the number of results, or negative on error.
+// Built with CHUNK_BENCHMARK_MAIN defined, chunkBenchmark.cpp is a program that prints these:
+//   chunkBenchmark r.0.0.mca [rounds]
+int benchmarkChunkDecompression(const wchar_t* regionFilename, int rounds, std::vector<ChunkBenchmarkResult>& results);
@@ -0,0 +1,445 @@
+// chunkCache.cpp - keep a world's decoded chunks in memory, up to a byte budget, so overlapping exports read and decode each chunk once
+
+#include "stdafx.h"
+#include <string.h>
+#include <wchar.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "regionFile.h"
+#include "sectionStore.h"
+#include "chunkCache.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// chunks waiting to be read ahead; older ones are dropped, as the scan has likely passed them
+#define CHUNK_CACHE_PREFETCH_QUEUE  (4 * CHUNK_CACHE_PREFETCH_DISTANCE)
+
+typedef struct CachedChunk {
+    // first, so a column handed out is also its entry
+    PackedSection column[SECTION_STORE_LAYERS];
+    unsigned long long key;
+    int status;
+    size_t bytes;
+    int pins;                   // acquired and not yet released
+    bool loading;               // still being read, and not in the list
+    bool prefetched;            // read ahead, and not yet asked for
+    struct CachedChunk* newer;  // the list, most recently used first
+    struct CachedChunk* older;
+} CachedChunk;
+
+typedef struct PrefetchRequest {
+    int dimension;
+    int chunkX;
+    int chunkZ;
+} PrefetchRequest;
+
+struct ChunkCache {
+    std::wstring worldDirectory;    // with a trailing separator
+    size_t budget;
+
+    mutable std::mutex lock;
+    std::condition_variable loaded;     // a chunk was read, or the last read in progress finished
+    std::unordered_map<unsigned long long, CachedChunk*> chunks;
+    CachedChunk* newest;
+    CachedChunk* oldest;
+    size_t bytes;
+    int loadsInProgress;
+
+    // the last chunk asked for, and the step to it from the one before
+    bool haveLast;
+    int lastDimension;
+    int lastX;
+    int lastZ;
+    int stepX;
+    int stepZ;
+
+    std::deque<PrefetchRequest> prefetchQueue;
+    std::condition_variable prefetchWanted;
+    bool stopping;
+    std::thread prefetcher;
+
+    // opened as needed; NULL for one that can't be read
+    std::mutex regionLock;
+    std::unordered_map<unsigned long long, RegionFile*> regions;
+
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long long prefetches;
+    unsigned long long prefetchHits;
+};
+
+// the same packing as worldIndexKey(), for chunks and for regions
+static unsigned long long cacheKey(int dimension, int x, int z)
+{
+    return ((unsigned long long)(unsigned char)dimension << 48) | ((unsigned long long)(x & 0xffffff) << 24) | (unsigned long long)(z & 0xffffff);
+}
+
+size_t getChunkCacheBudget(const Options& options)
+{
+    size_t chunks = (options.currentCacheSize > 0) ? (size_t)options.currentCacheSize : CHUNK_CACHE_DEFAULT_CHUNKS;
+    size_t budget = chunks * CHUNK_CACHE_BYTES_PER_CHUNK;
+    return options.moreExportMemory ? 4 * budget : budget;
+}
+
+static RegionFile* getCachedRegion(ChunkCache* cache, int dimension, int regionX, int regionZ)
+{
+    std::lock_guard<std::mutex> guard(cache->regionLock);
+    unsigned long long key = cacheKey(dimension, regionX, regionZ);
+    std::unordered_map<unsigned long long, RegionFile*>::iterator found = cache->regions.find(key);
+    if (found != cache->regions.end()) {
+        return found->second;
+    }
+    const wchar_t* folder = (dimension == -1) ? L"DIM-1/region/" : (dimension == 1) ? L"DIM1/region/" : L"region/";
+    wchar_t name[64];
+    swprintf(name, 64, L"r.%d.%d.mca", regionX, regionZ);
+    std::wstring filename = cache->worldDirectory + folder + name;
+    RegionFile* region = new (std::nothrow) RegionFile;
+    if (region != NULL && openRegionFile(filename.c_str(), *region) < 0) {
+        delete region;
+        region = NULL;
+    }
+    cache->regions[key] = region;
+    return region;
+}
+
+static void closeCachedRegions(ChunkCache* cache)
+{
+    std::lock_guard<std::mutex> guard(cache->regionLock);
+    for (std::unordered_map<unsigned long long, RegionFile*>::iterator it = cache->regions.begin(); it != cache->regions.end(); ++it) {
+        if (it->second != NULL) {
+            closeRegionFile(*it->second);
+            delete it->second;
+        }
+    }
+    cache->regions.clear();
+}
+
+// reads and decodes a chunk into its entry, without the cache's lock
+static void readCachedChunk(ChunkCache* cache, int dimension, int chunkX, int chunkZ, CachedChunk* entry, std::vector<unsigned char>& nbt)
+{
+    RegionFile* region = getCachedRegion(cache, dimension, chunkX >> 5, chunkZ >> 5);
+    if (region == NULL) {
+        entry->status = LINE_ERROR;
+        return;
+    }
+    entry->status = readRegionChunk(*region, chunkX & 31, chunkZ & 31, nbt);
+    if (entry->status == 0) {
+        int nbtX, nbtZ;
+        entry->status = decodeChunkColumn(nbt.data(), nbt.size(), nbtX, nbtZ, entry->column);
+    }
+    entry->bytes = CHUNK_CACHE_ENTRY_BYTES;
+    for (int layer = 0; layer < SECTION_STORE_LAYERS; layer++) {
+        entry->bytes += getPackedSectionBytes(entry->column[layer]);
+    }
+}
+
+static void linkNewest(ChunkCache* cache, CachedChunk* entry)
+{
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest != NULL) {
+        cache->newest->newer = entry;
+    }
+    else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+static void unlink(ChunkCache* cache, CachedChunk* entry)
+{
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    }
+    else {
+        cache->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    }
+    else {
+        cache->oldest = entry->newer;
+    }
+}
+
+static void dropChunk(ChunkCache* cache, CachedChunk* entry)
+{
+    unlink(cache, entry);
+    cache->chunks.erase(entry->key);
+    cache->bytes -= entry->bytes;
+    freeChunkColumn(entry->column);
+    delete entry;
+}
+
+static void evictOverBudget(ChunkCache* cache)
+{
+    // chunks read ahead and not yet reached are what a scan will want next, so they go only as a last resort
+    for (int pass = 0; pass < 2 && cache->bytes > cache->budget; pass++) {
+        CachedChunk* entry = cache->oldest;
+        while (entry != NULL && cache->bytes > cache->budget) {
+            CachedChunk* newer = entry->newer;
+            if (entry->pins == 0 && (pass == 1 || !entry->prefetched)) {
+                dropChunk(cache, entry);
+                cache->evictions++;
+            }
+            entry = newer;
+        }
+    }
+}
+
+// an entry for a chunk about to be read, in the map but not the list; NULL if out of memory
+static CachedChunk* startRead(ChunkCache* cache, unsigned long long key)
+{
+    CachedChunk* entry = new (std::nothrow) CachedChunk;
+    if (entry == NULL) {
+        return NULL;
+    }
+    memset(entry->column, 0, sizeof(entry->column));
+    entry->key = key;
+    entry->status = 0;
+    entry->bytes = 0;
+    entry->pins = 0;
+    entry->loading = true;
+    entry->prefetched = false;
+    entry->newer = entry->older = NULL;
+    cache->chunks[key] = entry;
+    cache->loadsInProgress++;
+    return entry;
+}
+
+static void finishRead(ChunkCache* cache, CachedChunk* entry)
+{
+    entry->loading = false;
+    cache->loadsInProgress--;
+    cache->bytes += entry->bytes;
+    linkNewest(cache, entry);
+    evictOverBudget(cache);
+    cache->loaded.notify_all();
+}
+
+// follows the scan, and asks for the chunks ahead of it
+static void noteAccess(ChunkCache* cache, int dimension, int chunkX, int chunkZ)
+{
+    int dx = chunkX - cache->lastX;
+    int dz = chunkZ - cache->lastZ;
+    if (cache->haveLast && dimension == cache->lastDimension && dx == 0 && dz == 0) {
+        return;
+    }
+    bool step = cache->haveLast && dimension == cache->lastDimension && dx >= -1 && dx <= 1 && dz >= -1 && dz <= 1;
+    if (step && dx == cache->stepX && dz == cache->stepZ) {
+        for (int d = 1; d <= CHUNK_CACHE_PREFETCH_DISTANCE; d++) {
+            PrefetchRequest request = { dimension, chunkX + d * dx, chunkZ + d * dz };
+            if (cache->chunks.find(cacheKey(dimension, request.chunkX, request.chunkZ)) == cache->chunks.end()) {
+                if (cache->prefetchQueue.size() >= CHUNK_CACHE_PREFETCH_QUEUE) {
+                    cache->prefetchQueue.pop_front();
+                }
+                cache->prefetchQueue.push_back(request);
+            }
+        }
+        cache->prefetchWanted.notify_one();
+    }
+    cache->haveLast = true;
+    cache->lastDimension = dimension;
+    cache->lastX = chunkX;
+    cache->lastZ = chunkZ;
+    cache->stepX = step ? dx : 0;
+    cache->stepZ = step ? dz : 0;
+}
+
+static void prefetchChunks(ChunkCache* cache)
+{
+    std::vector<unsigned char> nbt;
+    std::unique_lock<std::mutex> guard(cache->lock);
+    for (;;) {
+        cache->prefetchWanted.wait(guard, [cache] { return cache->stopping || !cache->prefetchQueue.empty(); });
+        if (cache->stopping) {
+            return;
+        }
+        PrefetchRequest request = cache->prefetchQueue.front();
+        cache->prefetchQueue.pop_front();
+        unsigned long long key = cacheKey(request.dimension, request.chunkX, request.chunkZ);
+        if (cache->chunks.find(key) != cache->chunks.end()) {
+            continue;
+        }
+        CachedChunk* entry = startRead(cache, key);
+        if (entry == NULL) {
+            continue;
+        }
+        entry->prefetched = true;
+        cache->prefetches++;
+        guard.unlock();
+        readCachedChunk(cache, request.dimension, request.chunkX, request.chunkZ, entry, nbt);
+        guard.lock();
+        finishRead(cache, entry);
+    }
+}
+
+ChunkCache* createChunkCache(const wchar_t* worldDirectory, size_t budgetBytes)
+{
+    ChunkCache* cache = new (std::nothrow) ChunkCache;
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->worldDirectory = worldDirectory;
+    if (!cache->worldDirectory.empty() && cache->worldDirectory.back() != L'/' && cache->worldDirectory.back() != L'\\') {
+        cache->worldDirectory += L'/';
+    }
+    cache->budget = (budgetBytes > 0) ? budgetBytes : (size_t)CHUNK_CACHE_DEFAULT_CHUNKS * CHUNK_CACHE_BYTES_PER_CHUNK;
+    cache->newest = cache->oldest = NULL;
+    cache->bytes = 0;
+    cache->loadsInProgress = 0;
+    cache->haveLast = false;
+    cache->lastDimension = cache->lastX = cache->lastZ = 0;
+    cache->stepX = cache->stepZ = 0;
+    cache->stopping = false;
+    cache->hits = cache->misses = cache->evictions = cache->prefetches = cache->prefetchHits = 0;
+    cache->prefetcher = std::thread(prefetchChunks, cache);
+    return cache;
+}
+
+void clearChunkCache(ChunkCache* cache)
+{
+    std::unique_lock<std::mutex> guard(cache->lock);
+    cache->prefetchQueue.clear();
+    // reads in progress are using the region files
+    cache->loaded.wait(guard, [cache] { return cache->loadsInProgress == 0; });
+    CachedChunk* entry = cache->oldest;
+    while (entry != NULL) {
+        CachedChunk* newer = entry->newer;
+        if (entry->pins == 0) {
+            dropChunk(cache, entry);
+        }
+        entry = newer;
+    }
+    cache->haveLast = false;
+    // with the lock held no read can start, so the regions can go
+    closeCachedRegions(cache);
+}
+
+void destroyChunkCache(ChunkCache* cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(cache->lock);
+        cache->stopping = true;
+    }
+    cache->prefetchWanted.notify_all();
+    cache->prefetcher.join();
+    clearChunkCache(cache);
+    delete cache;
+}
+
+const PackedSection* acquireCachedChunk(ChunkCache* cache, int dimension, int chunkX, int chunkZ, int& status)
+{
+    unsigned long long key = cacheKey(dimension, chunkX, chunkZ);
+    std::unique_lock<std::mutex> guard(cache->lock);
+    noteAccess(cache, dimension, chunkX, chunkZ);
+    CachedChunk* entry;
+    std::unordered_map<unsigned long long, CachedChunk*>::iterator found = cache->chunks.find(key);
+    if (found != cache->chunks.end()) {
+        entry = found->second;
+        entry->pins++;
+        // perhaps still being read ahead of this scan, which is nearly as good
+        cache->loaded.wait(guard, [entry] { return !entry->loading; });
+        cache->hits++;
+        if (entry->prefetched) {
+            entry->prefetched = false;
+            cache->prefetchHits++;
+        }
+        unlink(cache, entry);
+        linkNewest(cache, entry);
+    }
+    else {
+        cache->misses++;
+        entry = startRead(cache, key);
+        if (entry == NULL) {
+            return NULL;
+        }
+        entry->pins++;
+        guard.unlock();
+        std::vector<unsigned char> nbt;
+        readCachedChunk(cache, dimension, chunkX, chunkZ, entry, nbt);
+        guard.lock();
+        finishRead(cache, entry);
+    }
+    status = entry->status;
+    return entry->column;
+}
+
+void releaseCachedChunk(ChunkCache* cache, const PackedSection* column)
+{
+    if (column == NULL) {
+        return;
+    }
+    CachedChunk* entry = (CachedChunk*)column;
+    std::lock_guard<std::mutex> guard(cache->lock);
+    entry->pins--;
+    // it may be all that kept the cache over its budget
+    if (entry->pins == 0 && cache->bytes > cache->budget) {
+        evictOverBudget(cache);
+    }
+}
+
+int readChunkCacheBox(ChunkCache* cache, int dimension, int minX, int minY, int minZ, int sizeX, int sizeY, int sizeZ, BlockLayout& layout)
+{
+    if (sizeX <= 0 || sizeY <= 0 || sizeZ <= 0) {
+        return LINE_ERROR;
+    }
+    layout.sizeX = sizeX;
+    layout.sizeY = sizeY;
+    layout.sizeZ = sizeZ;
+    size_t count = (size_t)sizeX * sizeY * sizeZ;
+    layout.type.resize(count);
+    layout.dataVal.resize(count);
+    int maxX = minX + sizeX - 1;
+    int maxZ = minZ + sizeZ - 1;
+    for (int chunkZ = minZ >> 4; chunkZ <= maxZ >> 4; chunkZ++) {
+        for (int chunkX = minX >> 4; chunkX <= maxX >> 4; chunkX++) {
+            int status;
+            const PackedSection* column = acquireCachedChunk(cache, dimension, chunkX, chunkZ, status);
+            if (column == NULL) {
+                return LINE_ERROR;
+            }
+            // the part of the box in this chunk
+            int x0 = (chunkX * 16 > minX) ? chunkX * 16 : minX;
+            int x1 = (chunkX * 16 + 15 < maxX) ? chunkX * 16 + 15 : maxX;
+            int z0 = (chunkZ * 16 > minZ) ? chunkZ * 16 : minZ;
+            int z1 = (chunkZ * 16 + 15 < maxZ) ? chunkZ * 16 + 15 : maxZ;
+            for (int y = 0; y < sizeY; y++) {
+                int worldY = minY + y;
+                int layer = (worldY - ABSOLUTE_MIN_MAP_HEIGHT) >> 4;
+                const PackedSection* section = (worldY >= ABSOLUTE_MIN_MAP_HEIGHT && layer < SECTION_STORE_LAYERS) ? &column[layer] : NULL;
+                for (int z = z0; z <= z1; z++) {
+                    size_t row = getBlockLayoutIndex(layout, x0 - minX, y, z - minZ);
+                    decodePackedSectionRow(section, x0 & 15, (worldY - ABSOLUTE_MIN_MAP_HEIGHT) & 15, z & 15, x1 - x0 + 1, &layout.type[row], &layout.dataVal[row]);
+                }
+            }
+            releaseCachedChunk(cache, column);
+        }
+    }
+    return 0;
+}
+
+void getChunkCacheStats(const ChunkCache* cache, ChunkCacheStats& stats)
+{
+    std::lock_guard<std::mutex> guard(cache->lock);
+    stats.hits = cache->hits;
+    stats.misses = cache->misses;
+    stats.evictions = cache->evictions;
+    stats.prefetches = cache->prefetches;
+    stats.prefetchHits = cache->prefetchHits;
+    stats.bytes = cache->bytes;
+    stats.budget = cache->budget;
+    stats.chunkCount = (int)cache->chunks.size();
+    unsigned long long lookups = stats.hits + stats.misses;
+    stats.hitRate = (lookups > 0) ? (double)stats.hits / (double)lookups : 0.0;
+}
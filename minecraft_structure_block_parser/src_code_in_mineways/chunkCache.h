@@ -0,0 +1,66 @@
+// chunkCache.h - keep a world's decoded chunks in memory, up to a byte budget, so overlapping exports read and decode each chunk once
+
+#pragma once
+
+#include <stddef.h>
+#include "blockLayout.h"
+#include "sectionStore.h"
+
+// Chunks are kept decoded, as a column of packed sections (sectionStore.h), so a cached chunk costs about
+// what its palettes and indices do rather than 3 bytes a block. Region files are opened the first time one
+// of their chunks is wanted, and stay open until the cache is cleared. When the chunks held go over the
+// budget, the least recently used are dropped, except those in use and those read ahead of a scan that
+// hasn't reached them yet. Two steps between neighbouring chunks in the same direction make a scan, and the
+// next CHUNK_CACHE_PREFETCH_DISTANCE chunks along it are then read and decoded on a thread of the cache's
+// own while the caller works on this one. Any number of threads may use one cache.
+
+typedef struct ChunkCache ChunkCache;
+
+typedef struct ChunkCacheStats {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long long prefetches;      // chunks read ahead of a scan
+    unsigned long long prefetchHits;    // of those, how many were then asked for before being dropped
+    size_t bytes;                       // held now
+    size_t budget;
+    int chunkCount;
+    double hitRate;     // hits / (hits + misses), 0 if nothing was asked for
+} ChunkCacheStats;
+
+// a cached chunk's share of the budget beyond its sections, for the map, the list, and its entry
+#define CHUNK_CACHE_ENTRY_BYTES         (sizeof(PackedSection) * SECTION_STORE_LAYERS + 128)
+// chunks read ahead along a scan
+#define CHUNK_CACHE_PREFETCH_DISTANCE   4
+// what Options::currentCacheSize counts, and the default when it's 0; a typical overworld chunk of
+// packed sections takes about 8 KiB, so this is room for some 4000
+#define CHUNK_CACHE_DEFAULT_CHUNKS      1024
+#define CHUNK_CACHE_BYTES_PER_CHUNK     (32 * 1024)
+
+// The budget the export options ask for: Options::currentCacheSize chunks, CHUNK_CACHE_DEFAULT_CHUNKS if
+// 0, of CHUNK_CACHE_BYTES_PER_CHUNK each, four times that with Options::moreExportMemory.
+size_t getChunkCacheBudget(const Options& options);
+
+// A cache for the world in worldDirectory, the folder holding level.dat, whose region files are in region,
+// DIM-1/region and DIM1/region. A budget of 0 means that of the default options. NULL if out of memory.
+ChunkCache* createChunkCache(const wchar_t* worldDirectory, size_t budgetBytes);
+// the chunks must all have been released
+void destroyChunkCache(ChunkCache* cache);
+// Drop every chunk not in use and close the region files, e.g. after the world was saved again; the
+// counters are kept.
+void clearChunkCache(ChunkCache* cache);
+
+// The column of SECTION_STORE_LAYERS sections, lowest first, of the chunk at world chunk coordinates chunkX,
+// chunkZ of a dimension (0 overworld, -1 nether, 1 end), read and decoded if it isn't cached, and kept
+// until released. status is 0 if the chunk was read, 1 if it has not been saved, negative if its region file
+// is missing or damaged or the chunk can't be read; for all of them there is a column, of air unless the
+// status is 0, which must be released. NULL only if out of memory.
+const PackedSection* acquireCachedChunk(ChunkCache* cache, int dimension, int chunkX, int chunkZ, int& status);
+void releaseCachedChunk(ChunkCache* cache, const PackedSection* column);
+
+// The box with corner minX, minY, minZ of a dimension into a layout of sizeX x sizeY x sizeZ, chunk by
+// chunk, x fastest, so the cache sees a scan. Chunks that haven't been saved, or can't be read, are air.
+// Returns 0 on success, negative on error.
+int readChunkCacheBox(ChunkCache* cache, int dimension, int minX, int minY, int minZ, int sizeX, int sizeY, int sizeZ, BlockLayout& layout);
+
+void getChunkCacheStats(const ChunkCache* cache, ChunkCacheStats& stats);
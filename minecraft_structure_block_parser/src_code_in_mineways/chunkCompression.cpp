@@ -0,0 +1,310 @@
+// chunkCompression.cpp - decompress region file chunks, whichever of Minecraft's compression types they use
+
+#include "stdafx.h"
+#include <string.h>
+#include <vector>
+#ifdef CHUNK_USE_LIBDEFLATE
+#include <libdeflate.h>
+#else
+#include <zlib.h>
+#endif
+#include "chunkCompression.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// no chunk inflates to more than this; stops a damaged length from asking for all of memory
+#define MAX_CHUNK_NBT_SIZE (256 * 1024 * 1024)
+
+// a first guess at how much bigger inflated chunk NBT is
+#define INFLATE_RATIO_GUESS 8
+
+static size_t firstGuess(const unsigned char* data, size_t size, bool gzip)
+{
+    // gzip ends with the inflated size
+    if (gzip && size >= 18) {
+        size_t stored = (size_t)data[size - 4] | ((size_t)data[size - 3] << 8) | ((size_t)data[size - 2] << 16) | ((size_t)data[size - 1] << 24);
+        if (stored > 0 && stored <= MAX_CHUNK_NBT_SIZE) {
+            return stored;
+        }
+    }
+    size_t guess = size * INFLATE_RATIO_GUESS;
+    return (guess < 4096) ? 4096 : ((guess > MAX_CHUNK_NBT_SIZE) ? MAX_CHUNK_NBT_SIZE : guess);
+}
+
+#ifdef CHUNK_USE_LIBDEFLATE
+
+// a decompressor for each thread, freed when the thread ends
+struct ThreadDecompressor {
+    libdeflate_decompressor* decompressor;
+    ThreadDecompressor() : decompressor(libdeflate_alloc_decompressor()) {}
+    ~ThreadDecompressor()
+    {
+        if (decompressor != NULL) {
+            libdeflate_free_decompressor(decompressor);
+        }
+    }
+};
+
+static int inflateData(const unsigned char* data, size_t size, std::vector<unsigned char>& out, bool gzip)
+{
+    static thread_local ThreadDecompressor threadDecompressor;
+    libdeflate_decompressor* decompressor = threadDecompressor.decompressor;
+    if (decompressor == NULL) {
+        return LINE_ERROR;
+    }
+    out.resize(firstGuess(data, size, gzip));
+    for (;;) {
+        size_t produced = 0;
+        libdeflate_result result = gzip ?
+            libdeflate_gzip_decompress(decompressor, data, size, out.data(), out.size(), &produced) :
+            libdeflate_zlib_decompress(decompressor, data, size, out.data(), out.size(), &produced);
+        if (result == LIBDEFLATE_SUCCESS) {
+            out.resize(produced);
+            return 0;
+        }
+        // libdeflate inflates in one go, so it starts again with more room
+        if (result != LIBDEFLATE_INSUFFICIENT_SPACE || out.size() >= MAX_CHUNK_NBT_SIZE) {
+            return LINE_ERROR;
+        }
+        out.resize(out.size() * 2);
+    }
+}
+
+#else
+
+static int inflateData(const unsigned char* data, size_t size, std::vector<unsigned char>& out, bool gzip)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // 16 more window bits for a gzip wrapper
+    if (inflateInit2(&zs, gzip ? 15 + 16 : 15) != Z_OK) {
+        return LINE_ERROR;
+    }
+    out.resize(firstGuess(data, size, gzip));
+    zs.next_in = (Bytef*)data;
+    zs.avail_in = (uInt)size;
+    size_t produced = 0;
+    int status = Z_OK;
+    while (status == Z_OK) {
+        if (produced == out.size()) {
+            if (out.size() >= MAX_CHUNK_NBT_SIZE) {
+                break;
+            }
+            out.resize(out.size() * 2);
+        }
+        zs.next_out = out.data() + produced;
+        zs.avail_out = (uInt)(out.size() - produced);
+        status = inflate(&zs, Z_NO_FLUSH);
+        produced = out.size() - zs.avail_out;
+    }
+    inflateEnd(&zs);
+    if (status != Z_STREAM_END) {
+        return LINE_ERROR;
+    }
+    out.resize(produced);
+    return 0;
+}
+
+#endif
+
+static int decompressGzip(const unsigned char* data, size_t size, std::vector<unsigned char>& out)
+{
+    return inflateData(data, size, out, true);
+}
+
+static int decompressZlib(const unsigned char* data, size_t size, std::vector<unsigned char>& out)
+{
+    return inflateData(data, size, out, false);
+}
+
+static int decompressNone(const unsigned char* data, size_t size, std::vector<unsigned char>& out)
+{
+    out.assign(data, data + size);
+    return 0;
+}
+
+static unsigned int readLittleInt(const unsigned char* p)
+{
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+// One LZ4 block, as sequences of literals and matches, into out, which must have room for exactly
+// the block's original size. Returns false if the block is damaged.
+static bool decodeLz4Block(const unsigned char* in, size_t inSize, unsigned char* out, size_t outSize)
+{
+    const unsigned char* inEnd = in + inSize;
+    unsigned char* op = out;
+    unsigned char* outEnd = out + outSize;
+    for (;;) {
+        if (in >= inEnd) {
+            return false;
+        }
+        int token = *in++;
+        size_t length = token >> 4;
+        if (length == 15) {
+            int more;
+            do {
+                if (in >= inEnd) {
+                    return false;
+                }
+                more = *in++;
+                length += more;
+            } while (more == 255);
+        }
+        if ((size_t)(inEnd - in) < length || (size_t)(outEnd - op) < length) {
+            return false;
+        }
+        memcpy(op, in, length);
+        in += length;
+        op += length;
+        // the last sequence is literals only
+        if (in == inEnd) {
+            return op == outEnd;
+        }
+
+        if (inEnd - in < 2) {
+            return false;
+        }
+        size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        if (offset == 0 || offset > (size_t)(op - out)) {
+            return false;
+        }
+        length = (token & 15) + 4;
+        if ((token & 15) == 15) {
+            int more;
+            do {
+                if (in >= inEnd) {
+                    return false;
+                }
+                more = *in++;
+                length += more;
+            } while (more == 255);
+        }
+        if ((size_t)(outEnd - op) < length) {
+            return false;
+        }
+        // matches may overlap what they copy, to repeat a short run
+        const unsigned char* match = op - offset;
+        if (offset >= length) {
+            memcpy(op, match, length);
+            op += length;
+        }
+        else {
+            // a run repeats every offset bytes, so copy it a whole period at a time
+            while (length > 0) {
+                size_t step = (length < offset) ? length : offset;
+                memcpy(op, op - offset, step);
+                op += step;
+                length -= step;
+            }
+        }
+    }
+}
+
+// Minecraft writes LZ4 chunks with lz4-java's LZ4BlockOutputStream: blocks of up to 64 KiB, each with the
+// header below, then an empty block to end it. The checksum, an xxHash32 of the original block, is not
+// checked; a damaged block is still caught by the decoder's bounds checks.
+#define LZ4_BLOCK_MAGIC         "LZ4Block"
+#define LZ4_BLOCK_HEADER_SIZE   21      // magic, token, compressed length, original length, checksum
+#define LZ4_METHOD_RAW          0x10
+#define LZ4_METHOD_LZ4          0x20
+
+static int decompressLz4(const unsigned char* data, size_t size, std::vector<unsigned char>& out)
+{
+    out.clear();
+    size_t p = 0;
+    for (;;) {
+        if (size - p < LZ4_BLOCK_HEADER_SIZE || memcmp(data + p, LZ4_BLOCK_MAGIC, 8) != 0) {
+            return LINE_ERROR;
+        }
+        int method = data[p + 8] & 0xf0;
+        size_t compressedLength = readLittleInt(data + p + 9);
+        size_t originalLength = readLittleInt(data + p + 13);
+        p += LZ4_BLOCK_HEADER_SIZE;
+        if (originalLength == 0) {
+            return 0;
+        }
+        if (compressedLength > size - p || out.size() + originalLength > MAX_CHUNK_NBT_SIZE) {
+            return LINE_ERROR;
+        }
+        size_t start = out.size();
+        out.resize(start + originalLength);
+        if (method == LZ4_METHOD_RAW) {
+            if (compressedLength != originalLength) {
+                return LINE_ERROR;
+            }
+            memcpy(out.data() + start, data + p, originalLength);
+        }
+        else if (method != LZ4_METHOD_LZ4 || !decodeLz4Block(data + p, compressedLength, out.data() + start, originalLength)) {
+            return LINE_ERROR;
+        }
+        p += compressedLength;
+    }
+}
+
+static const ChunkDecompressor gBuiltInDecompressors[] = {
+#ifdef CHUNK_USE_LIBDEFLATE
+    { "gzip (libdeflate)", CHUNK_COMPRESSION_GZIP, decompressGzip },
+    { "zlib (libdeflate)", CHUNK_COMPRESSION_ZLIB, decompressZlib },
+#else
+    { "gzip (zlib)", CHUNK_COMPRESSION_GZIP, decompressGzip },
+    { "zlib (zlib)", CHUNK_COMPRESSION_ZLIB, decompressZlib },
+#endif
+    { "uncompressed", CHUNK_COMPRESSION_NONE, decompressNone },
+    { "lz4", CHUNK_COMPRESSION_LZ4, decompressLz4 },
+};
+
+static const ChunkDecompressor* gDecompressors[CHUNK_COMPRESSION_CUSTOM + 1];
+
+static bool putBuiltInDecompressors()
+{
+    for (size_t i = 0; i < sizeof(gBuiltInDecompressors) / sizeof(gBuiltInDecompressors[0]); i++) {
+        gDecompressors[gBuiltInDecompressors[i].compressionType] = &gBuiltInDecompressors[i];
+    }
+    return true;
+}
+
+static const ChunkDecompressor* const* getDecompressors()
+{
+    static bool built = putBuiltInDecompressors();
+    (void)built;
+    return gDecompressors;
+}
+
+const ChunkDecompressor* getChunkDecompressor(int compressionType)
+{
+    compressionType &= ~CHUNK_COMPRESSION_EXTERNAL;
+    // a damaged region file can say anything here, and only 1-127 have a slot
+    if (compressionType <= 0 || compressionType > CHUNK_COMPRESSION_CUSTOM) {
+        return NULL;
+    }
+    return getDecompressors()[compressionType];
+}
+
+bool setChunkDecompressor(int compressionType, const ChunkDecompressor* decompressor)
+{
+    if (compressionType <= 0 || compressionType > CHUNK_COMPRESSION_CUSTOM) {
+        return false;
+    }
+    getDecompressors();
+    gDecompressors[compressionType] = decompressor;
+    if (decompressor == NULL) {
+        for (size_t i = 0; i < sizeof(gBuiltInDecompressors) / sizeof(gBuiltInDecompressors[0]); i++) {
+            if (gBuiltInDecompressors[i].compressionType == compressionType) {
+                gDecompressors[compressionType] = &gBuiltInDecompressors[i];
+            }
+        }
+    }
+    return true;
+}
+
+int decompressChunk(int compressionType, const unsigned char* data, size_t size, std::vector<unsigned char>& out)
+{
+    const ChunkDecompressor* decompressor = getChunkDecompressor(compressionType);
+    if (decompressor == NULL) {
+        return LINE_ERROR;
+    }
+    return decompressor->decompress(data, size, out);
+}
@@ -0,0 +1,37 @@
+// chunkCompression.h - decompress region file chunks, whichever of Minecraft's compression types they use
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+// The byte after each chunk's length in a region file (regionFile.h)
+#define CHUNK_COMPRESSION_GZIP      1
+#define CHUNK_COMPRESSION_ZLIB      2
+#define CHUNK_COMPRESSION_NONE      3
+// 1.20.5 and later, with region-file-compression=lz4 in server.properties
+#define CHUNK_COMPRESSION_LZ4       4
+// a namespaced algorithm named in the chunk, which no backend here knows
+#define CHUNK_COMPRESSION_CUSTOM    127
+// added to the type when the chunk is too big for the region file and is in its own c.X.Z.mcc file
+#define CHUNK_COMPRESSION_EXTERNAL  0x80
+
+// A backend decompresses one compression type. The built-in ones use zlib for gzip and zlib data, or
+// libdeflate, which is about twice as fast, when built with CHUNK_USE_LIBDEFLATE defined; LZ4 and
+// uncompressed data need no library. Another backend can be put in place of any of them.
+typedef struct ChunkDecompressor {
+    const char* name;
+    int compressionType;
+    // All of data, replacing what's in out. Returns 0 on success, negative on error.
+    int (*decompress)(const unsigned char* data, size_t size, std::vector<unsigned char>& out);
+} ChunkDecompressor;
+
+// the backend for a compression type, without the CHUNK_COMPRESSION_EXTERNAL bit, or NULL if there's none,
+// as for any type outside 1-127 once that bit is taken off
+const ChunkDecompressor* getChunkDecompressor(int compressionType);
+// Use this backend for its compression type from now on; NULL for decompressor puts back the built-in one
+// for compressionType. Not to be called while chunks are being read. Returns false if the type is not 1-127.
+bool setChunkDecompressor(int compressionType, const ChunkDecompressor* decompressor);
+
+// Returns 0 on success, negative on error, including for a type with no backend.
+int decompressChunk(int compressionType, const unsigned char* data, size_t size, std::vector<unsigned char>& out);
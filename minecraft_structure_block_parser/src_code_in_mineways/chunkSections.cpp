@@ -0,0 +1,208 @@
+// chunkSections.cpp - find the block sections of a Java chunk's NBT and unpack their palette indices, without copying the NBT
+
+#include "stdafx.h"
+#include <string.h>
+#include "nbtView.h"
+#include "chunkSections.h"
+
+// a section's palette can't usefully be bigger than the section
+#define MAX_SECTION_PALETTE SECTION_BLOCKS
+
+static unsigned long long readBigLong(const unsigned char* p)
+{
+    return ((unsigned long long)p[0] << 56) | ((unsigned long long)p[1] << 48) | ((unsigned long long)p[2] << 40) | ((unsigned long long)p[3] << 32) |
+        ((unsigned long long)p[4] << 24) | ((unsigned long long)p[5] << 16) | ((unsigned long long)p[6] << 8) | (unsigned long long)p[7];
+}
+
+bool getChunkSections(const NbtView& view, int& chunkX, int& chunkZ, NbtTag& sections)
+{
+    NbtTag root, level, tag;
+    if (!nbtGetRoot(view, root)) {
+        return false;
+    }
+    // 1.18 moved Level's contents up to the root, and renamed Sections
+    const NbtTag* holder = &root;
+    const char* sectionsName = "sections";
+    if (nbtFindChild(view, root, "Level", level)) {
+        holder = &level;
+        sectionsName = "Sections";
+    }
+    if (!nbtFindChild(view, *holder, "xPos", tag)) {
+        return false;
+    }
+    chunkX = nbtGetInt(view, tag);
+    if (!nbtFindChild(view, *holder, "zPos", tag)) {
+        return false;
+    }
+    chunkZ = nbtGetInt(view, tag);
+    if (chunkX < -MAX_CHUNK_COORDINATE || chunkX > MAX_CHUNK_COORDINATE || chunkZ < -MAX_CHUNK_COORDINATE || chunkZ > MAX_CHUNK_COORDINATE) {
+        return false;
+    }
+    return nbtFindChild(view, *holder, sectionsName, sections) && sections.type == NBT_TAG_LIST;
+}
+
+// checks the palette and data, and works out how the indices are packed
+static bool fitSection(const NbtView& view, const NbtTag& palette, const NbtTag* data, ChunkSection& section)
+{
+    int elementType;
+    const unsigned char* elements;
+    if (!nbtGetArray(view, palette, elementType, section.paletteCount, elements) || elementType != NBT_TAG_COMPOUND ||
+        section.paletteCount < 1 || section.paletteCount > MAX_SECTION_PALETTE) {
+        return false;
+    }
+    section.palette = palette;
+    section.bits = 0;
+    section.data = NULL;
+    section.longCount = 0;
+    section.spanning = false;
+    if (data == NULL) {
+        // only 1.18's single-entry palettes may go without
+        return section.paletteCount == 1;
+    }
+    if (!nbtGetArray(view, *data, elementType, section.longCount, section.data) || elementType != NBT_TAG_LONG) {
+        return false;
+    }
+    section.bits = 4;
+    while ((1 << section.bits) < section.paletteCount) {
+        section.bits++;
+    }
+    int perLong = 64 / section.bits;
+    if (section.longCount == (SECTION_BLOCKS + perLong - 1) / perLong) {
+        return true;
+    }
+    // before 1.16; the same as the above when bits divides 64
+    section.spanning = true;
+    return section.longCount == SECTION_BLOCKS * section.bits / 64;
+}
+
+bool nextChunkSection(const NbtView& view, NbtIterator& it, ChunkSection& section)
+{
+    NbtTag tag;
+    while (nbtNext(view, it, tag)) {
+        if (tag.type != NBT_TAG_COMPOUND) {
+            continue;
+        }
+        // one pass over the section's tags, as the palette and data may come in any order
+        NbtTag palette, data, child;
+        bool havePalette = false, haveData = false, haveY = false;
+        NbtIterator sectionIt, statesIt;
+        nbtIterate(view, tag, sectionIt);
+        while (nbtNext(view, sectionIt, child)) {
+            if (nbtNameIs(child, "Y")) {
+                section.sectionY = nbtGetInt(view, child);
+                haveY = section.sectionY >= MIN_SECTION_Y && section.sectionY <= MAX_SECTION_Y;
+            }
+            else if (nbtNameIs(child, "block_states") && child.type == NBT_TAG_COMPOUND) {
+                NbtTag state;
+                nbtIterate(view, child, statesIt);
+                while (nbtNext(view, statesIt, state)) {
+                    if (nbtNameIs(state, "palette")) {
+                        palette = state;
+                        havePalette = true;
+                    }
+                    else if (nbtNameIs(state, "data")) {
+                        data = state;
+                        haveData = true;
+                    }
+                }
+            }
+            else if (nbtNameIs(child, "Palette")) {
+                palette = child;
+                havePalette = true;
+            }
+            else if (nbtNameIs(child, "BlockStates")) {
+                data = child;
+                haveData = true;
+            }
+        }
+        if (haveY && havePalette && fitSection(view, palette, haveData ? &data : NULL, section)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool getPaletteEntryName(const NbtView& view, const NbtTag& entry, const char*& name, int& length)
+{
+    NbtTag tag;
+    if (!nbtFindChild(view, entry, "Name", tag) || !nbtGetString(view, tag, name, length)) {
+        return false;
+    }
+    if (length >= 10 && strncmp(name, "minecraft:", 10) == 0) {
+        name += 10;
+        length -= 10;
+    }
+    return true;
+}
+
+void unpackSectionIndices(const ChunkSection& section, unsigned short indices[SECTION_BLOCKS])
+{
+    if (section.bits == 0) {
+        memset(indices, 0, SECTION_BLOCKS * sizeof(indices[0]));
+        return;
+    }
+    const int bits = section.bits;
+    const unsigned long long mask = (1ull << bits) - 1;
+    if (!section.spanning) {
+        int perLong = 64 / bits;
+        int i = 0;
+        for (int l = 0; i < SECTION_BLOCKS; l++) {
+            unsigned long long value = readBigLong(section.data + l * 8);
+            int end = (i + perLong < SECTION_BLOCKS) ? i + perLong : SECTION_BLOCKS;
+            for (; i < end; i++) {
+                indices[i] = (unsigned short)(value & mask);
+                value >>= bits;
+            }
+        }
+    }
+    else {
+        for (int i = 0; i < SECTION_BLOCKS; i++) {
+            int bit = i * bits;
+            int l = bit >> 6;
+            int shift = bit & 63;
+            unsigned long long value = readBigLong(section.data + l * 8) >> shift;
+            if (shift + bits > 64) {
+                value |= readBigLong(section.data + (l + 1) * 8) << (64 - shift);
+            }
+            indices[i] = (unsigned short)(value & mask);
+        }
+    }
+}
+
+void countSectionIndices(const ChunkSection& section, unsigned int* counts)
+{
+    const int bits = section.bits;
+    if (bits == 0) {
+        for (int y = 0; y < 16; y++) {
+            counts[y] = SECTION_BLOCKS / 16;
+        }
+        return;
+    }
+    memset(counts, 0, ((size_t)16 << bits) * sizeof(counts[0]));
+    const unsigned long long mask = (1ull << bits) - 1;
+    if (!section.spanning) {
+        int perLong = 64 / bits;
+        int i = 0;
+        for (int l = 0; i < SECTION_BLOCKS; l++) {
+            unsigned long long value = readBigLong(section.data + l * 8);
+            int end = (i + perLong < SECTION_BLOCKS) ? i + perLong : SECTION_BLOCKS;
+            for (; i < end; i++) {
+                // i >> 8 is the layer
+                counts[((i >> 8) << bits) + (int)(value & mask)]++;
+                value >>= bits;
+            }
+        }
+    }
+    else {
+        for (int i = 0; i < SECTION_BLOCKS; i++) {
+            int bit = i * bits;
+            int l = bit >> 6;
+            int shift = bit & 63;
+            unsigned long long value = readBigLong(section.data + l * 8) >> shift;
+            if (shift + bits > 64) {
+                value |= readBigLong(section.data + (l + 1) * 8) << (64 - shift);
+            }
+            counts[((i >> 8) << bits) + (int)(value & mask)]++;
+        }
+    }
+}
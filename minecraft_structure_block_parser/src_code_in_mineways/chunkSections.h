@@ -0,0 +1,57 @@
+// chunkSections.h - find the block sections of a Java chunk's NBT and unpack their palette indices, without copying the NBT
+
+#pragma once
+
+#include "nbtView.h"
+
+// Since 1.13 each 16 x 16 x 16 section of a chunk has its own palette of block states, {Name, Properties},
+// and a long array of indices into it, the fewest bits that fit the palette but no fewer than 4, first
+// index in the lowest bits. Since 1.16 an index never spans two longs, so some high bits of each long go
+// unused; before, indices are packed end to end. Since 1.18 the sections are the root's "sections", each with
+// "block_states" {palette, data}, and a section whose palette has one entry has no data at all; before, they
+// are Level's "Sections", each with "Palette" and "BlockStates". Chunks from before 1.13 have no palettes
+// and are not read here.
+
+#define SECTION_BLOCKS      4096
+// chunks beyond the 30,000,000 block world border, and sections outside what a byte Y can say, are damage;
+// keeping within them also keeps block coordinates, chunk or section times 16, well inside an int
+#define MAX_CHUNK_COORDINATE    (30000000 / 16 + 1)
+#define MIN_SECTION_Y           (-128)
+#define MAX_SECTION_Y           127
+
+typedef struct ChunkSection {
+    int sectionY;                   // holds blocks sectionY * 16 through sectionY * 16 + 15
+    NbtTag palette;                 // list of {Name, Properties} compounds
+    int paletteCount;
+    int bits;                       // per index; 0 for a section with one palette entry and no data
+    const unsigned char* data;      // big-endian longs; NULL if bits is 0
+    int longCount;
+    bool spanning;                  // indices packed end to end, as before 1.16
+} ChunkSection;
+
+// Where in an unpacked section a block is.
+inline int sectionBlockIndex(int x, int y, int z)
+{
+    return (y << 8) | (z << 4) | x;
+}
+
+// The chunk's world chunk coordinates and its list of sections. False if there are none, as for a chunk
+// saved before 1.13, or a damaged one, such as one whose coordinates are beyond MAX_CHUNK_COORDINATE.
+bool getChunkSections(const NbtView& view, int& chunkX, int& chunkZ, NbtTag& sections);
+
+// The next section with blocks, after nbtIterate() on the sections list; false at the end of the list.
+// Sections with no palette, such as the empty ones just above and below the world, are passed over, as
+// are sections whose data can't hold 4096 indices, or whose Y is outside MIN_SECTION_Y to MAX_SECTION_Y.
+bool nextChunkSection(const NbtView& view, NbtIterator& it, ChunkSection& section);
+
+// A palette entry's Name, without "minecraft:"; false if it has none.
+bool getPaletteEntryName(const NbtView& view, const NbtTag& entry, const char*& name, int& length);
+
+// All 4096 indices, at sectionBlockIndex(). Indices are not checked against the palette, but each is below
+// 1 << bits. A section with no data unpacks to all 0s.
+void unpackSectionIndices(const ChunkSection& section, unsigned short indices[SECTION_BLOCKS]);
+
+// How many of each index are in each of the section's 16 layers, counted straight from the packed data:
+// layer y's counts are at counts + (y << bits), 1 << bits of them, and are set, not added to. A section with
+// no data has 256 of index 0 in each layer, at counts[y].
+void countSectionIndices(const ChunkSection& section, unsigned int* counts);
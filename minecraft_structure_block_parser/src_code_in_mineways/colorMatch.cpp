@@ -0,0 +1,379 @@
+// colorMatch.cpp - find the block whose color best matches an RGB color, for map art and image-to-build conversion
+
+#include "stdafx.h"
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "colorMatch.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define COLOR_MATCH_SSE
+#include <emmintrin.h>
+#endif
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// entries per k-d tree leaf; two SSE compares
+#define KD_LEAF_SIZE 8
+
+static float gSrgbToLinear[256];
+
+static bool makeSrgbToLinear()
+{
+    for (int i = 0; i < 256; i++) {
+        float c = (float)i / 255.0f;
+        gSrgbToLinear[i] = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    return true;
+}
+
+// https://bottosson.github.io/posts/oklab/
+void rgbToOklab(unsigned int rgb, float lab[3])
+{
+    // filled once, by whichever thread gets here first, with the others waiting for it
+    static const bool made = makeSrgbToLinear();
+    (void)made;
+    float r = gSrgbToLinear[(rgb >> 16) & 0xff];
+    float g = gSrgbToLinear[(rgb >> 8) & 0xff];
+    float b = gSrgbToLinear[rgb & 0xff];
+
+    float l = cbrtf(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+    float m = cbrtf(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    float s = cbrtf(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+
+    lab[0] = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+    lab[1] = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+    lab[2] = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+}
+
+///////////////////////////////////////////////////////////////////
+// k-d tree
+
+static int buildKdNode(ColorMatchIndex& index, std::vector<int>& ids, int start, int count)
+{
+    int nodeIndex = (int)index.nodes.size();
+    index.nodes.push_back(ColorMatchKdNode());
+
+    if (count <= KD_LEAF_SIZE) {
+        ColorMatchKdNode leaf;
+        leaf.axis = -1;
+        leaf.split = 0.0f;
+        leaf.child[0] = (int)index.leafEntry.size();
+        leaf.child[1] = (count + 3) & ~3;
+        for (int i = 0; i < leaf.child[1]; i++) {
+            if (i < count) {
+                int id = ids[start + i];
+                index.leafL.push_back(index.lab[id * 3]);
+                index.leafA.push_back(index.lab[id * 3 + 1]);
+                index.leafB.push_back(index.lab[id * 3 + 2]);
+                index.leafEntry.push_back(id);
+            }
+            else {
+                // padding, far from everything
+                index.leafL.push_back(1e18f);
+                index.leafA.push_back(1e18f);
+                index.leafB.push_back(1e18f);
+                index.leafEntry.push_back(-1);
+            }
+        }
+        index.nodes[nodeIndex] = leaf;
+        return nodeIndex;
+    }
+
+    // split on the axis with the largest spread, at the median
+    float lo[3], hi[3];
+    for (int c = 0; c < 3; c++) {
+        lo[c] = hi[c] = index.lab[ids[start] * 3 + c];
+    }
+    for (int i = start + 1; i < start + count; i++) {
+        for (int c = 0; c < 3; c++) {
+            float v = index.lab[ids[i] * 3 + c];
+            lo[c] = (v < lo[c]) ? v : lo[c];
+            hi[c] = (v > hi[c]) ? v : hi[c];
+        }
+    }
+    int axis = 0;
+    for (int c = 1; c < 3; c++) {
+        if (hi[c] - lo[c] > hi[axis] - lo[axis]) {
+            axis = c;
+        }
+    }
+    int half = count / 2;
+    const std::vector<float>& lab = index.lab;
+    std::nth_element(ids.begin() + start, ids.begin() + start + half, ids.begin() + start + count,
+        [&lab, axis](int a, int b) { return lab[a * 3 + axis] < lab[b * 3 + axis]; });
+
+    ColorMatchKdNode node;
+    node.axis = axis;
+    node.split = index.lab[ids[start + half] * 3 + axis];
+    node.child[0] = buildKdNode(index, ids, start, half);
+    node.child[1] = buildKdNode(index, ids, start + half, count - half);
+    index.nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+// ties go to the lower entry index, so the cube and the exact search always agree
+static inline void considerCandidate(float dist, int entry, float& bestDist, int& best)
+{
+    if (dist < bestDist || (dist == bestDist && entry >= 0 && entry < best)) {
+        bestDist = dist;
+        best = entry;
+    }
+}
+
+static void searchKd(const ColorMatchIndex& index, int nodeIndex, const float q[3], float& bestDist, int& best)
+{
+    const ColorMatchKdNode& node = index.nodes[nodeIndex];
+    if (node.axis < 0) {
+        int i = node.child[0];
+        int end = i + node.child[1];
+#ifdef COLOR_MATCH_SSE
+        __m128 qL = _mm_set1_ps(q[0]);
+        __m128 qA = _mm_set1_ps(q[1]);
+        __m128 qB = _mm_set1_ps(q[2]);
+        for (; i < end; i += 4) {
+            __m128 dL = _mm_sub_ps(_mm_loadu_ps(&index.leafL[i]), qL);
+            __m128 dA = _mm_sub_ps(_mm_loadu_ps(&index.leafA[i]), qA);
+            __m128 dB = _mm_sub_ps(_mm_loadu_ps(&index.leafB[i]), qB);
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dL, dL), _mm_mul_ps(dA, dA)), _mm_mul_ps(dB, dB));
+            // skip the scalar work when none of the four can win
+            if (_mm_movemask_ps(_mm_cmple_ps(dist, _mm_set1_ps(bestDist))) == 0) {
+                continue;
+            }
+            float d4[4];
+            _mm_storeu_ps(d4, dist);
+            for (int k = 0; k < 4; k++) {
+                considerCandidate(d4[k], index.leafEntry[i + k], bestDist, best);
+            }
+        }
+#else
+        for (; i < end; i++) {
+            float dL = index.leafL[i] - q[0];
+            float dA = index.leafA[i] - q[1];
+            float dB = index.leafB[i] - q[2];
+            considerCandidate(dL * dL + dA * dA + dB * dB, index.leafEntry[i], bestDist, best);
+        }
+#endif
+        return;
+    }
+    float d = q[node.axis] - node.split;
+    int nearChild = (d < 0.0f) ? 0 : 1;
+    searchKd(index, node.child[nearChild], q, bestDist, best);
+    if (d * d <= bestDist) {
+        searchKd(index, node.child[1 - nearChild], q, bestDist, best);
+    }
+}
+
+int findNearestColorEntryExact(const ColorMatchIndex& index, unsigned int rgb)
+{
+    if (index.nodes.empty()) {
+        return -1;
+    }
+    float q[3];
+    rgbToOklab(rgb, q);
+    float bestDist = 3.0e38f;
+    int best = 0x7fffffff;
+    searchKd(index, 0, q, bestDist, best);
+    return best;
+}
+
+static inline int cubeCell(unsigned int rgb)
+{
+    return ((rgb >> 19) & 0x1f) << 10 | ((rgb >> 11) & 0x1f) << 5 | ((rgb >> 3) & 0x1f);
+}
+
+// fill in the exact answer for every color in an unresolved cell
+static unsigned short* refineCell(const ColorMatchIndex& index, int cell)
+{
+    unsigned short* answers = (unsigned short*)malloc(512 * sizeof(unsigned short));
+    if (answers == NULL) {
+        return NULL;
+    }
+    unsigned int base = ((unsigned int)(cell >> 10) << 19) | ((unsigned int)((cell >> 5) & 0x1f) << 11) | ((unsigned int)(cell & 0x1f) << 3);
+    for (unsigned int i = 0; i < 512; i++) {
+        answers[i] = (unsigned short)findNearestColorEntryExact(index, base | ((i >> 6) << 16) | (((i >> 3) & 0x7) << 8) | (i & 0x7));
+    }
+    // another thread may have beaten us to it; keep whichever got there first
+    unsigned short* expected = NULL;
+    if (!index.refined[cell].compare_exchange_strong(expected, answers)) {
+        free(answers);
+        return expected;
+    }
+    return answers;
+}
+
+int findNearestColorEntry(const ColorMatchIndex& index, unsigned int rgb)
+{
+    if (!index.cube.empty()) {
+        int cell = cubeCell(rgb);
+        unsigned short entry = index.cube[cell];
+        if (entry != COLOR_MATCH_UNRESOLVED) {
+            return entry;
+        }
+        unsigned short* answers = index.refined[cell].load(std::memory_order_acquire);
+        if (answers == NULL) {
+            answers = refineCell(index, cell);
+        }
+        if (answers != NULL) {
+            return answers[((rgb >> 16) & 0x7) << 6 | ((rgb >> 8) & 0x7) << 3 | (rgb & 0x7)];
+        }
+    }
+    return findNearestColorEntryExact(index, rgb);
+}
+
+///////////////////////////////////////////////////////////////////
+// Building
+
+static int getThreadCount(int threadCount)
+{
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+    }
+    return (threadCount <= 0) ? 1 : threadCount;
+}
+
+void freeColorMatchIndex(ColorMatchIndex& index)
+{
+    for (size_t i = 0; i < index.refined.size(); i++) {
+        free(index.refined[i].load());
+    }
+    std::vector<std::atomic<unsigned short*>>().swap(index.refined);
+    std::vector<ColorMatchEntry>().swap(index.entries);
+    std::vector<float>().swap(index.lab);
+    std::vector<unsigned short>().swap(index.cube);
+    std::vector<ColorMatchKdNode>().swap(index.nodes);
+    std::vector<float>().swap(index.leafL);
+    std::vector<float>().swap(index.leafA);
+    std::vector<float>().swap(index.leafB);
+    std::vector<int>().swap(index.leafEntry);
+}
+
+int buildColorMatchIndex(ColorMatchIndex& index, const ColorMatchEntry* entries, int count)
+{
+    freeColorMatchIndex(index);
+    if (count <= 0 || count > COLOR_MATCH_MAX_ENTRIES) {
+        return LINE_ERROR;
+    }
+
+    index.entries.assign(entries, entries + count);
+    index.lab.resize(count * 3);
+    std::vector<int> ids(count);
+    for (int i = 0; i < count; i++) {
+        rgbToOklab(entries[i].color, &index.lab[i * 3]);
+        ids[i] = i;
+    }
+    buildKdNode(index, ids, 0, count);
+
+    // Nearest entry for every corner of every cube cell. Cell k covers channel values 8k..8k+7, so the
+    // corners are at 0,7,8,15,...,248,255: 64 values per channel.
+    const int grid = 64;
+    std::vector<unsigned short> corner(grid * grid * grid);
+    std::atomic<int> nextR(0);
+    auto cornerWorker = [&]() {
+        int r;
+        while ((r = nextR++) < grid) {
+            unsigned int rv = (unsigned int)((r / 2) * 8 + (r % 2) * 7);
+            for (int g = 0; g < grid; g++) {
+                unsigned int gv = (unsigned int)((g / 2) * 8 + (g % 2) * 7);
+                for (int b = 0; b < grid; b++) {
+                    unsigned int bv = (unsigned int)((b / 2) * 8 + (b % 2) * 7);
+                    corner[(r * grid + g) * grid + b] = (unsigned short)findNearestColorEntryExact(index, (rv << 16) | (gv << 8) | bv);
+                }
+            }
+        }
+    };
+    int threadCount = getThreadCount(0);
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.push_back(std::thread(cornerWorker));
+    }
+    cornerWorker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    index.cube.resize(32 * 32 * 32);
+    std::vector<std::atomic<unsigned short*>>(32 * 32 * 32).swap(index.refined);
+    for (size_t i = 0; i < index.refined.size(); i++) {
+        index.refined[i].store(NULL);
+    }
+    for (int r = 0; r < 32; r++) {
+        for (int g = 0; g < 32; g++) {
+            for (int b = 0; b < 32; b++) {
+                unsigned short first = corner[((r * 2) * grid + g * 2) * grid + b * 2];
+                bool same = true;
+                for (int k = 1; k < 8 && same; k++) {
+                    same = (corner[((r * 2 + (k >> 2)) * grid + g * 2 + ((k >> 1) & 1)) * grid + b * 2 + (k & 1)] == first);
+                }
+                index.cube[(r << 10) | (g << 5) | b] = same ? first : COLOR_MATCH_UNRESOLVED;
+            }
+        }
+    }
+    return count;
+}
+
+int buildColorMatchIndexFromBlocks(ColorMatchIndex& index, unsigned int requiredFlags, unsigned int excludedFlags)
+{
+    std::vector<ColorMatchEntry> entries;
+    for (int type = 0; type < NUM_BLOCKS_DEFINED; type++) {
+        const BlockDefinition& def = gBlockDefinitions[type];
+        if ((def.flags & BLF_NONE) || def.read_alpha <= 0.0f) {
+            continue;
+        }
+        if ((def.flags & requiredFlags) != requiredFlags || (def.flags & excludedFlags)) {
+            continue;
+        }
+        ColorMatchEntry entry;
+        entry.type = type;
+        entry.dataVal = 0;
+        entry.color = def.read_color;
+        entries.push_back(entry);
+    }
+    if (entries.empty()) {
+        return LINE_ERROR;
+    }
+    return buildColorMatchIndex(index, entries.data(), (int)entries.size());
+}
+
+void matchImageColors(const ColorMatchIndex& index, const unsigned char* rgba, int pixelCount, int* out, int threadCount)
+{
+    threadCount = getThreadCount(threadCount);
+    // chunks small enough to balance the load, big enough to keep threads off the shared counter
+    const int chunk = 16384;
+    int chunkCount = (pixelCount + chunk - 1) / chunk;
+    std::atomic<int> nextChunk(0);
+    auto worker = [&]() {
+        int c;
+        while ((c = nextChunk++) < chunkCount) {
+            int end = (c + 1) * chunk;
+            if (end > pixelCount) {
+                end = pixelCount;
+            }
+            // neighboring pixels are often identical, so remember the last answer
+            unsigned int lastColor = 0xffffffff;
+            int lastEntry = -1;
+            for (int i = c * chunk; i < end; i++) {
+                const unsigned char* px = &rgba[(size_t)i * 4];
+                unsigned int color = ((unsigned int)px[0] << 16) | ((unsigned int)px[1] << 8) | px[2];
+                if (color != lastColor) {
+                    lastColor = color;
+                    lastEntry = findNearestColorEntry(index, color);
+                }
+                out[i] = lastEntry;
+            }
+        }
+    };
+    if (threadCount > chunkCount) {
+        threadCount = chunkCount;
+    }
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
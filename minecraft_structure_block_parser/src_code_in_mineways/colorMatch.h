@@ -0,0 +1,66 @@
+// colorMatch.h - find the block whose color best matches an RGB color, for map art and image-to-build conversion
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Colors are compared in OKLab, which is close enough to perceptually uniform that plain squared distance works.
+// A 32x32x32 cube over RGB answers most lookups with one memory load: a cell is "resolved" when the nearest
+// entry to all 8 of its corners is the same entry, and that entry is then used for anything in the cell.
+// The first lookup that lands in an unresolved cell fills in the exact answer for all 8x8x8 colors of that cell,
+// so from then on it's two memory loads. Exact answers come from a k-d tree search, whose leaves are compared
+// four at a time with SSE.
+
+typedef struct ColorMatchEntry {
+    int type;           // block type, as in gBlockDefinitions
+    int dataVal;        // data value, for palettes with subtypes; 0 when built from gBlockDefinitions
+    unsigned int color; // 0xRRGGBB
+} ColorMatchEntry;
+
+typedef struct ColorMatchKdNode {
+    int axis;           // 0-2 for L, a, b; -1 for a leaf
+    float split;
+    int child[2];       // for leaves: first slot in the leaf arrays, and slot count (a multiple of 4)
+} ColorMatchKdNode;
+
+typedef struct ColorMatchIndex {
+    std::vector<ColorMatchEntry> entries;
+    std::vector<float> lab;                 // L, a, b for each entry
+    std::vector<unsigned short> cube;       // 32x32x32, r major: entry index, or COLOR_MATCH_UNRESOLVED
+    // for unresolved cells, the 512 exact answers once some lookup has needed them; filled in by any thread
+    mutable std::vector<std::atomic<unsigned short*>> refined;
+    std::vector<ColorMatchKdNode> nodes;
+    // leaf contents, structure-of-arrays and padded to multiples of 4 so SSE can compare four at a time
+    std::vector<float> leafL;
+    std::vector<float> leafA;
+    std::vector<float> leafB;
+    std::vector<int> leafEntry;
+} ColorMatchIndex;
+
+#define COLOR_MATCH_UNRESOLVED 0xffff
+// more than this and the cube's unsigned shorts can't hold the entry index
+#define COLOR_MATCH_MAX_ENTRIES 0xfff0
+
+// convert 0xRRGGBB (sRGB) to OKLab
+void rgbToOklab(unsigned int rgb, float lab[3]);
+
+// Build from gBlockDefinitions read_color, keeping blocks that have all of requiredFlags and none of
+// excludedFlags, e.g. BLF_WHOLE and BLF_TRANSPARENT. Air and other BLF_NONE blocks are always left out.
+// Returns the number of entries, or negative on error.
+int buildColorMatchIndexFromBlocks(ColorMatchIndex& index, unsigned int requiredFlags, unsigned int excludedFlags);
+
+// Build from any list of colors, e.g. a palette restricted by hand or colors derived from the loaded resource pack.
+// Returns the number of entries, or negative on error.
+int buildColorMatchIndex(ColorMatchIndex& index, const ColorMatchEntry* entries, int count);
+
+// release all memory held by the index
+void freeColorMatchIndex(ColorMatchIndex& index);
+
+// index into index.entries of the best match; uses the cube when it can. Safe to call from many threads at once.
+int findNearestColorEntry(const ColorMatchIndex& index, unsigned int rgb);
+// same, always doing the full k-d tree search
+int findNearestColorEntryExact(const ColorMatchIndex& index, unsigned int rgb);
+
+// Match every pixel of an RGBA image (alpha ignored), writing entry indices to out. threadCount 0 means all cores.
+void matchImageColors(const ColorMatchIndex& index, const unsigned char* rgba, int pixelCount, int* out, int threadCount);
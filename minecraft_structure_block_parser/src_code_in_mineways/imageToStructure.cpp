@@ -0,0 +1,535 @@
+// imageToStructure.cpp - turn an image into a build of blocks, written as a Java .nbt structure or a Sponge schematic
+
+#include "stdafx.h"
+#include <math.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include "zlib.h"
+#include "portafile.h"
+#include "blockNames.h"
+#include "nbtView.h"
+#include "imageToStructure.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// what the blocks are written for: 1.21.6, the newest version BlockTranslations knows (dried_ghast)
+#define STRUCTURE_DATA_VERSION  4435
+
+// Floyd-Steinberg rows are handed between threads this many pixels at a time
+#define FS_CHUNK        64
+
+#define BLUE_NOISE_SIZE 64
+
+static int getThreadCount(int threadCount)
+{
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+    return threadCount;
+}
+
+static void runWorkers(int threadCount, const std::function<void()>& worker)
+{
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
+
+static unsigned int clampToRGB(const float v[3])
+{
+    unsigned int rgb = 0;
+    for (int c = 0; c < 3; c++) {
+        int i = (int)(v[c] + 0.5f);
+        i = (i < 0) ? 0 : ((i > 255) ? 255 : i);
+        rgb = (rgb << 8) | (unsigned int)i;
+    }
+    return rgb;
+}
+
+// Ranks 0-4095 for a 64x64 tiling threshold map, by the void-and-cluster method: starting from nothing, each
+// rank goes to the empty spot farthest from those already placed (lowest Gaussian energy, wrapping around).
+static const std::vector<int>& getBlueNoise()
+{
+    static const std::vector<int> ranks = []() {
+        const int n = BLUE_NOISE_SIZE;
+        const float sigma = 1.9f;
+        std::vector<float> kernel(n * n);
+        for (int y = 0; y < n; y++) {
+            int dy = (y < n / 2) ? y : n - y;
+            for (int x = 0; x < n; x++) {
+                int dx = (x < n / 2) ? x : n - x;
+                kernel[y * n + x] = expf(-(float)(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+            }
+        }
+        std::vector<float> energy(n * n, 0.0f);
+        std::vector<int> rank(n * n, -1);
+        for (int r = 0; r < n * n; r++) {
+            int best = -1;
+            for (int i = 0; i < n * n; i++) {
+                if (rank[i] < 0 && (best < 0 || energy[i] < energy[best])) {
+                    best = i;
+                }
+            }
+            rank[best] = r;
+            int bx = best % n;
+            int by = best / n;
+            for (int y = 0; y < n; y++) {
+                const float* krow = &kernel[((y - by + n) % n) * n];
+                float* erow = &energy[y * n];
+                for (int x = 0; x < n; x++) {
+                    erow[x] += krow[(x - bx + n) % n];
+                }
+            }
+        }
+        return rank;
+    }();
+    return ranks;
+}
+
+static void ditherBlueNoise(const ColorMatchIndex& index, const unsigned char* rgba, int width, int height, float strength, int threadCount, int* out)
+{
+    const std::vector<int>& ranks = getBlueNoise();
+    float offset[BLUE_NOISE_SIZE * BLUE_NOISE_SIZE];
+    for (int i = 0; i < BLUE_NOISE_SIZE * BLUE_NOISE_SIZE; i++) {
+        offset[i] = (((float)ranks[i] + 0.5f) / (float)(BLUE_NOISE_SIZE * BLUE_NOISE_SIZE) - 0.5f) * strength;
+    }
+    // each pixel is independent, so threads just take the next row
+    std::atomic<int> nextRow(0);
+    runWorkers(threadCount, [&]() {
+        int y;
+        while ((y = nextRow++) < height) {
+            const float* noiseRow = &offset[(y % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE];
+            for (int x = 0; x < width; x++) {
+                const unsigned char* px = &rgba[((size_t)y * width + x) * 4];
+                if (px[3] < 128) {
+                    out[(size_t)y * width + x] = -1;
+                    continue;
+                }
+                float t = noiseRow[x % BLUE_NOISE_SIZE];
+                float v[3] = { px[0] + t, px[1] + t, px[2] + t };
+                out[(size_t)y * width + x] = findNearestColorEntry(index, clampToRGB(v));
+            }
+        }
+    });
+}
+
+// Floyd-Steinberg, in parallel. A pixel gets error from the pixel to its left and the three above it, so row y
+// can work on pixel x once row y-1 has finished pixel x+1: rows go down the image as a diagonal wavefront, each
+// one or more chunks behind the one above. Rows are taken in order, so a thread only ever waits on rows already
+// being worked on. Error for the rows in flight lives in a ring of row buffers; a row zeroes its buffer as it
+// reads it, so the buffer is clean when it comes around again. The result is the same for any thread count.
+static void ditherFloydSteinberg(const ColorMatchIndex& index, const unsigned char* rgba, int width, int height, int threadCount, int* out)
+{
+    int ringRows = threadCount + 2;
+    size_t rowFloats = (size_t)(width + 2) * 3;
+    std::vector<float> ring(ringRows * rowFloats, 0.0f);
+    std::vector<std::atomic<int>> progress(height);
+    for (int y = 0; y < height; y++) {
+        progress[y].store(0);
+    }
+
+    std::atomic<int> nextRow(0);
+    runWorkers(threadCount, [&]() {
+        int y;
+        while ((y = nextRow++) < height) {
+            // offset by one pixel so x-1 and x+1 are always in the buffer
+            float* errHere = &ring[(y % ringRows) * rowFloats + 3];
+            float* errBelow = &ring[((y + 1) % ringRows) * rowFloats + 3];
+            float carry[3] = { 0.0f, 0.0f, 0.0f };
+            for (int x0 = 0; x0 < width; x0 += FS_CHUNK) {
+                int x1 = (x0 + FS_CHUNK < width) ? x0 + FS_CHUNK : width;
+                if (y > 0) {
+                    int needed = (x1 + 1 < width) ? x1 + 1 : width;
+                    while (progress[y - 1].load(std::memory_order_acquire) < needed) {
+                        std::this_thread::yield();
+                    }
+                }
+                for (int x = x0; x < x1; x++) {
+                    const unsigned char* px = &rgba[((size_t)y * width + x) * 4];
+                    float* e = &errHere[x * 3];
+                    if (px[3] < 128) {
+                        // air takes no error and passes none on
+                        out[(size_t)y * width + x] = -1;
+                        e[0] = e[1] = e[2] = 0.0f;
+                        carry[0] = carry[1] = carry[2] = 0.0f;
+                        continue;
+                    }
+                    // clamped, so error can't pile up where the palette can't reach
+                    float v[3];
+                    for (int c = 0; c < 3; c++) {
+                        v[c] = (float)px[c] + e[c] + carry[c];
+                        v[c] = (v[c] < 0.0f) ? 0.0f : ((v[c] > 255.0f) ? 255.0f : v[c]);
+                        e[c] = 0.0f;
+                    }
+                    int best = findNearestColorEntry(index, clampToRGB(v));
+                    out[(size_t)y * width + x] = best;
+                    unsigned int color = index.entries[best].color;
+                    for (int c = 0; c < 3; c++) {
+                        float err = v[c] - (float)((color >> (16 - 8 * c)) & 0xff);
+                        carry[c] = err * (7.0f / 16.0f);
+                        errBelow[(x - 1) * 3 + c] += err * (3.0f / 16.0f);
+                        errBelow[x * 3 + c] += err * (5.0f / 16.0f);
+                        errBelow[(x + 1) * 3 + c] += err * (1.0f / 16.0f);
+                    }
+                }
+                progress[y].store(x1, std::memory_order_release);
+            }
+        }
+    });
+}
+
+static unsigned int shadeColor(unsigned int rgb, int shade)
+{
+    unsigned int r = (((rgb >> 16) & 0xff) * shade + 127) / 255;
+    unsigned int g = (((rgb >> 8) & 0xff) * shade + 127) / 255;
+    unsigned int b = ((rgb & 0xff) * shade + 127) / 255;
+    return (r << 16) | (g << 8) | b;
+}
+
+int imageToBlockLayout(const unsigned char* rgba, int width, int height, const ColorMatchIndex& palette, const ImageStructureOptions& options, BlockLayout& layout)
+{
+    if (width <= 0 || height <= 0 || palette.entries.empty()) {
+        return LINE_ERROR;
+    }
+    int threadCount = getThreadCount(options.threadCount);
+    bool staircase = (options.layout == IMAGE_LAYOUT_STAIRCASE);
+
+    // For staircases, match against every block at each of its three shades; entry i is block i/3 at shade i%3.
+    static const int shades[3] = { MAP_SHADE_LOWER, MAP_SHADE_FLAT, MAP_SHADE_HIGHER };
+    ColorMatchIndex shaded;
+    if (staircase) {
+        std::vector<ColorMatchEntry> entries;
+        for (size_t i = 0; i < palette.entries.size(); i++) {
+            for (int s = 0; s < 3; s++) {
+                ColorMatchEntry entry = palette.entries[i];
+                entry.color = shadeColor(entry.color, shades[s]);
+                entries.push_back(entry);
+            }
+        }
+        int retCode = buildColorMatchIndex(shaded, entries.data(), (int)entries.size());
+        if (retCode < 0) {
+            return retCode;
+        }
+    }
+    const ColorMatchIndex& index = staircase ? shaded : palette;
+
+    std::vector<int> match((size_t)width * height);
+    if (options.dither == IMAGE_DITHER_FLOYD_STEINBERG) {
+        ditherFloydSteinberg(index, rgba, width, height, threadCount, match.data());
+    }
+    else if (options.dither == IMAGE_DITHER_BLUE_NOISE) {
+        ditherBlueNoise(index, rgba, width, height, options.ditherStrength, threadCount, match.data());
+    }
+    else {
+        matchImageColors(index, rgba, width * height, match.data(), threadCount);
+        for (size_t i = 0; i < match.size(); i++) {
+            if (rgba[i * 4 + 3] < 128) {
+                match[i] = -1;
+            }
+        }
+    }
+
+    layout.sizeX = width;
+    if (!staircase) {
+        layout.sizeY = 1;
+        layout.sizeZ = height;
+        layout.type.assign((size_t)width * height, 0);
+        layout.dataVal.assign((size_t)width * height, 0);
+        for (size_t i = 0; i < match.size(); i++) {
+            if (match[i] >= 0) {
+                layout.type[i] = (unsigned short)index.entries[match[i]].type;
+                layout.dataVal[i] = (unsigned char)index.entries[match[i]].dataVal;
+            }
+        }
+        return 0;
+    }
+
+    // Walk each column south from the cobblestone edge at z = 0, stepping down, level, or up per the shade picked.
+    // Air keeps the height of the block north of it. Then each column is shifted so its lowest block is at y = 0.
+    layout.sizeZ = height + 1;
+    std::vector<int> heights((size_t)width * layout.sizeZ);
+    int sizeY = 1;
+    for (int x = 0; x < width; x++) {
+        int h = 0;
+        int lowest = 0;
+        int highest = 0;
+        heights[x] = 0;
+        for (int z = 1; z <= height; z++) {
+            int m = match[(size_t)(z - 1) * width + x];
+            if (m >= 0) {
+                h += (m % 3) - 1;
+            }
+            heights[(size_t)z * width + x] = h;
+            lowest = (h < lowest) ? h : lowest;
+            highest = (h > highest) ? h : highest;
+        }
+        for (int z = 0; z <= height; z++) {
+            heights[(size_t)z * width + x] -= lowest;
+        }
+        if (highest - lowest + 1 > sizeY) {
+            sizeY = highest - lowest + 1;
+        }
+    }
+    layout.sizeY = sizeY;
+    size_t layerSize = (size_t)width * layout.sizeZ;
+    layout.type.assign(layerSize * sizeY, 0);
+    layout.dataVal.assign(layerSize * sizeY, 0);
+    for (int z = 0; z <= height; z++) {
+        for (int x = 0; x < width; x++) {
+            size_t column = (size_t)z * width + x;
+            size_t i = heights[column] * layerSize + column;
+            if (z == 0) {
+                layout.type[i] = BLOCK_COBBLESTONE;
+                continue;
+            }
+            int m = match[(size_t)(z - 1) * width + x];
+            if (m >= 0) {
+                layout.type[i] = (unsigned short)index.entries[m].type;
+                layout.dataVal[i] = (unsigned char)index.entries[m].dataVal;
+            }
+        }
+    }
+    freeColorMatchIndex(shaded);
+    return 0;
+}
+
+// Minimal big-endian NBT writing, just what structures and schematics need
+
+static void putShort(std::vector<unsigned char>& buf, int v)
+{
+    buf.push_back((unsigned char)(v >> 8));
+    buf.push_back((unsigned char)v);
+}
+
+static void putInt(std::vector<unsigned char>& buf, int v)
+{
+    buf.push_back((unsigned char)(v >> 24));
+    buf.push_back((unsigned char)(v >> 16));
+    buf.push_back((unsigned char)(v >> 8));
+    buf.push_back((unsigned char)v);
+}
+
+static void putString(std::vector<unsigned char>& buf, const char* s)
+{
+    size_t len = strlen(s);
+    putShort(buf, (int)len);
+    buf.insert(buf.end(), s, s + len);
+}
+
+static void putTag(std::vector<unsigned char>& buf, int tagType, const char* name)
+{
+    buf.push_back((unsigned char)tagType);
+    putString(buf, name);
+}
+
+static void putList(std::vector<unsigned char>& buf, const char* name, int elementType, int count)
+{
+    putTag(buf, NBT_TAG_LIST, name);
+    buf.push_back((unsigned char)elementType);
+    putInt(buf, count);
+}
+
+static int writeGzipped(const wchar_t* filename, const std::vector<unsigned char>& nbt)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // 16 more window bits asks for a gzip wrapper
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return LINE_ERROR;
+    }
+    std::vector<unsigned char> gz(deflateBound(&zs, (uLong)nbt.size()));
+    zs.next_in = (Bytef*)nbt.data();
+    zs.avail_in = (uInt)nbt.size();
+    zs.next_out = gz.data();
+    zs.avail_out = (uInt)gz.size();
+    int status = deflate(&zs, Z_FINISH);
+    size_t gzSize = gz.size() - zs.avail_out;
+    deflateEnd(&zs);
+    if (status != Z_STREAM_END) {
+        return LINE_ERROR;
+    }
+
+    DWORD br;
+    PORTAFILE fh = PortaCreate(filename);
+    if (fh == INVALID_HANDLE_VALUE) {
+        return LINE_ERROR;
+    }
+    if (PortaWrite(fh, gz.data(), (DWORD)gzSize)) {
+        PortaClose(fh);
+        return LINE_ERROR;
+    }
+    PortaClose(fh);
+    return 0;
+}
+
+int writeBlockLayout(const wchar_t* filename, int format, const BlockLayout& layout)
+{
+    // Sponge schematics store sizes as unsigned shorts
+    if (layout.sizeX <= 0 || layout.sizeY <= 0 || layout.sizeZ <= 0 ||
+        layout.sizeX > 0xffff || layout.sizeY > 0xffff || layout.sizeZ > 0xffff) {
+        return LINE_ERROR;
+    }
+    size_t blockCount = (size_t)layout.sizeX * layout.sizeY * layout.sizeZ;
+
+    // palette of distinct blocks, in order of first use; air is always entry 0
+    std::map<int, int> paletteIndex;
+    std::vector<std::string> paletteNames;
+    std::vector<int> state(blockCount);
+    paletteIndex[0] = 0;
+    paletteNames.push_back("minecraft:air");
+    int nonAir = 0;
+    for (size_t i = 0; i < blockCount; i++) {
+        int key = (layout.type[i] << 8) | layout.dataVal[i];
+        std::map<int, int>::iterator it = paletteIndex.find(key);
+        if (it == paletteIndex.end()) {
+            const char* name = getBlockStateForType(layout.type[i], layout.dataVal[i]);
+            if (name == NULL) {
+                return LINE_ERROR;
+            }
+            it = paletteIndex.insert(std::make_pair(key, (int)paletteNames.size())).first;
+            paletteNames.push_back(std::string("minecraft:") + name);
+        }
+        state[i] = it->second;
+        if (key != 0) {
+            nonAir++;
+        }
+    }
+
+    std::vector<unsigned char> nbt;
+    if (format == STRUCTURE_FORMAT_SPONGE) {
+        putTag(nbt, NBT_TAG_COMPOUND, "Schematic");
+        putTag(nbt, NBT_TAG_INT, "Version");
+        putInt(nbt, 2);
+        putTag(nbt, NBT_TAG_INT, "DataVersion");
+        putInt(nbt, STRUCTURE_DATA_VERSION);
+        putTag(nbt, NBT_TAG_SHORT, "Width");
+        putShort(nbt, layout.sizeX);
+        putTag(nbt, NBT_TAG_SHORT, "Height");
+        putShort(nbt, layout.sizeY);
+        putTag(nbt, NBT_TAG_SHORT, "Length");
+        putShort(nbt, layout.sizeZ);
+        putTag(nbt, NBT_TAG_INT, "PaletteMax");
+        putInt(nbt, (int)paletteNames.size());
+        putTag(nbt, NBT_TAG_COMPOUND, "Palette");
+        for (size_t p = 0; p < paletteNames.size(); p++) {
+            putTag(nbt, NBT_TAG_INT, paletteNames[p].c_str());
+            putInt(nbt, (int)p);
+        }
+        nbt.push_back(NBT_TAG_END);
+        // palette indices as varints, in the layout's own x, z, y order
+        std::vector<unsigned char> varints;
+        varints.reserve(blockCount);
+        for (size_t i = 0; i < blockCount; i++) {
+            unsigned int v = (unsigned int)state[i];
+            while (v >= 0x80) {
+                varints.push_back((unsigned char)(v | 0x80));
+                v >>= 7;
+            }
+            varints.push_back((unsigned char)v);
+        }
+        putTag(nbt, NBT_TAG_BYTE_ARRAY, "BlockData");
+        putInt(nbt, (int)varints.size());
+        nbt.insert(nbt.end(), varints.begin(), varints.end());
+        nbt.push_back(NBT_TAG_END);
+    }
+    else if (format == STRUCTURE_FORMAT_JAVA_NBT) {
+        putTag(nbt, NBT_TAG_COMPOUND, "");
+        putTag(nbt, NBT_TAG_INT, "DataVersion");
+        putInt(nbt, STRUCTURE_DATA_VERSION);
+        putList(nbt, "size", NBT_TAG_INT, 3);
+        putInt(nbt, layout.sizeX);
+        putInt(nbt, layout.sizeY);
+        putInt(nbt, layout.sizeZ);
+        putList(nbt, "palette", NBT_TAG_COMPOUND, (int)paletteNames.size());
+        for (size_t p = 0; p < paletteNames.size(); p++) {
+            // "name[key=value,...]" becomes Name and a Properties compound
+            const std::string& paletteState = paletteNames[p];
+            size_t bracket = paletteState.find('[');
+            putTag(nbt, NBT_TAG_STRING, "Name");
+            putString(nbt, paletteState.substr(0, bracket).c_str());
+            if (bracket != std::string::npos) {
+                putTag(nbt, NBT_TAG_COMPOUND, "Properties");
+                size_t start = bracket + 1;
+                while (start < paletteState.size() - 1) {
+                    size_t end = paletteState.find_first_of(",]", start);
+                    size_t equals = paletteState.find('=', start);
+                    putTag(nbt, NBT_TAG_STRING, paletteState.substr(start, equals - start).c_str());
+                    putString(nbt, paletteState.substr(equals + 1, end - equals - 1).c_str());
+                    start = end + 1;
+                }
+                nbt.push_back(NBT_TAG_END);
+            }
+            nbt.push_back(NBT_TAG_END);
+        }
+        putList(nbt, "blocks", NBT_TAG_COMPOUND, nonAir);
+        size_t i = 0;
+        for (int y = 0; y < layout.sizeY; y++) {
+            for (int z = 0; z < layout.sizeZ; z++) {
+                for (int x = 0; x < layout.sizeX; x++, i++) {
+                    if (state[i] == 0) {
+                        continue;
+                    }
+                    putList(nbt, "pos", NBT_TAG_INT, 3);
+                    putInt(nbt, x);
+                    putInt(nbt, y);
+                    putInt(nbt, z);
+                    putTag(nbt, NBT_TAG_INT, "state");
+                    putInt(nbt, state[i]);
+                    nbt.push_back(NBT_TAG_END);
+                }
+            }
+        }
+        putList(nbt, "entities", NBT_TAG_END, 0);
+        nbt.push_back(NBT_TAG_END);
+    }
+    else {
+        return LINE_ERROR;
+    }
+    return writeGzipped(filename, nbt);
+}
+
+int convertImageToStructure(const wchar_t* filename, int format, const unsigned char* rgba, int width, int height, const ImageStructureOptions& options)
+{
+    ColorMatchIndex allBlocks;
+    int retCode = buildColorMatchIndexFromBlocks(allBlocks, options.requiredFlags, options.excludedFlags);
+    if (retCode < 0) {
+        freeColorMatchIndex(allBlocks);
+        return retCode;
+    }
+    // leave out types no Java name translates to, which can't be written: Mineways' unknown-block and unused slots
+    std::vector<ColorMatchEntry> entries;
+    for (size_t i = 0; i < allBlocks.entries.size(); i++) {
+        if (getBlockNameForType(allBlocks.entries[i].type, allBlocks.entries[i].dataVal) != NULL) {
+            entries.push_back(allBlocks.entries[i]);
+        }
+    }
+    freeColorMatchIndex(allBlocks);
+    if (entries.empty()) {
+        return LINE_ERROR;
+    }
+    ColorMatchIndex palette;
+    retCode = buildColorMatchIndex(palette, entries.data(), (int)entries.size());
+    if (retCode < 0) {
+        freeColorMatchIndex(palette);
+        return retCode;
+    }
+    BlockLayout layout;
+    retCode = imageToBlockLayout(rgba, width, height, palette, options, layout);
+    freeColorMatchIndex(palette);
+    if (retCode < 0) {
+        return retCode;
+    }
+    return writeBlockLayout(filename, format, layout);
+}
@@ -0,0 +1,48 @@
+// imageToStructure.h - turn an image into a build of blocks, written as a Java .nbt structure or a Sponge schematic
+
+#pragma once
+
+#include <vector>
+#include "blockLayout.h"
+#include "colorMatch.h"
+
+#define IMAGE_DITHER_NONE               0
+#define IMAGE_DITHER_FLOYD_STEINBERG    1
+#define IMAGE_DITHER_BLUE_NOISE         2
+
+// flat: one layer, colors as in the palette, for builds seen as they are.
+// staircase: map art. Each column steps up or down going south, so a map shows each block at one of its
+// three shades (darker if lower than the block to its north, brighter if higher). A row of cobblestone
+// is added along the north edge to shade the first image row against.
+#define IMAGE_LAYOUT_FLAT               0
+#define IMAGE_LAYOUT_STAIRCASE          1
+
+#define STRUCTURE_FORMAT_JAVA_NBT       0
+#define STRUCTURE_FORMAT_SPONGE         1
+
+// Minecraft's map shades, out of 255; the fourth shade, 135, can't be made by placing blocks
+#define MAP_SHADE_LOWER     180
+#define MAP_SHADE_FLAT      220
+#define MAP_SHADE_HIGHER    255
+
+typedef struct ImageStructureOptions {
+    int dither;                 // IMAGE_DITHER_*
+    int layout;                 // IMAGE_LAYOUT_*
+    float ditherStrength;       // blue noise only: peak-to-peak offset added to each channel, 0-255 scale; 48 is a good start
+    unsigned int requiredFlags; // palette restriction, e.g. BLF_WHOLE; used only by convertImageToStructure
+    unsigned int excludedFlags; // e.g. BLF_TRANSPARENT
+    int threadCount;            // 0 means all cores
+} ImageStructureOptions;
+
+// Pick a block for each pixel of an RGBA image from the palette; pixels with alpha below 128 become air.
+// Image column is x, image row is z (the top of the image is north), and y is up.
+// Returns 0 on success, negative on error.
+int imageToBlockLayout(const unsigned char* rgba, int width, int height, const ColorMatchIndex& palette, const ImageStructureOptions& options, BlockLayout& layout);
+
+// Write as a gzipped Java structure (STRUCTURE_FORMAT_JAVA_NBT, for structure blocks; air is left out so it
+// doesn't replace anything) or a Sponge schematic version 2 (STRUCTURE_FORMAT_SPONGE). Returns 0 on success, negative on error.
+int writeBlockLayout(const wchar_t* filename, int format, const BlockLayout& layout);
+
+// All of the above: palette from gBlockDefinitions restricted by options.requiredFlags and excludedFlags,
+// convert, and write. Returns 0 on success, negative on error.
+int convertImageToStructure(const wchar_t* filename, int format, const unsigned char* rgba, int width, int height, const ImageStructureOptions& options);
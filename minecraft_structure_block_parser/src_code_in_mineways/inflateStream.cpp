@@ -0,0 +1,227 @@
+// inflateStream.cpp - inflate gzip or zlib data on its own thread, handing it out a window at a time
+
+#include "stdafx.h"
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "inflateStream.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+struct InflateStream {
+    const unsigned char* data;
+    size_t size;
+    size_t windowSize;
+    int windowCount;
+    std::vector<unsigned char> windows;     // windowCount windows of windowSize bytes, used as a ring
+    std::vector<size_t> filled;             // bytes in each window
+
+    // Windows are numbered as filled; window n is windows[n % windowCount]. The inflating thread fills
+    // window "produced" once it's free, and the reader holds window "consumed" until it's read through.
+    std::mutex lock;
+    std::condition_variable changed;
+    int produced;
+    int consumed;
+    bool finished;      // no more windows will be filled
+    bool failed;        // the data was damaged or cut short
+    bool stop;          // closed before the end
+    std::thread inflater;
+
+    // the reader's side, touched only by it
+    bool holding;       // has window "consumed"
+    size_t offset;      // in that window
+    size_t position;
+    std::vector<unsigned char> scratch;     // for reads that cross windows
+};
+
+static void inflateWindows(InflateStream* stream)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // 32 more window bits takes either a gzip or a zlib wrapper
+    bool ok = inflateInit2(&zs, 15 + 32) == Z_OK;
+    zs.next_in = (Bytef*)stream->data;
+    zs.avail_in = (uInt)stream->size;
+    int status = Z_OK;
+    while (ok && status == Z_OK) {
+        int n;
+        {
+            std::unique_lock<std::mutex> guard(stream->lock);
+            stream->changed.wait(guard, [stream] { return stream->stop || stream->produced - stream->consumed < stream->windowCount; });
+            if (stream->stop) {
+                break;
+            }
+            n = stream->produced % stream->windowCount;
+        }
+        // the window is ours until it's counted as produced
+        unsigned char* window = stream->windows.data() + (size_t)n * stream->windowSize;
+        zs.next_out = window;
+        zs.avail_out = (uInt)stream->windowSize;
+        while (status == Z_OK && zs.avail_out > 0) {
+            status = inflate(&zs, Z_NO_FLUSH);
+        }
+        std::lock_guard<std::mutex> guard(stream->lock);
+        stream->filled[n] = stream->windowSize - zs.avail_out;
+        stream->produced++;
+        stream->changed.notify_all();
+    }
+    if (ok) {
+        inflateEnd(&zs);
+    }
+    std::lock_guard<std::mutex> guard(stream->lock);
+    // running out of input before the end, Z_BUF_ERROR, is as bad as a damaged stream
+    stream->failed = !ok || (status != Z_STREAM_END && !stream->stop);
+    stream->finished = true;
+    stream->changed.notify_all();
+}
+
+InflateStream* openInflateStream(const unsigned char* data, size_t size, size_t windowSize, int windowCount)
+{
+    InflateStream* stream = new (std::nothrow) InflateStream;
+    if (stream == NULL) {
+        return NULL;
+    }
+    stream->data = data;
+    stream->size = size;
+    stream->windowSize = (windowSize > 0) ? windowSize : INFLATE_WINDOW_SIZE;
+    stream->windowCount = (windowCount > 0) ? windowCount : INFLATE_WINDOW_COUNT;
+    stream->produced = stream->consumed = 0;
+    stream->finished = stream->failed = stream->stop = false;
+    stream->holding = false;
+    stream->offset = 0;
+    stream->position = 0;
+    try {
+        stream->windows.resize(stream->windowSize * stream->windowCount);
+        stream->filled.assign(stream->windowCount, 0);
+        stream->inflater = std::thread(inflateWindows, stream);
+    }
+    catch (...) {
+        delete stream;
+        return NULL;
+    }
+    return stream;
+}
+
+int closeInflateStream(InflateStream* stream)
+{
+    if (stream == NULL) {
+        return LINE_ERROR;
+    }
+    {
+        std::lock_guard<std::mutex> guard(stream->lock);
+        stream->stop = true;
+        stream->changed.notify_all();
+    }
+    stream->inflater.join();
+    bool failed = stream->failed;
+    delete stream;
+    return failed ? LINE_ERROR : 0;
+}
+
+// Done with the window held, if any, and wait for the next; false at the end of the data.
+static bool nextWindow(InflateStream* stream)
+{
+    std::unique_lock<std::mutex> guard(stream->lock);
+    if (stream->holding) {
+        stream->consumed++;
+        stream->holding = false;
+        stream->changed.notify_all();
+    }
+    stream->changed.wait(guard, [stream] { return stream->produced > stream->consumed || stream->finished; });
+    if (stream->produced == stream->consumed) {
+        return false;
+    }
+    stream->holding = true;
+    stream->offset = 0;
+    return true;
+}
+
+static size_t windowLeft(const InflateStream* stream)
+{
+    return stream->holding ? stream->filled[stream->consumed % stream->windowCount] - stream->offset : 0;
+}
+
+static const unsigned char* windowAt(const InflateStream* stream)
+{
+    return stream->windows.data() + (size_t)(stream->consumed % stream->windowCount) * stream->windowSize + stream->offset;
+}
+
+const unsigned char* readInflateStream(InflateStream* stream, size_t length)
+{
+    if (windowLeft(stream) >= length) {
+        const unsigned char* p = windowAt(stream);
+        stream->offset += length;
+        stream->position += length;
+        return p;
+    }
+    stream->scratch.clear();
+    while (stream->scratch.size() < length) {
+        size_t take = windowLeft(stream);
+        if (take == 0) {
+            if (!nextWindow(stream)) {
+                return NULL;
+            }
+            continue;
+        }
+        if (take > length - stream->scratch.size()) {
+            take = length - stream->scratch.size();
+        }
+        const unsigned char* p = windowAt(stream);
+        stream->scratch.insert(stream->scratch.end(), p, p + take);
+        stream->offset += take;
+    }
+    stream->position += length;
+    return stream->scratch.data();
+}
+
+const unsigned char* peekInflateStream(InflateStream* stream, size_t& available)
+{
+    while (windowLeft(stream) == 0) {
+        if (!nextWindow(stream)) {
+            available = 0;
+            return NULL;
+        }
+    }
+    available = windowLeft(stream);
+    return windowAt(stream);
+}
+
+bool skipInflateStream(InflateStream* stream, size_t length)
+{
+    while (length > 0) {
+        size_t take = windowLeft(stream);
+        if (take == 0) {
+            if (!nextWindow(stream)) {
+                return false;
+            }
+            continue;
+        }
+        if (take > length) {
+            take = length;
+        }
+        stream->offset += take;
+        stream->position += take;
+        length -= take;
+    }
+    return true;
+}
+
+bool drainInflateStream(InflateStream* stream)
+{
+    do {
+        size_t left = windowLeft(stream);
+        stream->offset += left;
+        stream->position += left;
+    } while (nextWindow(stream));
+    std::lock_guard<std::mutex> guard(stream->lock);
+    return !stream->failed;
+}
+
+size_t getInflateStreamPosition(const InflateStream* stream)
+{
+    return stream->position;
+}
@@ -0,0 +1,37 @@
+// inflateStream.h - inflate gzip or zlib data on its own thread, handing it out a window at a time
+
+#pragma once
+
+#include <stddef.h>
+
+// A reader of compressed NBT asks for the next few bytes at a time, and never needs the whole thing
+// inflated at once. A thread inflates ahead into a ring of fixed-size windows while the caller parses the
+// windows already filled, so memory is bounded by windowSize * windowCount (plus the longest single read),
+// not by the inflated size, and inflating overlaps parsing.
+
+#define INFLATE_WINDOW_SIZE     (256 * 1024)
+#define INFLATE_WINDOW_COUNT    4
+
+typedef struct InflateStream InflateStream;
+
+// The compressed data, gzip or zlib, must outlive the stream. 0 for the window size or count gives the
+// defaults above. Returns NULL if out of memory.
+InflateStream* openInflateStream(const unsigned char* data, size_t size, size_t windowSize, int windowCount);
+// Stops the thread if it's still running. Returns 0 if everything read so far was inflated without error,
+// negative otherwise; a stream closed before its end isn't checked past what was read, so to know the whole
+// of it is sound, drain it first.
+int closeInflateStream(InflateStream* stream);
+
+// The next length bytes, contiguous, valid until the next call; NULL if the data ends first or is damaged.
+// A read that crosses windows is copied, so keep reads short (a tag header, a string) and skip long payloads.
+const unsigned char* readInflateStream(InflateStream* stream, size_t length);
+// Everything left in the current window, fetching the next if it's used up, without moving past it;
+// NULL at the end. For parsing many small records in place, then skipping what was parsed.
+const unsigned char* peekInflateStream(InflateStream* stream, size_t& available);
+// Pass over length bytes; false if the data ends first or is damaged.
+bool skipInflateStream(InflateStream* stream, size_t length);
+// Pass over whatever is left, to the end of the data. False if the data is damaged or cut short anywhere,
+// including in the gzip trailer, whose CRC and length are only checked once it's reached.
+bool drainInflateStream(InflateStream* stream);
+// inflated bytes handed out so far
+size_t getInflateStreamPosition(const InflateStream* stream);
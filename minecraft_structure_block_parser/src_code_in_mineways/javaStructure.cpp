@@ -0,0 +1,671 @@
+// javaStructure.cpp - read a Java structure block .nbt file straight into a block grid
+
+#include "stdafx.h"
+#include <string.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "mappedFile.h"
+#include "nbtView.h"
+#include "inflateStream.h"
+#include "propertyParser.h"
+#include "blockStateCache.h"
+#include "modRegistry.h"
+#include "unknownBlocks.h"
+#include "javaStructure.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// more than any block has
+#define MAX_STRUCTURE_PROPERTIES 16
+// as for nbtView.cpp
+#define STREAM_MAX_DEPTH 512
+
+// for reading Java's big-endian numbers from the stream
+static const NbtView gJavaOrder = { NULL, 0, false };
+
+static bool nameIs(const char* name, int nameLength, const char* s)
+{
+    return (int)strlen(s) == nameLength && strncmp(name, s, nameLength) == 0;
+}
+
+// Copies the string into text, terminated, and returns where it starts, or NULL if there's no room.
+static const char* copyString(const char* s, int length, char* text, int textSize, int& used)
+{
+    if (used + length + 1 > textSize) {
+        return NULL;
+    }
+    char* start = text + used;
+    memcpy(start, s, length);
+    start[length] = '\0';
+    used += length + 1;
+    return start;
+}
+
+bool translateJavaPaletteEntry(const NbtView& view, const NbtTag& entry, const ModRegistryPin& pin, unsigned short& type, unsigned char& dataVal)
+{
+    NbtTag nameTag, propertiesTag, propertyTag;
+    const char* name;
+    int nameLength;
+    type = BLOCK_AIR;
+    dataVal = 0;
+    if (!nbtFindChild(view, entry, "Name", nameTag) || !nbtGetString(view, nameTag, name, nameLength)) {
+        return false;
+    }
+    const char* shortName = name;
+    int shortLength = nameLength;
+    if (shortLength >= 10 && strncmp(shortName, "minecraft:", 10) == 0) {
+        shortName += 10;
+        shortLength -= 10;
+    }
+    // structure_void marks cells the structure leaves as they were, which for a new grid is air
+    if (nameIs(shortName, shortLength, "air") || nameIs(shortName, shortLength, "cave_air") ||
+        nameIs(shortName, shortLength, "void_air") || nameIs(shortName, shortLength, "structure_void")) {
+        return true;
+    }
+
+    const char* keyStrings[MAX_STRUCTURE_PROPERTIES];
+    const char* valueStrings[MAX_STRUCTURE_PROPERTIES];
+    int keys[MAX_STRUCTURE_PROPERTIES];
+    int values[MAX_STRUCTURE_PROPERTIES];
+    int count = 0;
+    // the key strings, terminated, for makeBlockStateKey()
+    char text[BLOCK_STATE_KEY_MAX];
+    int used = 0;
+    const char* fullName = copyString(name, nameLength, text, BLOCK_STATE_KEY_MAX, used);
+    bool fits = fullName != NULL;
+    NbtIterator it;
+    if (nbtFindChild(view, entry, "Properties", propertiesTag) && nbtIterate(view, propertiesTag, it)) {
+        while (count < MAX_STRUCTURE_PROPERTIES && nbtNext(view, it, propertyTag)) {
+            const char* value;
+            int valueLength;
+            if (!nbtGetString(view, propertyTag, value, valueLength)) {
+                continue;
+            }
+            keys[count] = findPropertyKey(propertyTag.name, propertyTag.nameLength);
+            values[count] = findPropertyValue(value, valueLength);
+            keyStrings[count] = copyString(propertyTag.name, propertyTag.nameLength, text, BLOCK_STATE_KEY_MAX, used);
+            valueStrings[count] = copyString(value, valueLength, text, BLOCK_STATE_KEY_MAX, used);
+            fits = fits && keyStrings[count] != NULL && valueStrings[count] != NULL;
+            count++;
+        }
+    }
+
+    char key[BLOCK_STATE_KEY_MAX];
+    int keyLength = fits ? makeBlockStateKey(fullName, count, keyStrings, valueStrings, key, BLOCK_STATE_KEY_MAX) : -1;
+    BlockStateCache* cache = getPaletteStateCache();
+    if (keyLength > 0 && cache != NULL && findBlockState(cache, key, keyLength, type, dataVal)) {
+        return true;
+    }
+
+    int packedType, packedData;
+    // a name in another namespace is a mod's
+    if (shortName == name) {
+        if (!findModTranslation(pin, name, nameLength, packedType, packedData)) {
+            return false;
+        }
+    }
+    else {
+        UnknownBlockLog* log = getSessionUnknownBlockLog();
+        if (isUnknownBlock(log, shortName, shortLength)) {
+            return false;
+        }
+        if (!packBlockState(shortName, shortLength, keys, values, count, packedType, packedData)) {
+            addUnknownBlock(log, shortName, shortLength);
+            return false;
+        }
+    }
+    type = (unsigned short)packedType;
+    dataVal = (unsigned char)packedData;
+    if (keyLength > 0 && cache != NULL) {
+        addBlockState(cache, key, keyLength, type, dataVal);
+    }
+    return true;
+}
+
+// One {pos, state, nbt} compound of the blocks list, read in a single pass over its bytes, since there can
+// be millions; pos and state are -1 if missing. Returns where the compound ends, or NULL if it's damaged.
+static const unsigned char* readBlock(const NbtView& view, const unsigned char* p, int& x, int& y, int& z, int& state)
+{
+    const unsigned char* end = view.data + view.size;
+    x = y = z = state = -1;
+    for (;;) {
+        if (p >= end) {
+            return NULL;
+        }
+        int type = *p++;
+        if (type == NBT_TAG_END) {
+            return p;
+        }
+        if (end - p < 2) {
+            return NULL;
+        }
+        int nameLength = (p[0] << 8) | p[1];
+        const char* name = (const char*)p + 2;
+        p += 2 + nameLength;
+        if (p > end) {
+            return NULL;
+        }
+        if (type == NBT_TAG_INT && nameLength == 5 && memcmp(name, "state", 5) == 0 && end - p >= 4) {
+            state = nbtReadInt(view, p);
+            p += 4;
+        }
+        // a list of 3 ints: element type, count, then the ints
+        else if (type == NBT_TAG_LIST && nameLength == 3 && memcmp(name, "pos", 3) == 0 && end - p >= 17 &&
+            p[0] == NBT_TAG_INT && nbtReadInt(view, p + 1) == 3) {
+            x = nbtReadInt(view, p + 5);
+            y = nbtReadInt(view, p + 9);
+            z = nbtReadInt(view, p + 13);
+            p += 17;
+        }
+        else {
+            p = nbtSkipPayload(view, type, p);
+            if (p == NULL) {
+                return NULL;
+            }
+        }
+    }
+}
+
+// Places the blocks list's elements from p, as palette index + 1, so 0 is left for cells with no block.
+// Returns where the list ends, or NULL if it's damaged.
+static const unsigned char* placeBlocks(const NbtView& view, const unsigned char* p, int count, BlockLayout& layout, int& outsideCount)
+{
+    for (int b = 0; b < count; b++) {
+        int x, y, z, state;
+        p = readBlock(view, p, x, y, z, state);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (x < 0 || x >= layout.sizeX || y < 0 || y >= layout.sizeY || z < 0 || z >= layout.sizeZ || state < 0 || state >= 0xffff) {
+            outsideCount++;
+            continue;
+        }
+        layout.type[getBlockLayoutIndex(layout, x, y, z)] = (unsigned short)(state + 1);
+    }
+    return p;
+}
+
+// Translates the palette, or variant paletteVariant of a palettes list, from view and maps the palette
+// indices placeBlocks() left in the layout to types and data values.
+static int translateStructure(const NbtView& view, const NbtTag& tag, bool variants, int paletteVariant, BlockLayout& layout,
+    int dataVersion, int blockCount, int outsideCount, JavaStructureInfo* info)
+{
+    // palette, or one of several
+    NbtIterator it;
+    int paletteVariants = 1;
+    NbtTag paletteTag = tag;
+    if (variants) {
+        NbtTag variant;
+        if (tag.type != NBT_TAG_LIST || !nbtIterate(view, tag, it) || it.elementType != NBT_TAG_LIST) {
+            return LINE_ERROR;
+        }
+        paletteVariants = it.remaining;
+        if (paletteVariant < 0 || paletteVariant >= paletteVariants) {
+            return LINE_ERROR;
+        }
+        for (int v = 0; v <= paletteVariant; v++) {
+            if (!nbtNext(view, it, variant)) {
+                return LINE_ERROR;
+            }
+        }
+        paletteTag = variant;
+    }
+    if (paletteTag.type != NBT_TAG_LIST || !nbtIterate(view, paletteTag, it)) {
+        return LINE_ERROR;
+    }
+    // index 0 is no block
+    std::vector<unsigned short> paletteType(1, BLOCK_AIR);
+    std::vector<unsigned char> paletteData(1, 0);
+    int unknownCount = 0;
+    ModRegistryPin pin;
+    pinModRegistry(pin);
+    NbtTag entry;
+    while (nbtNext(view, it, entry)) {
+        unsigned short type;
+        unsigned char dataVal;
+        if (entry.type != NBT_TAG_COMPOUND) {
+            unpinModRegistry(pin);
+            return LINE_ERROR;
+        }
+        if (!translateJavaPaletteEntry(view, entry, pin, type, dataVal)) {
+            unknownCount++;
+        }
+        paletteType.push_back(type);
+        paletteData.push_back(dataVal);
+    }
+    unpinModRegistry(pin);
+    int paletteCount = (int)paletteType.size() - 1;
+
+    // palette indices to types and data values, in order through the grid
+    unsigned short* types = layout.type.data();
+    unsigned char* dataVals = layout.dataVal.data();
+    for (size_t i = 0; i < layout.type.size(); i++) {
+        unsigned short index = types[i];
+        if (index > paletteCount) {
+            outsideCount++;
+            index = 0;
+        }
+        types[i] = paletteType[index];
+        dataVals[i] = paletteData[index];
+    }
+
+    if (info != NULL) {
+        info->dataVersion = dataVersion;
+        info->paletteCount = paletteCount;
+        info->paletteVariants = paletteVariants;
+        info->blockCount = blockCount;
+        info->unknownCount = unknownCount;
+        info->outsideCount = outsideCount;
+    }
+    return 0;
+}
+
+static int readStructureNbt(const NbtView& view, BlockLayout& layout, int paletteVariant, JavaStructureInfo* info)
+{
+    NbtTag root;
+    if (!nbtGetRoot(view, root) || root.type != NBT_TAG_COMPOUND) {
+        return LINE_ERROR;
+    }
+
+    // The root's children are read in order, once. Structure blocks write size before blocks and blocks
+    // before palette, so blocks are placed as palette indices while they're read and translated after.
+    int dataVersion = 0;
+    bool haveSize = false, haveBlocks = false;
+    NbtTag paletteTag, palettesTag, blocksTag;
+    paletteTag.type = palettesTag.type = blocksTag.type = NBT_TAG_END;
+    int blockCount = 0;
+    int outsideCount = 0;
+    const unsigned char* end = view.data + view.size;
+    const unsigned char* p = root.payload;
+    for (;;) {
+        if (p >= end) {
+            return LINE_ERROR;
+        }
+        NbtTag child;
+        child.type = *p++;
+        if (child.type == NBT_TAG_END) {
+            break;
+        }
+        if (end - p < 2) {
+            return LINE_ERROR;
+        }
+        child.nameLength = (p[0] << 8) | p[1];
+        child.name = (const char*)p + 2;
+        child.payload = p + 2 + child.nameLength;
+        if (child.payload > end) {
+            return LINE_ERROR;
+        }
+        int elementType, count;
+        const unsigned char* elements;
+        if (nbtNameIs(child, "size")) {
+            if (!nbtGetArray(view, child, elementType, count, elements) || elementType != NBT_TAG_INT || count != 3) {
+                return LINE_ERROR;
+            }
+            layout.sizeX = nbtReadInt(view, elements);
+            layout.sizeY = nbtReadInt(view, elements + 4);
+            layout.sizeZ = nbtReadInt(view, elements + 8);
+            if (layout.sizeX <= 0 || layout.sizeY <= 0 || layout.sizeZ <= 0 || (double)layout.sizeX * layout.sizeY * layout.sizeZ > 1e9) {
+                return LINE_ERROR;
+            }
+            size_t volume = (size_t)layout.sizeX * layout.sizeY * layout.sizeZ;
+            layout.type.assign(volume, 0);
+            layout.dataVal.assign(volume, 0);
+            haveSize = true;
+        }
+        else if (nbtNameIs(child, "blocks") && child.type == NBT_TAG_LIST && haveSize) {
+            if (!nbtGetArray(view, child, elementType, blockCount, elements) || (blockCount > 0 && elementType != NBT_TAG_COMPOUND)) {
+                return LINE_ERROR;
+            }
+            p = placeBlocks(view, elements, blockCount, layout, outsideCount);
+            if (p == NULL) {
+                return LINE_ERROR;
+            }
+            haveBlocks = true;
+            continue;
+        }
+        else if (nbtNameIs(child, "blocks")) {
+            // before size, so placed once size is known
+            blocksTag = child;
+        }
+        else if (nbtNameIs(child, "palette")) {
+            paletteTag = child;
+        }
+        else if (nbtNameIs(child, "palettes")) {
+            palettesTag = child;
+        }
+        else if (nbtNameIs(child, "DataVersion")) {
+            dataVersion = nbtGetInt(view, child);
+        }
+        p = nbtSkipPayload(view, child.type, child.payload);
+        if (p == NULL) {
+            return LINE_ERROR;
+        }
+    }
+    if (!haveSize) {
+        return LINE_ERROR;
+    }
+    if (!haveBlocks) {
+        int elementType;
+        const unsigned char* elements;
+        if (blocksTag.type != NBT_TAG_LIST || !nbtGetArray(view, blocksTag, elementType, blockCount, elements) ||
+            (blockCount > 0 && elementType != NBT_TAG_COMPOUND) ||
+            placeBlocks(view, elements, blockCount, layout, outsideCount) == NULL) {
+            return LINE_ERROR;
+        }
+    }
+
+    if (paletteTag.type != NBT_TAG_END) {
+        return translateStructure(view, paletteTag, false, paletteVariant, layout, dataVersion, blockCount, outsideCount, info);
+    }
+    return translateStructure(view, palettesTag, true, paletteVariant, layout, dataVersion, blockCount, outsideCount, info);
+}
+
+// The next length bytes of the stream, also appended to capture if it's not NULL.
+static const unsigned char* streamTake(InflateStream* stream, size_t length, std::vector<unsigned char>* capture)
+{
+    const unsigned char* p = readInflateStream(stream, length);
+    if (p != NULL && capture != NULL) {
+        capture->insert(capture->end(), p, p + length);
+    }
+    return p;
+}
+
+static bool streamPass(InflateStream* stream, size_t length, std::vector<unsigned char>* capture)
+{
+    return (capture != NULL) ? streamTake(stream, length, capture) != NULL : skipInflateStream(stream, length);
+}
+
+static bool streamSkipPayload(InflateStream* stream, int type, int depth, std::vector<unsigned char>* capture);
+
+static bool streamSkipListBody(InflateStream* stream, int elementType, int count, int depth, std::vector<unsigned char>* capture)
+{
+    static const int fixedSize[] = { 0, 1, 2, 4, 8, 4, 8 };
+    if (count <= 0) {
+        return true;
+    }
+    if (elementType > NBT_TAG_END && elementType <= NBT_TAG_DOUBLE) {
+        return streamPass(stream, (size_t)count * fixedSize[elementType], capture);
+    }
+    for (int i = 0; i < count; i++) {
+        if (!streamSkipPayload(stream, elementType, depth + 1, capture)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the stream's form of nbtSkipPayload(), copying what it passes into capture if that's not NULL
+static bool streamSkipPayload(InflateStream* stream, int type, int depth, std::vector<unsigned char>* capture)
+{
+    const unsigned char* p;
+    if (depth > STREAM_MAX_DEPTH) {
+        return false;
+    }
+    switch (type) {
+    case NBT_TAG_BYTE:
+        return streamPass(stream, 1, capture);
+    case NBT_TAG_SHORT:
+        return streamPass(stream, 2, capture);
+    case NBT_TAG_INT:
+    case NBT_TAG_FLOAT:
+        return streamPass(stream, 4, capture);
+    case NBT_TAG_LONG:
+    case NBT_TAG_DOUBLE:
+        return streamPass(stream, 8, capture);
+    case NBT_TAG_STRING:
+        p = streamTake(stream, 2, capture);
+        return p != NULL && streamPass(stream, (unsigned short)nbtReadShort(gJavaOrder, p), capture);
+    case NBT_TAG_BYTE_ARRAY:
+    case NBT_TAG_INT_ARRAY:
+    case NBT_TAG_LONG_ARRAY:
+    {
+        p = streamTake(stream, 4, capture);
+        if (p == NULL) {
+            return false;
+        }
+        int count = nbtReadInt(gJavaOrder, p);
+        return count >= 0 &&
+            streamPass(stream, (size_t)count * ((type == NBT_TAG_BYTE_ARRAY) ? 1 : ((type == NBT_TAG_INT_ARRAY) ? 4 : 8)), capture);
+    }
+    case NBT_TAG_LIST:
+        p = streamTake(stream, 5, capture);
+        return p != NULL && streamSkipListBody(stream, p[0], nbtReadInt(gJavaOrder, p + 1), depth, capture);
+    case NBT_TAG_COMPOUND:
+        for (;;) {
+            p = streamTake(stream, 1, capture);
+            if (p == NULL) {
+                return false;
+            }
+            int childType = *p;
+            if (childType == NBT_TAG_END) {
+                return true;
+            }
+            p = streamTake(stream, 2, capture);
+            if (p == NULL || !streamPass(stream, (unsigned short)nbtReadShort(gJavaOrder, p), capture) ||
+                !streamSkipPayload(stream, childType, depth + 1, capture)) {
+                return false;
+            }
+        }
+    default:
+        return false;
+    }
+}
+
+// readBlock(), from the stream
+static bool streamReadBlock(InflateStream* stream, int& x, int& y, int& z, int& state)
+{
+    x = y = z = state = -1;
+    for (;;) {
+        const unsigned char* p = readInflateStream(stream, 1);
+        if (p == NULL) {
+            return false;
+        }
+        int type = *p;
+        if (type == NBT_TAG_END) {
+            return true;
+        }
+        p = readInflateStream(stream, 2);
+        if (p == NULL) {
+            return false;
+        }
+        int nameLength = (p[0] << 8) | p[1];
+        const unsigned char* name = readInflateStream(stream, nameLength);
+        if (name == NULL) {
+            return false;
+        }
+        // the name is gone after the next read
+        bool isState = nameLength == 5 && memcmp(name, "state", 5) == 0;
+        bool isPos = nameLength == 3 && memcmp(name, "pos", 3) == 0;
+        if (type == NBT_TAG_INT && isState) {
+            p = readInflateStream(stream, 4);
+            if (p == NULL) {
+                return false;
+            }
+            state = nbtReadInt(gJavaOrder, p);
+        }
+        else if (type == NBT_TAG_LIST) {
+            p = readInflateStream(stream, 5);
+            if (p == NULL) {
+                return false;
+            }
+            int elementType = p[0];
+            int count = nbtReadInt(gJavaOrder, p + 1);
+            if (isPos && elementType == NBT_TAG_INT && count == 3) {
+                p = readInflateStream(stream, 12);
+                if (p == NULL) {
+                    return false;
+                }
+                x = nbtReadInt(gJavaOrder, p);
+                y = nbtReadInt(gJavaOrder, p + 4);
+                z = nbtReadInt(gJavaOrder, p + 8);
+            }
+            else if (!streamSkipListBody(stream, elementType, count, 0, NULL)) {
+                return false;
+            }
+        }
+        else if (!streamSkipPayload(stream, type, 0, NULL)) {
+            return false;
+        }
+    }
+}
+
+// readStructureNbt() as the data is inflated, so the inflated file is never all in memory: blocks are placed
+// as they go by, and only the palette is kept, to be translated at the end.
+static int readStructureStream(InflateStream* stream, BlockLayout& layout, int paletteVariant, JavaStructureInfo* info)
+{
+    // the root compound and its name
+    const unsigned char* p = readInflateStream(stream, 3);
+    if (p == NULL || p[0] != NBT_TAG_COMPOUND || !skipInflateStream(stream, (p[1] << 8) | p[2])) {
+        return LINE_ERROR;
+    }
+
+    int dataVersion = 0;
+    bool haveSize = false, haveBlocks = false;
+    int blockCount = 0;
+    int outsideCount = 0;
+    // the palette or palettes list, and the blocks list if it comes before size, as list payloads
+    std::vector<unsigned char> paletteBytes, palettesBytes, blocksBytes;
+    for (;;) {
+        p = readInflateStream(stream, 1);
+        if (p == NULL) {
+            return LINE_ERROR;
+        }
+        int type = *p;
+        if (type == NBT_TAG_END) {
+            break;
+        }
+        p = readInflateStream(stream, 2);
+        if (p == NULL) {
+            return LINE_ERROR;
+        }
+        int nameLength = (p[0] << 8) | p[1];
+        const unsigned char* name = readInflateStream(stream, nameLength);
+        if (name == NULL) {
+            return LINE_ERROR;
+        }
+        std::string childName((const char*)name, nameLength);
+        if (childName == "size" && type == NBT_TAG_LIST) {
+            p = readInflateStream(stream, 5);
+            if (p == NULL || p[0] != NBT_TAG_INT || nbtReadInt(gJavaOrder, p + 1) != 3 || (p = readInflateStream(stream, 12)) == NULL) {
+                return LINE_ERROR;
+            }
+            layout.sizeX = nbtReadInt(gJavaOrder, p);
+            layout.sizeY = nbtReadInt(gJavaOrder, p + 4);
+            layout.sizeZ = nbtReadInt(gJavaOrder, p + 8);
+            if (layout.sizeX <= 0 || layout.sizeY <= 0 || layout.sizeZ <= 0 || (double)layout.sizeX * layout.sizeY * layout.sizeZ > 1e9) {
+                return LINE_ERROR;
+            }
+            size_t volume = (size_t)layout.sizeX * layout.sizeY * layout.sizeZ;
+            layout.type.assign(volume, 0);
+            layout.dataVal.assign(volume, 0);
+            haveSize = true;
+        }
+        else if (childName == "blocks" && type == NBT_TAG_LIST && haveSize) {
+            p = readInflateStream(stream, 5);
+            if (p == NULL) {
+                return LINE_ERROR;
+            }
+            blockCount = nbtReadInt(gJavaOrder, p + 1);
+            if (blockCount > 0 && p[0] != NBT_TAG_COMPOUND) {
+                return LINE_ERROR;
+            }
+            for (int b = 0; b < blockCount; b++) {
+                int x, y, z, state;
+                // Most blocks lie whole in the window and are read there; one that crosses into the next
+                // window, or is damaged, is read again through the stream.
+                size_t available;
+                const unsigned char* window = peekInflateStream(stream, available);
+                NbtView view = { window, available, false };
+                const unsigned char* blockEnd = (window != NULL) ? readBlock(view, window, x, y, z, state) : NULL;
+                if (blockEnd != NULL) {
+                    skipInflateStream(stream, blockEnd - window);
+                }
+                else if (!streamReadBlock(stream, x, y, z, state)) {
+                    return LINE_ERROR;
+                }
+                if (x < 0 || x >= layout.sizeX || y < 0 || y >= layout.sizeY || z < 0 || z >= layout.sizeZ || state < 0 || state >= 0xffff) {
+                    outsideCount++;
+                    continue;
+                }
+                layout.type[getBlockLayoutIndex(layout, x, y, z)] = (unsigned short)(state + 1);
+            }
+            haveBlocks = true;
+        }
+        else if ((childName == "palette" || childName == "palettes" || childName == "blocks") && type == NBT_TAG_LIST) {
+            std::vector<unsigned char>& bytes = (childName == "palette") ? paletteBytes : ((childName == "palettes") ? palettesBytes : blocksBytes);
+            bytes.clear();
+            if (!streamSkipPayload(stream, type, 0, &bytes)) {
+                return LINE_ERROR;
+            }
+        }
+        else if (childName == "DataVersion" && type == NBT_TAG_INT) {
+            p = readInflateStream(stream, 4);
+            if (p == NULL) {
+                return LINE_ERROR;
+            }
+            dataVersion = nbtReadInt(gJavaOrder, p);
+        }
+        else if (!streamSkipPayload(stream, type, 0, NULL)) {
+            return LINE_ERROR;
+        }
+    }
+    if (!haveSize) {
+        return LINE_ERROR;
+    }
+    if (!haveBlocks) {
+        // the blocks came before size, so they were kept, as for an uncompressed file
+        NbtView view = { blocksBytes.data(), blocksBytes.size(), false };
+        if (blocksBytes.size() < 5) {
+            return LINE_ERROR;
+        }
+        blockCount = nbtReadInt(view, view.data + 1);
+        if ((blockCount > 0 && view.data[0] != NBT_TAG_COMPOUND) || placeBlocks(view, view.data + 5, blockCount, layout, outsideCount) == NULL) {
+            return LINE_ERROR;
+        }
+    }
+
+    bool variants = paletteBytes.empty();
+    std::vector<unsigned char>& bytes = variants ? palettesBytes : paletteBytes;
+    NbtView view = { bytes.data(), bytes.size(), false };
+    NbtTag tag;
+    tag.type = bytes.empty() ? NBT_TAG_END : NBT_TAG_LIST;
+    tag.payload = bytes.data();
+    tag.name = NULL;
+    tag.nameLength = 0;
+    return translateStructure(view, tag, variants, paletteVariant, layout, dataVersion, blockCount, outsideCount, info);
+}
+
+int readJavaStructure(const unsigned char* data, size_t size, BlockLayout& layout, int paletteVariant, JavaStructureInfo* info)
+{
+    // structure blocks write gzip, which is read as it's inflated; plain NBT, which starts with its root
+    // compound's tag, is read as is
+    if (size >= 2 && data[0] == 0x1f && data[1] == 0x8b) {
+        InflateStream* stream = openInflateStream(data, size, 0, 0);
+        if (stream == NULL) {
+            return LINE_ERROR;
+        }
+        int retCode = readStructureStream(stream, layout, paletteVariant, info);
+        // parsing stops at the root's end, before the trailer, so the rest must be inflated to check it
+        if (retCode >= 0 && !drainInflateStream(stream)) {
+            retCode = LINE_ERROR;
+        }
+        // a damaged stream can look like a short file, so its error is the one to give
+        int streamCode = closeInflateStream(stream);
+        return (retCode < 0 && streamCode < 0) ? streamCode : retCode;
+    }
+    NbtView view = { data, size, false };
+    return readStructureNbt(view, layout, paletteVariant, info);
+}
+
+int loadJavaStructure(const wchar_t* filename, BlockLayout& layout, int paletteVariant, JavaStructureInfo* info)
+{
+    MappedFile mf;
+    if (openMappedFile(filename, mf) != 0) {
+        return LINE_ERROR;
+    }
+    int retCode = readJavaStructure(mf.data, mf.size, layout, paletteVariant, info);
+    closeMappedFile(mf);
+    return retCode;
+}
@@ -0,0 +1,37 @@
+// javaStructure.h - read a Java structure block .nbt file straight into a block grid
+
+#pragma once
+
+#include "blockLayout.h"
+#include "nbtView.h"
+#include "modRegistry.h"
+
+// A Java structure is gzipped big-endian NBT: size [x, y, z], a palette of {Name, Properties} (or "palettes",
+// a list of such palettes that all fit the same blocks, as for shipwrecks' wood variants), and "blocks", a
+// list of {pos [x, y, z], state, nbt} in no particular order, with air usually left out. The blocks list is
+// read in one pass, each block going straight to its cell of the layout, without allocating anything per
+// block. A gzipped file is parsed as it's inflated (inflateStream.h), so only a few windows of it are ever
+// in memory, besides the layout and the palette. Palette entries are translated with packBlockState()
+// (propertyParser.h) through the palette state cache (blockStateCache.h), and modded names through the mod
+// registry (modRegistry.h).
+
+typedef struct JavaStructureInfo {
+    int dataVersion;
+    int paletteCount;       // entries in the palette used
+    int paletteVariants;    // palettes to choose from; 1 for a plain palette
+    int blockCount;         // entries in the blocks list
+    int unknownCount;       // palette entries with no translation, which become air
+    int outsideCount;       // blocks whose pos is outside size, or whose state is not in the palette, which are skipped
+} JavaStructureInfo;
+
+// Returns 0 on success, negative on error. paletteVariant picks one of "palettes", and is ignored if the
+// file has a single palette. info may be NULL.
+int loadJavaStructure(const wchar_t* filename, BlockLayout& layout, int paletteVariant, JavaStructureInfo* info);
+// same, from the file's bytes already in memory, gzipped or not
+int readJavaStructure(const unsigned char* data, size_t size, BlockLayout& layout, int paletteVariant, JavaStructureInfo* info);
+
+// Type and data value for one palette entry, {Name, Properties}, as Java structures and chunk sections both
+// have them: through the palette state cache, the mod registry for names outside "minecraft:", and
+// packBlockState(). Air and names that can't be translated are BLOCK_AIR; false for the latter, which are
+// added to the session's unknown block log.
+bool translateJavaPaletteEntry(const NbtView& view, const NbtTag& entry, const ModRegistryPin& pin, unsigned short& type, unsigned char& dataVal);
@@ -0,0 +1,105 @@
+// mappedFile.cpp - map a whole file into memory, read only, on Windows or POSIX
+
+#include "stdafx.h"
+#include "mappedFile.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+static void clearMappedFile(MappedFile& mf)
+{
+    mf.data = NULL;
+    mf.size = 0;
+#ifdef _WIN32
+    mf.fileHandle = INVALID_HANDLE_VALUE;
+    mf.mappingHandle = NULL;
+#else
+    mf.fd = -1;
+#endif
+}
+
+int openMappedFile(const wchar_t* filename, MappedFile& mf)
+{
+    clearMappedFile(mf);
+#ifdef _WIN32
+    mf.fileHandle = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mf.fileHandle == INVALID_HANDLE_VALUE) {
+        return LINE_ERROR;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(mf.fileHandle, &fileSize)) {
+        closeMappedFile(mf);
+        return LINE_ERROR;
+    }
+    mf.size = (size_t)fileSize.QuadPart;
+    if (mf.size == 0) {
+        // CreateFileMapping refuses empty files
+        return 0;
+    }
+    mf.mappingHandle = CreateFileMappingW(mf.fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mf.mappingHandle == NULL) {
+        closeMappedFile(mf);
+        return LINE_ERROR;
+    }
+    mf.data = (const unsigned char*)MapViewOfFile(mf.mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (mf.data == NULL) {
+        closeMappedFile(mf);
+        return LINE_ERROR;
+    }
+#else
+    char path[MAX_PATH * 4];
+    if (wcstombs(path, filename, sizeof(path)) == (size_t)-1) {
+        return LINE_ERROR;
+    }
+    path[sizeof(path) - 1] = '\0';
+    mf.fd = open(path, O_RDONLY);
+    if (mf.fd < 0) {
+        return LINE_ERROR;
+    }
+    struct stat st;
+    if (fstat(mf.fd, &st) != 0) {
+        closeMappedFile(mf);
+        return LINE_ERROR;
+    }
+    mf.size = (size_t)st.st_size;
+    if (mf.size == 0) {
+        return 0;
+    }
+    void* data = mmap(NULL, mf.size, PROT_READ, MAP_SHARED, mf.fd, 0);
+    if (data == MAP_FAILED) {
+        closeMappedFile(mf);
+        return LINE_ERROR;
+    }
+    mf.data = (const unsigned char*)data;
+#endif
+    return 0;
+}
+
+void closeMappedFile(MappedFile& mf)
+{
+#ifdef _WIN32
+    if (mf.data != NULL) {
+        UnmapViewOfFile(mf.data);
+    }
+    if (mf.mappingHandle != NULL) {
+        CloseHandle(mf.mappingHandle);
+    }
+    if (mf.fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(mf.fileHandle);
+    }
+#else
+    if (mf.data != NULL) {
+        munmap((void*)mf.data, mf.size);
+    }
+    if (mf.fd >= 0) {
+        close(mf.fd);
+    }
+#endif
+    clearMappedFile(mf);
+}
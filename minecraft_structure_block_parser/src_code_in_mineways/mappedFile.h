@@ -0,0 +1,21 @@
+// mappedFile.h - map a whole file into memory, read only, on Windows or POSIX
+
+#pragma once
+
+#include <stddef.h>
+
+typedef struct MappedFile {
+    const unsigned char* data;  // NULL if not open; an empty file maps to NULL with size 0
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+} MappedFile;
+
+// Returns 0 on success, negative on error; on error the MappedFile is left closed.
+int openMappedFile(const wchar_t* filename, MappedFile& mf);
+// unmap and close; safe to call on a closed or failed MappedFile
+void closeMappedFile(MappedFile& mf);
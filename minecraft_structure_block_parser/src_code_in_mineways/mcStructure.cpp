@@ -0,0 +1,175 @@
+// mcStructure.cpp - read a Bedrock .mcstructure file straight into a block grid
+
+#include "stdafx.h"
+#include <string.h>
+#include <vector>
+#include "mappedFile.h"
+#include "nbtView.h"
+#include "bedrockTranslations.h"
+#include "mcStructure.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// what a palette entry becomes
+typedef struct PaletteBlock {
+    unsigned short type;
+    unsigned char dataVal;
+    bool isWater;           // for layer 1
+} PaletteBlock;
+
+static bool findPath(const NbtView& view, NbtTag tag, const char* const* path, int depth, NbtTag& found)
+{
+    for (int i = 0; i < depth; i++) {
+        if (!nbtFindChild(view, tag, path[i], tag)) {
+            return false;
+        }
+    }
+    found = tag;
+    return true;
+}
+
+static void translatePaletteEntry(const NbtView& view, const NbtTag& entry, PaletteBlock& block, int& unknownCount)
+{
+    NbtTag nameTag;
+    const char* name = "";
+    int nameLength = 0;
+    block.type = BLOCK_AIR;
+    block.dataVal = 0;
+    if (nbtFindChild(view, entry, "name", nameTag)) {
+        nbtGetString(view, nameTag, name, nameLength);
+    }
+    if (nameLength >= 10 && strncmp(name, "minecraft:", 10) == 0) {
+        name += 10;
+        nameLength -= 10;
+    }
+    block.isWater = (nameLength == 5 && strncmp(name, "water", 5) == 0) || (nameLength == 13 && strncmp(name, "flowing_water", 13) == 0);
+    if ((nameLength == 3 && strncmp(name, "air", 3) == 0) || (nameLength == 14 && strncmp(name, "structure_void", 14) == 0)) {
+        return;
+    }
+    int type, dataVal;
+    if (!translateBedrockPaletteEntry(view, entry, type, dataVal)) {
+        unknownCount++;
+        return;
+    }
+    block.type = (unsigned short)type;
+    block.dataVal = (unsigned char)dataVal;
+}
+
+int readMcStructure(const unsigned char* data, size_t size, BlockLayout& layout, McStructureInfo* info)
+{
+    NbtView view = { data, size, true };
+    NbtTag root, tag;
+    if (!nbtGetRoot(view, root)) {
+        return LINE_ERROR;
+    }
+
+    // size
+    int elementType, count;
+    const unsigned char* elements;
+    if (!nbtFindChild(view, root, "size", tag) || !nbtGetArray(view, tag, elementType, count, elements) ||
+        elementType != NBT_TAG_INT || count != 3) {
+        return LINE_ERROR;
+    }
+    int sizeX = nbtReadInt(view, elements);
+    int sizeY = nbtReadInt(view, elements + 4);
+    int sizeZ = nbtReadInt(view, elements + 8);
+    if (sizeX <= 0 || sizeY <= 0 || sizeZ <= 0 || (double)sizeX * sizeY * sizeZ > 1e9) {
+        return LINE_ERROR;
+    }
+    size_t volume = (size_t)sizeX * sizeY * sizeZ;
+
+    // palette
+    static const char* palettePath[] = { "structure", "palette", "default", "block_palette" };
+    if (!findPath(view, root, palettePath, 4, tag)) {
+        return LINE_ERROR;
+    }
+    std::vector<PaletteBlock> palette;
+    int unknownCount = 0;
+    NbtIterator it;
+    NbtTag entry;
+    if (!nbtIterate(view, tag, it)) {
+        return LINE_ERROR;
+    }
+    while (nbtNext(view, it, entry)) {
+        PaletteBlock block;
+        if (entry.type != NBT_TAG_COMPOUND) {
+            return LINE_ERROR;
+        }
+        translatePaletteEntry(view, entry, block, unknownCount);
+        palette.push_back(block);
+    }
+
+    // the two layers of indices, read where they lie
+    static const char* indicesPath[] = { "structure", "block_indices" };
+    if (!findPath(view, root, indicesPath, 2, tag) || !nbtIterate(view, tag, it)) {
+        return LINE_ERROR;
+    }
+    const unsigned char* layer[2] = { NULL, NULL };
+    for (int l = 0; l < 2 && nbtNext(view, it, entry); l++) {
+        if (!nbtGetArray(view, entry, elementType, count, elements) || elementType != NBT_TAG_INT || (size_t)count != volume) {
+            // an empty second layer is allowed
+            if (l == 1 && count == 0) {
+                break;
+            }
+            return LINE_ERROR;
+        }
+        layer[l] = elements;
+    }
+    if (layer[0] == NULL) {
+        return LINE_ERROR;
+    }
+
+    layout.sizeX = sizeX;
+    layout.sizeY = sizeY;
+    layout.sizeZ = sizeZ;
+    layout.type.assign(volume, 0);
+    layout.dataVal.assign(volume, 0);
+    int paletteCount = (int)palette.size();
+    int waterloggedCount = 0;
+    // source order is z fastest, then y, then x; the layout is x fastest, then z, then y
+    size_t i = 0;
+    for (int x = 0; x < sizeX; x++) {
+        for (int y = 0; y < sizeY; y++) {
+            size_t out = (size_t)y * sizeZ * sizeX + x;
+            for (int z = 0; z < sizeZ; z++, i++, out += sizeX) {
+                int index = nbtReadInt(view, layer[0] + i * 4);
+                if (index >= 0 && index < paletteCount) {
+                    layout.type[out] = palette[index].type;
+                    layout.dataVal[out] = palette[index].dataVal;
+                }
+                if (layer[1] != NULL) {
+                    int extra = nbtReadInt(view, layer[1] + i * 4);
+                    if (extra >= 0 && extra < paletteCount && palette[extra].isWater) {
+                        if (layout.type[out] == BLOCK_AIR) {
+                            layout.type[out] = palette[extra].type;
+                            layout.dataVal[out] = palette[extra].dataVal;
+                        }
+                        else if (gBlockDefinitions[layout.type[out]].flags & BLF_MAYWATERLOG) {
+                            layout.dataVal[out] |= BIT_16;
+                            waterloggedCount++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (info != NULL) {
+        info->paletteCount = paletteCount;
+        info->unknownCount = unknownCount;
+        info->waterloggedCount = waterloggedCount;
+    }
+    return 0;
+}
+
+int loadMcStructure(const wchar_t* filename, BlockLayout& layout, McStructureInfo* info)
+{
+    MappedFile mf;
+    if (openMappedFile(filename, mf) != 0) {
+        return LINE_ERROR;
+    }
+    int retCode = readMcStructure(mf.data, mf.size, layout, info);
+    closeMappedFile(mf);
+    return retCode;
+}
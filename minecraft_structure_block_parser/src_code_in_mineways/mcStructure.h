@@ -0,0 +1,23 @@
+// mcStructure.h - read a Bedrock .mcstructure file straight into a block grid
+
+#pragma once
+
+#include "blockLayout.h"
+
+// A .mcstructure is uncompressed little-endian NBT: size [x, y, z], structure.palette.default.block_palette,
+// and structure.block_indices, two layers of palette indices, z fastest, then y, then x (see
+// ../mcstructure_format_explanation.md), with -1 for nothing. Layer 0 is the block; layer 1 is what shares
+// its space, which is water for waterlogged blocks. The file is mapped and read in place; the only
+// allocations are the layout itself and one small table for the palette, which is translated with
+// translateBedrockPaletteEntry() (bedrockTranslations.h).
+
+typedef struct McStructureInfo {
+    int paletteCount;
+    int unknownCount;       // palette entries with no translation, which become air
+    int waterloggedCount;   // blocks given BIT_16 from layer 1
+} McStructureInfo;
+
+// Returns 0 on success, negative on error. info may be NULL.
+int loadMcStructure(const wchar_t* filename, BlockLayout& layout, McStructureInfo* info);
+// same, from the file's bytes already in memory
+int readMcStructure(const unsigned char* data, size_t size, BlockLayout& layout, McStructureInfo* info);
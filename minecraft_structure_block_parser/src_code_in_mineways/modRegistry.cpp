@@ -0,0 +1,287 @@
+// modRegistry.cpp - modded block names and the Mineways type and data value each is shown as, shared by all chunk-reading threads
+
+#include "stdafx.h"
+#include <string.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mappedFile.h"
+#include "blockStateCache.h"
+#include "modRegistry.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// Reader counts are split into stripes on their own cache lines, so threads pinning at the same
+// time mostly touch different lines; each thread always uses the same stripe.
+#define READER_STRIPES 16
+
+typedef struct ModEntry {
+    unsigned int hash;
+    unsigned int nameOffset;    // into names; the entry is empty if nameLength is 0
+    int nameLength;
+    int type;
+    int dataVal;
+} ModEntry;
+
+struct ModRegistry {
+    std::vector<ModEntry> entries;  // open addressing, power of two in size, at most half full
+    std::vector<char> names;
+    int count;
+};
+
+typedef struct alignas(64) ReaderStripe {
+    std::atomic<int> readers;
+} ReaderStripe;
+
+static std::atomic<const ModRegistry*> gModRegistry(NULL);
+static std::atomic<unsigned int> gModRegistryGeneration(0);
+// readers counted by the parity of the epoch they pinned in
+static std::atomic<int> gEpoch(0);
+static ReaderStripe gReaders[2][READER_STRIPES];
+// only one thread replaces the registry at a time
+static std::mutex gReplaceLock;
+
+static unsigned int hashName(const char* name, int length)
+{
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int getReaderStripe()
+{
+    static thread_local int stripe = (int)(std::hash<std::thread::id>()(std::this_thread::get_id()) % READER_STRIPES);
+    return stripe;
+}
+
+static int countReaders(int parity)
+{
+    int total = 0;
+    for (int s = 0; s < READER_STRIPES; s++) {
+        total += gReaders[parity][s].readers.load();
+    }
+    return total;
+}
+
+// Wait until no reader can still hold a registry swapped out before this call. Flipping the epoch
+// twice, waiting for the old parity to drain each time, also catches a reader that read the epoch
+// just before a flip but counted itself just after.
+static void waitForReaders()
+{
+    for (int flip = 0; flip < 2; flip++) {
+        int parity = gEpoch.fetch_add(1) & 1;
+        while (countReaders(parity) != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static void replaceRegistry(const ModRegistry* registry)
+{
+    std::lock_guard<std::mutex> replacing(gReplaceLock);
+    const ModRegistry* old = gModRegistry.exchange(registry);
+    gModRegistryGeneration.fetch_add(1);
+    waitForReaders();
+    delete old;
+    // The palette cache keys mod names by name alone, so what they translated to under the old registry
+    // must go. Only now has every reader pinning the old registry unpinned, so none can add to it again.
+    BlockStateCache* cache = getPaletteStateCache();
+    if (cache != NULL) {
+        clearBlockStateCache(cache);
+    }
+}
+
+// add unless the name is already there; false if it was
+static bool addEntry(ModRegistry* registry, const char* name, int length, int type, int dataVal)
+{
+    unsigned int hash = hashName(name, length);
+    size_t mask = registry->entries.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        ModEntry& entry = registry->entries[i];
+        if (entry.nameLength == 0) {
+            entry.hash = hash;
+            entry.nameOffset = (unsigned int)registry->names.size();
+            entry.nameLength = length;
+            entry.type = type;
+            entry.dataVal = dataVal;
+            registry->names.insert(registry->names.end(), name, name + length);
+            registry->count++;
+            return true;
+        }
+        if (entry.hash == hash && entry.nameLength == length && memcmp(&registry->names[entry.nameOffset], name, length) == 0) {
+            return false;
+        }
+    }
+}
+
+static ModRegistry* makeRegistry(int capacity)
+{
+    ModRegistry* registry = new (std::nothrow) ModRegistry;
+    if (registry == NULL) {
+        return NULL;
+    }
+    size_t size = 16;
+    while (size < (size_t)capacity * 2) {
+        size *= 2;
+    }
+    ModEntry empty = { 0, 0, 0, 0, 0 };
+    registry->entries.assign(size, empty);
+    registry->count = 0;
+    return registry;
+}
+
+static bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+// read a whole number at p, moving p past it; false if there isn't one
+static bool readNumber(const char*& p, const char* end, int& value)
+{
+    while (p < end && isSeparator(*p)) {
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
+        if (value > 0xffff) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int loadModRegistry(const wchar_t* filename)
+{
+    MappedFile mf;
+    if (openMappedFile(filename, mf) != 0) {
+        return LINE_ERROR;
+    }
+    const char* text = (const char*)mf.data;
+    const char* textEnd = text + mf.size;
+
+    // a line per name at most, so counting lines sizes the table
+    int lineCount = 1;
+    for (const char* p = text; p < textEnd; p++) {
+        lineCount += (*p == '\n');
+    }
+    ModRegistry* registry = makeRegistry(lineCount);
+    if (registry == NULL) {
+        closeMappedFile(mf);
+        return LINE_ERROR;
+    }
+
+    const char* line = text;
+    while (line < textEnd) {
+        const char* lineEnd = (const char*)memchr(line, '\n', textEnd - line);
+        if (lineEnd == NULL) {
+            lineEnd = textEnd;
+        }
+        const char* p = line;
+        while (p < lineEnd && isSeparator(*p)) {
+            p++;
+        }
+        if (p < lineEnd && *p != '#') {
+            const char* name = p;
+            while (p < lineEnd && !isSeparator(*p)) {
+                p++;
+            }
+            int nameLength = (int)(p - name);
+            int type, dataVal;
+            if (!readNumber(p, lineEnd, type) || !readNumber(p, lineEnd, dataVal) ||
+                type >= NUM_BLOCKS_DEFINED || dataVal > 255) {
+                delete registry;
+                closeMappedFile(mf);
+                return LINE_ERROR;
+            }
+            addEntry(registry, name, nameLength, type, dataVal);
+        }
+        line = lineEnd + 1;
+    }
+    closeMappedFile(mf);
+
+    int count = registry->count;
+    replaceRegistry(registry);
+    return count;
+}
+
+int setModRegistry(const TranslationTuple* translations, int count)
+{
+    if (count < 0) {
+        count = 0;
+        while (translations[count].name != NULL) {
+            count++;
+        }
+    }
+    ModRegistry* registry = makeRegistry(count);
+    if (registry == NULL) {
+        return LINE_ERROR;
+    }
+    for (int i = 0; i < count; i++) {
+        int length = (int)strlen(translations[i].name);
+        if (length > 0) {
+            addEntry(registry, translations[i].name, length, translations[i].type, translations[i].data);
+        }
+    }
+    count = registry->count;
+    replaceRegistry(registry);
+    return count;
+}
+
+void clearModRegistry()
+{
+    replaceRegistry(NULL);
+}
+
+unsigned int getModRegistryGeneration()
+{
+    return gModRegistryGeneration.load(std::memory_order_acquire);
+}
+
+void pinModRegistry(ModRegistryPin& pin)
+{
+    pin.stripe = getReaderStripe();
+    pin.epoch = gEpoch.load() & 1;
+    gReaders[pin.epoch][pin.stripe].readers.fetch_add(1);
+    pin.registry = gModRegistry.load();
+}
+
+void unpinModRegistry(ModRegistryPin& pin)
+{
+    gReaders[pin.epoch][pin.stripe].readers.fetch_sub(1, std::memory_order_release);
+    pin.registry = NULL;
+}
+
+bool findModTranslation(const ModRegistryPin& pin, const char* name, int length, int& type, int& dataVal)
+{
+    const ModRegistry* registry = pin.registry;
+    if (registry == NULL || length <= 0) {
+        return false;
+    }
+    unsigned int hash = hashName(name, length);
+    size_t mask = registry->entries.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const ModEntry& entry = registry->entries[i];
+        if (entry.nameLength == 0) {
+            return false;
+        }
+        if (entry.hash == hash && entry.nameLength == length && memcmp(&registry->names[entry.nameOffset], name, length) == 0) {
+            type = entry.type;
+            dataVal = entry.dataVal;
+            return true;
+        }
+    }
+}
+
+int getModRegistrySize(const ModRegistryPin& pin)
+{
+    return pin.registry ? pin.registry->count : 0;
+}
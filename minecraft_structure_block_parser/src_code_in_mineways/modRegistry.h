@@ -0,0 +1,39 @@
+// modRegistry.h - modded block names and the Mineways type and data value each is shown as, shared by all chunk-reading threads
+
+#pragma once
+
+// A registry is an immutable snapshot: a hash table of names, built once and then only read. Readers pin
+// the current snapshot, look up as many names as they like without any lock, and unpin. Loading a new mod
+// list builds a new snapshot and swaps it in; the old one is freed once every reader that might still see
+// it has unpinned (read-copy-update). Readers never wait; only the thread replacing the registry does.
+
+typedef struct ModRegistry ModRegistry;
+
+typedef struct ModRegistryPin {
+    const ModRegistry* registry;    // NULL if no mod translations are loaded
+    int epoch;                      // which reader count this pin is in, for unpinning
+    int stripe;
+} ModRegistryPin;
+
+// Replace the registry from a text file, one block per line: "modid:name type dataVal", separated by
+// spaces, tabs or commas; blank lines and lines starting with # are skipped. If a name is listed twice,
+// the first is used. Returns the number of names, or negative on error, in which case the old registry stays.
+int loadModRegistry(const wchar_t* filename);
+// same, from translations already in memory, e.g. the old modTranslations list; count -1 means up to the entry with a NULL name
+int setModRegistry(const TranslationTuple* translations, int count);
+// remove all mod translations
+void clearModRegistry();
+
+// Changes each time the registry is replaced. The palette state cache (blockStateCache.h) is cleared then
+// too, so it never gives what a mod name translated to under an earlier registry.
+unsigned int getModRegistryGeneration();
+
+// Pin the current registry for a batch of lookups, such as one section's palette, then unpin.
+// Lock-free, and cheap enough to do per palette, though not per block.
+void pinModRegistry(ModRegistryPin& pin);
+void unpinModRegistry(ModRegistryPin& pin);
+
+// Look a full name, e.g. "create:andesite_casing", up in a pinned registry. Returns true, with the type
+// and data value, if found.
+bool findModTranslation(const ModRegistryPin& pin, const char* name, int length, int& type, int& dataVal);
+int getModRegistrySize(const ModRegistryPin& pin);
@@ -29,6 +29,11 @@ THE POSSIBILITY OF SUCH DAMAGE.
 #include "stdafx.h"
 #include <string.h>
 #include <assert.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "blockNames.h"
 
 // We know we won't run into names longer than 100 characters. The old code was
 // safe, but was also allocating strings all the time - seems slow.
@@ -42,6 +47,14 @@ static int skipList(bfFile* pbf);
 static int skipCompound(bfFile* pbf);
 
 static int readBiomePalette(bfFile* pbf, unsigned char* paletteBiomeEntry, int& entryIndex);
+// readPalette()'s body isn't in this tree. When it is, it should use what the Java structure reader
+// (javaStructure.h) and the Bedrock palette translation (bedrockTranslations.h) already do. Before decoding
+// an entry's Properties it should look up makeBlockStateKey() of the entry in getPaletteStateCache()
+// (blockStateCache.h), and add the (blockId, dataVal) it decodes on a miss.
+// It should recognize property keys and values with findPropertyKey() and findPropertyValue() (propertyParser.h),
+// whose tables ../gen_property_vocabulary.py makes from the property comments above; rerun it when they change.
+// Names that fail to translate should go to getSessionUnknownBlockLog() (unknownBlocks.h): isUnknownBlock()
+// checked first, and unknownBlock filled in only when addUnknownBlock() says the name is new.
 static int readPalette(int& returnCode, bfFile* pbf, int mcVersion, unsigned char* paletteBlockEntry, unsigned char* paletteDataEntry, int& entryIndex, char* unknownBlock, int unknownBlockID);
 static int readBlockData(bfFile* pbf, int& bigbufflen, unsigned char* bigbuff);
 
@@ -64,7 +77,8 @@ typedef struct BiomeTranslator {
 
 static bool makeHash = true;
 static bool makeBiomeHash = true;
-static TranslationTuple* modTranslations = NULL;
+// Modded block names are looked up in the registry of modRegistry.h, which any number of threads can read
+// while it is replaced; readPalette() should pin it once per palette, as the Java structure reader does.
 
 // if defined, only those data values that have an effect on graphics display (vs. sound or
 // simulation) are actually filled in. This is a good thing for instancing, but allows the
@@ -1523,3 +1537,548 @@ BlockTranslator BlockTranslations[NUM_TRANS] = {
  // Note: 140, 144 are reserved for the extra bit needed for BLOCK_FLOWER_POT and BLOCK_HEAD, so don't use these HIGH_BIT values
 };
 
+
+// Names in BlockTranslations that are read but never written: old names Minecraft has since changed, and names that aren't blocks.
+static const char* gUnwrittenNames[] = { "grass", "grass_path", "sign", "wall_sign", "bed", "ominous_banner" };
+
+static bool isUnwrittenName(const char* name)
+{
+    for (int i = 0; i < (int)(sizeof(gUnwrittenNames) / sizeof(gUnwrittenNames[0])); i++) {
+        if (strcmp(name, gUnwrittenNames[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// see IDBlock(): the HIGH_BIT is part of the type, except for flower pots and heads, where it is part of the data
+static void getTranslationTypeAndData(const BlockTranslator& bt, int& type, int& dataVal)
+{
+    type = bt.blockId;
+    dataVal = bt.dataVal;
+    if ((dataVal & HIGH_BIT) && type != BLOCK_FLOWER_POT && type != BLOCK_HEAD) {
+        type |= 0x100;
+        dataVal &= ~HIGH_BIT;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reverse translation: (type, dataVal) back to a Java block state, for writing structures and schematics.
+// The *_PROP rules below undo what readPalette() does, for the properties whose bits are known; whatever
+// else a block state has is left at Minecraft's default. Every state string is interned, and a dense table
+// over all types and 256 data values holds the string ids, so a lookup is two memory loads.
+
+static const char* gFacing6[6] = { "down", "up", "north", "south", "west", "east" };
+static const char* gFacingSWNE[4] = { "south", "west", "north", "east" };
+static const char* gFacingStairs[4] = { "east", "west", "south", "north" };
+static const char* gFacingDoor[4] = { "east", "south", "west", "north" };
+static const char* gFacingTrapdoor[4] = { "north", "south", "west", "east" };
+static const char* gRailShape[10] = { "north_south", "east_west", "ascending_east", "ascending_west", "ascending_north", "ascending_south",
+    "south_east", "south_west", "north_west", "north_east" };
+
+typedef std::vector<std::pair<std::string, std::string>> StateProperties;
+
+static void addProperty(StateProperties& props, const char* key, const char* value)
+{
+    props.push_back(std::make_pair(std::string(key), std::string(value)));
+}
+
+static void addProperty(StateProperties& props, const char* key, int value)
+{
+    char buf[16];
+    sprintf_s(buf, 16, "%d", value);
+    addProperty(props, key, buf);
+}
+
+static void addProperty(StateProperties& props, const char* key, bool value)
+{
+    addProperty(props, key, value ? "true" : "false");
+}
+
+// the dataVal bits a *_PROP rule turns into properties
+static int getPropertyBits(int prop)
+{
+    switch (prop) {
+    case AXIS_PROP:
+        return 0xc;
+    case QUARTZ_PILLAR_PROP:
+    case TORCH_PROP:
+    case FURNACE_PROP:
+    case FACING_PROP:
+    case CHEST_PROP:
+    case HEAD_WALL_PROP:
+    case EXTENDED_FACING_PROP:
+    case FENCE_GATE_PROP:
+    case SNOW_PROP:
+    case FARMLAND_PROP:
+        return 0x7;
+    case SLAB_PROP:
+    case TALL_FLOWER_PROP:
+        return 0x8;
+    case STAIRS_PROP:
+        return 0x7;
+    case DOOR_PROP:
+    case TRAPDOOR_PROP:
+    case BUTTON_PROP:
+    case LEVER_PROP:
+    case REPEATER_PROP:
+    case COMPARATOR_PROP:
+    case FLUID_PROP:
+    case STANDING_SIGN_PROP:
+    case HEAD_PROP:
+    case WIRE_PROP:
+    case WT_PRESSURE_PROP:
+    case DAYLIGHT_PROP:
+    case AGE_PROP:
+    case EGG_PROP:
+        return 0xf;
+    case RAIL_PROP:
+        // plain rails have ten shapes; the others have six, and a powered bit
+        return 0xf;
+    case SWNE_FACING_PROP:
+    case EXTENDED_SWNE_FACING_PROP:
+    case ANVIL_PROP:
+    case NETHER_PORTAL_AXIS_PROP:
+    case PICKLE_PROP:
+        return 0x3;
+    case END_PORTAL_PROP:
+        return 0x7;
+    case PRESSURE_PROP:
+    case LANTERN_PROP:
+        return 0x1;
+    case BERRIES_PROP:
+        return 0x2;
+    case BED_PROP:
+        return 0xb;
+    case CANDLE_PROP:
+        return 0x30;
+    default:
+        return 0;
+    }
+}
+
+// classes whose blocks use BIT_16 for waterlogged, on top of getPropertyBits()
+static bool usesWaterloggedBit(int prop, int type)
+{
+    if (!(gBlockDefinitions[type].flags & BLF_MAYWATERLOG)) {
+        return false;
+    }
+    switch (prop) {
+    case SLAB_PROP:
+    case STAIRS_PROP:
+    case TRAPDOOR_PROP:
+    case LANTERN_PROP:
+    case PICKLE_PROP:
+    case FACING_PROP:
+    case CHEST_PROP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Turn the property bits of a data value into properties; the name may change too, e.g. torch to wall_torch.
+// Returns false if the bits don't make a valid state.
+static bool makeStateProperties(int prop, int type, int bits, std::string& name, StateProperties& props)
+{
+    switch (prop) {
+    case AXIS_PROP:
+        if (bits == 0xc) {
+            return false;
+        }
+        if (bits) {
+            addProperty(props, "axis", (bits == 0x4) ? "x" : "z");
+        }
+        else {
+            addProperty(props, "axis", "y");
+        }
+        return true;
+    case QUARTZ_PILLAR_PROP:
+        // 2 is up and down, 3 north-south, 4 east-west
+        if (bits == 0) {
+            return true;
+        }
+        if (bits < 2 || bits > 4) {
+            return false;
+        }
+        addProperty(props, "axis", (bits == 2) ? "y" : ((bits == 3) ? "z" : "x"));
+        return true;
+    case NETHER_PORTAL_AXIS_PROP:
+        if (bits == 1 || bits == 2) {
+            addProperty(props, "axis", (bits == 1) ? "x" : "z");
+            return true;
+        }
+        return bits == 0;
+    case SLAB_PROP:
+        addProperty(props, "type", (bits & 0x8) ? "top" : "bottom");
+        return true;
+    case STAIRS_PROP:
+        addProperty(props, "facing", gFacingStairs[bits & 0x3]);
+        addProperty(props, "half", (bits & 0x4) ? "top" : "bottom");
+        return true;
+    case DOOR_PROP:
+        if (bits & 0x8) {
+            addProperty(props, "half", "upper");
+            addProperty(props, "hinge", (bits & 0x1) ? "right" : "left");
+            addProperty(props, "powered", (bits & 0x2) != 0);
+            return (bits & 0x4) == 0;
+        }
+        addProperty(props, "half", "lower");
+        addProperty(props, "facing", gFacingDoor[bits & 0x3]);
+        addProperty(props, "open", (bits & 0x4) != 0);
+        return true;
+    case TRAPDOOR_PROP:
+        addProperty(props, "facing", gFacingTrapdoor[bits & 0x3]);
+        addProperty(props, "open", (bits & 0x4) != 0);
+        addProperty(props, "half", (bits & 0x8) ? "top" : "bottom");
+        return true;
+    case TORCH_PROP:
+        // 1-4 on a wall facing east, west, south, north; 0 or 5 standing
+        if (bits >= 1 && bits <= 4) {
+            size_t at = name.rfind("torch");
+            if (at == std::string::npos) {
+                return false;
+            }
+            name.insert(at, "wall_");
+            addProperty(props, "facing", gFacingStairs[bits - 1]);
+            return true;
+        }
+        return bits == 0 || bits == 5;
+    case FURNACE_PROP:
+    case FACING_PROP:
+    case CHEST_PROP:
+    case HEAD_WALL_PROP:
+        // 2-5 north, south, west, east
+        if (bits < 2 || bits > 5) {
+            return bits == 0;
+        }
+        addProperty(props, "facing", gFacing6[bits]);
+        return true;
+    case EXTENDED_FACING_PROP:
+        if (bits > 5) {
+            return false;
+        }
+        addProperty(props, "facing", gFacing6[bits]);
+        return true;
+    case SWNE_FACING_PROP:
+    case EXTENDED_SWNE_FACING_PROP:
+    case ANVIL_PROP:
+        addProperty(props, "facing", gFacingSWNE[bits & 0x3]);
+        return true;
+    case END_PORTAL_PROP:
+        addProperty(props, "facing", gFacingSWNE[bits & 0x3]);
+        addProperty(props, "eye", (bits & 0x4) != 0);
+        return true;
+    case FENCE_GATE_PROP:
+        addProperty(props, "facing", gFacingSWNE[bits & 0x3]);
+        addProperty(props, "open", (bits & 0x4) != 0);
+        return true;
+    case BED_PROP:
+        addProperty(props, "facing", gFacingSWNE[bits & 0x3]);
+        addProperty(props, "part", (bits & 0x8) ? "head" : "foot");
+        return true;
+    case BUTTON_PROP:
+    case LEVER_PROP:
+        // 0 ceiling, 1-4 on a wall facing east, west, south, north, 5 floor; levers add 6 floor and 7 ceiling turned sideways
+        if ((bits & 0x7) >= 1 && (bits & 0x7) <= 4) {
+            addProperty(props, "face", "wall");
+            addProperty(props, "facing", gFacingStairs[(bits & 0x7) - 1]);
+        }
+        else if ((bits & 0x7) == 0 || (bits & 0x7) == 7) {
+            if ((bits & 0x7) == 7 && prop == BUTTON_PROP) {
+                return false;
+            }
+            addProperty(props, "face", "ceiling");
+            addProperty(props, "facing", ((bits & 0x7) == 0 && prop == LEVER_PROP) ? "west" : "north");
+        }
+        else {
+            if ((bits & 0x7) == 6 && prop == BUTTON_PROP) {
+                return false;
+            }
+            addProperty(props, "face", "floor");
+            addProperty(props, "facing", ((bits & 0x7) == 6) ? "west" : "north");
+        }
+        addProperty(props, "powered", (bits & 0x8) != 0);
+        return true;
+    case REPEATER_PROP:
+        addProperty(props, "facing", gFacingSWNE[bits & 0x3]);
+        addProperty(props, "delay", ((bits >> 2) & 0x3) + 1);
+        return true;
+    case COMPARATOR_PROP:
+        addProperty(props, "facing", gFacingSWNE[bits & 0x3]);
+        addProperty(props, "mode", (bits & 0x4) ? "subtract" : "compare");
+        addProperty(props, "powered", (bits & 0x8) != 0);
+        return true;
+    case RAIL_PROP:
+        if (type == BLOCK_RAIL) {
+            if (bits > 9) {
+                return false;
+            }
+            addProperty(props, "shape", gRailShape[bits]);
+            return true;
+        }
+        if ((bits & 0x7) > 5) {
+            return false;
+        }
+        addProperty(props, "shape", gRailShape[bits & 0x7]);
+        addProperty(props, "powered", (bits & 0x8) != 0);
+        return true;
+    case FLUID_PROP:
+        addProperty(props, "level", bits);
+        return true;
+    case SNOW_PROP:
+        addProperty(props, "layers", bits + 1);
+        return true;
+    case FARMLAND_PROP:
+        addProperty(props, "moisture", bits);
+        return true;
+    case STANDING_SIGN_PROP:
+    case HEAD_PROP:
+        addProperty(props, "rotation", bits);
+        return true;
+    case WIRE_PROP:
+    case WT_PRESSURE_PROP:
+    case DAYLIGHT_PROP:
+        addProperty(props, "power", bits);
+        return true;
+    case PRESSURE_PROP:
+        addProperty(props, "powered", bits != 0);
+        return true;
+    case AGE_PROP:
+        addProperty(props, "age", bits);
+        return true;
+    case TALL_FLOWER_PROP:
+        addProperty(props, "half", bits ? "upper" : "lower");
+        return true;
+    case PICKLE_PROP:
+        addProperty(props, "pickles", bits + 1);
+        return true;
+    case EGG_PROP:
+        addProperty(props, "eggs", (bits & 0x3) + 1);
+        addProperty(props, "hatch", bits >> 2);
+        return true;
+    case LANTERN_PROP:
+        addProperty(props, "hanging", bits != 0);
+        return true;
+    case BERRIES_PROP:
+        addProperty(props, "berries", bits != 0);
+        return true;
+    case CANDLE_PROP:
+        addProperty(props, "candles", (bits >> 4) + 1);
+        return true;
+    default:
+        return bits == 0;
+    }
+}
+
+// Old types that are a state of another block, such as lit furnaces and double slabs: the type they go with,
+// relative to this one, and the property that makes the difference. type=double is also the property for slabs.
+typedef struct StateVariantType {
+    int prop;
+    int typeOffset;
+    const char* key;
+    const char* value;
+} StateVariantType;
+
+static const StateVariantType gStateVariantTypes[] = {
+    { FURNACE_PROP, 1, "lit", "true" },         // burning furnace
+    { REDSTONE_ORE_PROP, 1, "lit", "true" },    // glowing redstone ore, lit redstone lamp
+    { CANDLE_PROP, 1, "lit", "true" },
+    { REPEATER_PROP, 1, "powered", "true" },
+    { COMPARATOR_PROP, 1, "powered", "true" },
+    { BERRIES_PROP, 1, "berries", "true" },
+    { FLUID_PROP, -1, NULL, NULL },             // flowing water and lava; the level says it all
+    { SLAB_PROP, -1, "type", "double" },
+};
+
+// Gathers the states and their ids while the table is built
+class StateInterner {
+public:
+    unsigned short add(const std::string& s)
+    {
+        std::unordered_map<std::string, unsigned short>::iterator it = ids.find(s);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        unsigned short id = (unsigned short)strings.size();
+        strings.push_back(s);
+        ids[s] = id;
+        return id;
+    }
+    std::vector<std::string> strings;
+private:
+    std::unordered_map<std::string, unsigned short> ids;
+};
+
+static std::vector<std::string> gReverseStrings;
+// string ids, 0 meaning none; the name alone and the full state
+static unsigned short gReverseName[NUM_BLOCKS_DEFINED][256];
+static unsigned short gReverseState[NUM_BLOCKS_DEFINED][256];
+
+static std::string makeStateString(const std::string& name, StateProperties& props)
+{
+    std::sort(props.begin(), props.end());
+    std::string state = name;
+    for (size_t p = 0; p < props.size(); p++) {
+        state += (p == 0) ? "[" : ",";
+        state += props[p].first + "=" + props[p].second;
+    }
+    if (!props.empty()) {
+        state += "]";
+    }
+    return state;
+}
+
+static void fillReverseCells(StateInterner& interner, const char* btName, int prop, int type, int baseData, const char* extraKey, const char* extraValue)
+{
+    int bits = getPropertyBits(prop);
+    bool waterlogged = usesWaterloggedBit(prop, type) && !(baseData & BIT_16);
+    if (waterlogged) {
+        bits |= BIT_16;
+    }
+    for (int d = 0; d < 256; d++) {
+        if ((d & ~bits) != baseData || gReverseState[type][d] != 0) {
+            continue;
+        }
+        std::string name = btName;
+        StateProperties props;
+        if (!makeStateProperties(prop, type, d & bits & ~(waterlogged ? BIT_16 : 0), name, props)) {
+            continue;
+        }
+        if (extraKey != NULL) {
+            // a double slab's type replaces top or bottom
+            for (size_t p = 0; p < props.size(); p++) {
+                if (props[p].first == extraKey) {
+                    props.erase(props.begin() + p);
+                    break;
+                }
+            }
+            addProperty(props, extraKey, extraValue);
+        }
+        if (waterlogged) {
+            addProperty(props, "waterlogged", (d & BIT_16) != 0);
+        }
+        gReverseName[type][d] = interner.add(name);
+        gReverseState[type][d] = interner.add(makeStateString(name, props));
+    }
+}
+
+static bool buildReverseTranslations()
+{
+    StateInterner interner;
+    // id 0 is "none"
+    interner.add("");
+    memset(gReverseName, 0, sizeof(gReverseName));
+    memset(gReverseState, 0, sizeof(gReverseState));
+
+    // types named in the table in their own right, which are never taken as a state of another type
+    std::vector<bool> hasOwnNames(NUM_BLOCKS_DEFINED, false);
+    for (int i = 0; i < NUM_TRANS; i++) {
+        int type, baseData;
+        if (BlockTranslations[i].name != NULL) {
+            getTranslationTypeAndData(BlockTranslations[i], type, baseData);
+            if (type < NUM_BLOCKS_DEFINED) {
+                hasOwnNames[type] = true;
+            }
+        }
+    }
+
+    // first entry in table order wins, as when reading
+    for (int i = 0; i < NUM_TRANS; i++) {
+        const BlockTranslator& bt = BlockTranslations[i];
+        if (bt.name == NULL || isUnwrittenName(bt.name)) {
+            continue;
+        }
+        int type, baseData;
+        getTranslationTypeAndData(bt, type, baseData);
+        if (type >= NUM_BLOCKS_DEFINED) {
+            continue;
+        }
+        int prop = (int)bt.translateFlags;
+        fillReverseCells(interner, bt.name, prop, type, baseData, NULL, NULL);
+
+        for (int v = 0; v < (int)(sizeof(gStateVariantTypes) / sizeof(gStateVariantTypes[0])); v++) {
+            const StateVariantType& svt = gStateVariantTypes[v];
+            int variantType = type + svt.typeOffset;
+            if (svt.prop != prop || variantType < 0 || variantType >= NUM_BLOCKS_DEFINED) {
+                continue;
+            }
+            // only where the neighboring type really is the variant, e.g. "Double Stone Slab" next to "Stone Slab"
+            if (prop == SLAB_PROP && strncmp(gBlockDefinitions[variantType].name, "Double ", 7) != 0) {
+                continue;
+            }
+            if (prop != SLAB_PROP && prop != FLUID_PROP && (hasOwnNames[variantType] || strcmp(gBlockDefinitions[variantType].name, "(unused)") == 0)) {
+                continue;
+            }
+            fillReverseCells(interner, bt.name, prop, variantType, baseData, svt.key, svt.value);
+        }
+        // the unlit redstone torch is the one before the lit one
+        if (prop == TORCH_PROP && strcmp(bt.name, "redstone_torch") == 0 && !hasOwnNames[type - 1]) {
+            fillReverseCells(interner, bt.name, prop, type - 1, baseData, "lit", "false");
+        }
+        // inverted daylight sensors are a type of their own
+        if (prop == DAYLIGHT_PROP) {
+            fillReverseCells(interner, bt.name, prop, BLOCK_INVERTED_DAYLIGHT_SENSOR, baseData, "inverted", "true");
+        }
+    }
+
+    // anything left over gets the type's first name, in its default state
+    for (int type = 0; type < NUM_BLOCKS_DEFINED; type++) {
+        unsigned short firstName = 0;
+        for (int d = 0; d < 256 && firstName == 0; d++) {
+            firstName = gReverseName[type][d];
+        }
+        for (int d = 0; d < 256; d++) {
+            if (gReverseState[type][d] == 0) {
+                gReverseName[type][d] = firstName;
+                gReverseState[type][d] = firstName;
+            }
+        }
+    }
+    gReverseStrings.swap(interner.strings);
+    return true;
+}
+
+static void makeReverseTranslations()
+{
+    // built once, safely even if many threads ask at the same time
+    static bool built = buildReverseTranslations();
+    (void)built;
+}
+
+const char* getBlockNameForType(int type, int dataVal)
+{
+    if (type < 0 || type >= NUM_BLOCKS_DEFINED || dataVal < 0 || dataVal > 255) {
+        return NULL;
+    }
+    makeReverseTranslations();
+    unsigned short id = gReverseName[type][dataVal];
+    return id ? gReverseStrings[id].c_str() : NULL;
+}
+
+const char* getBlockStateForType(int type, int dataVal)
+{
+    if (type < 0 || type >= NUM_BLOCKS_DEFINED || dataVal < 0 || dataVal > 255) {
+        return NULL;
+    }
+    makeReverseTranslations();
+    unsigned short id = gReverseState[type][dataVal];
+    return id ? gReverseStrings[id].c_str() : NULL;
+}
+
+int getBlockTranslationCount()
+{
+    return NUM_TRANS;
+}
+
+const char* getBlockTranslation(int i, int& type, int& dataVal, unsigned long& translateFlags)
+{
+    if (i < 0 || i >= NUM_TRANS || BlockTranslations[i].name == NULL) {
+        type = dataVal = 0;
+        translateFlags = 0;
+        return NULL;
+    }
+    getTranslationTypeAndData(BlockTranslations[i], type, dataVal);
+    translateFlags = BlockTranslations[i].translateFlags;
+    return BlockTranslations[i].name;
+}
@@ -0,0 +1,262 @@
+// nbtView.cpp - walk NBT held in memory without copying it, in Java's big-endian or Bedrock's little-endian byte order
+
+#include "stdafx.h"
+#include <string.h>
+#include "nbtView.h"
+
+// deeper than any real file nests; stops a damaged or hostile file from overflowing the stack
+#define NBT_MAX_DEPTH 512
+
+static bool hasBytes(const NbtView& view, const unsigned char* p, size_t count)
+{
+    return p != NULL && p >= view.data && (size_t)(view.data + view.size - p) >= count;
+}
+
+static int elementSize(int type)
+{
+    switch (type) {
+    case NBT_TAG_BYTE:
+        return 1;
+    case NBT_TAG_SHORT:
+        return 2;
+    case NBT_TAG_INT:
+    case NBT_TAG_FLOAT:
+        return 4;
+    case NBT_TAG_LONG:
+    case NBT_TAG_DOUBLE:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+// a tag's type and name at p, and where its payload begins; NULL at NBT_TAG_END or if damaged
+static const unsigned char* readTagHeader(const NbtView& view, const unsigned char* p, NbtTag& tag)
+{
+    if (!hasBytes(view, p, 1) || *p == NBT_TAG_END) {
+        return NULL;
+    }
+    tag.type = *p++;
+    if (!hasBytes(view, p, 2)) {
+        return NULL;
+    }
+    int nameLength = (unsigned short)nbtReadShort(view, p);
+    p += 2;
+    if (!hasBytes(view, p, nameLength)) {
+        return NULL;
+    }
+    tag.name = (const char*)p;
+    tag.nameLength = nameLength;
+    tag.payload = p + nameLength;
+    return tag.payload;
+}
+
+static const unsigned char* skipPayload(const NbtView& view, int type, const unsigned char* p, int depth)
+{
+    if (depth > NBT_MAX_DEPTH) {
+        return NULL;
+    }
+    int size = elementSize(type);
+    if (size > 0) {
+        return hasBytes(view, p, size) ? p + size : NULL;
+    }
+    switch (type) {
+    case NBT_TAG_STRING:
+        if (!hasBytes(view, p, 2)) {
+            return NULL;
+        }
+        size = (unsigned short)nbtReadShort(view, p);
+        return hasBytes(view, p + 2, size) ? p + 2 + size : NULL;
+    case NBT_TAG_BYTE_ARRAY:
+    case NBT_TAG_INT_ARRAY:
+    case NBT_TAG_LONG_ARRAY:
+    {
+        if (!hasBytes(view, p, 4)) {
+            return NULL;
+        }
+        int count = nbtReadInt(view, p);
+        size_t bytes = (size_t)count * ((type == NBT_TAG_BYTE_ARRAY) ? 1 : ((type == NBT_TAG_INT_ARRAY) ? 4 : 8));
+        return (count >= 0 && hasBytes(view, p + 4, bytes)) ? p + 4 + bytes : NULL;
+    }
+    case NBT_TAG_LIST:
+    {
+        if (!hasBytes(view, p, 5)) {
+            return NULL;
+        }
+        int elementType = p[0];
+        int count = nbtReadInt(view, p + 1);
+        p += 5;
+        if (count <= 0) {
+            return p;
+        }
+        size = elementSize(elementType);
+        if (size > 0) {
+            return hasBytes(view, p, (size_t)count * size) ? p + (size_t)count * size : NULL;
+        }
+        for (int i = 0; i < count && p != NULL; i++) {
+            p = skipPayload(view, elementType, p, depth + 1);
+        }
+        return p;
+    }
+    case NBT_TAG_COMPOUND:
+        for (;;) {
+            if (!hasBytes(view, p, 1)) {
+                return NULL;
+            }
+            if (*p == NBT_TAG_END) {
+                return p + 1;
+            }
+            NbtTag child;
+            p = readTagHeader(view, p, child);
+            if (p == NULL) {
+                return NULL;
+            }
+            p = skipPayload(view, child.type, p, depth + 1);
+            if (p == NULL) {
+                return NULL;
+            }
+        }
+    default:
+        return NULL;
+    }
+}
+
+const unsigned char* nbtSkipPayload(const NbtView& view, int type, const unsigned char* p)
+{
+    return skipPayload(view, type, p, 0);
+}
+
+bool nbtGetRoot(const NbtView& view, NbtTag& root)
+{
+    return readTagHeader(view, view.data, root) != NULL && root.type == NBT_TAG_COMPOUND;
+}
+
+bool nbtNameIs(const NbtTag& tag, const char* name)
+{
+    // by length first, as a damaged name may hold a '\0'
+    return tag.name != NULL && strlen(name) == (size_t)tag.nameLength && memcmp(tag.name, name, tag.nameLength) == 0;
+}
+
+bool nbtIterate(const NbtView& view, const NbtTag& tag, NbtIterator& it)
+{
+    if (tag.type == NBT_TAG_COMPOUND) {
+        it.next = tag.payload;
+        it.remaining = -1;
+        it.elementType = NBT_TAG_END;
+        return true;
+    }
+    if (tag.type == NBT_TAG_LIST && hasBytes(view, tag.payload, 5)) {
+        it.elementType = tag.payload[0];
+        it.remaining = nbtReadInt(view, tag.payload + 1);
+        if (it.remaining < 0) {
+            it.remaining = 0;
+        }
+        it.next = tag.payload + 5;
+        return true;
+    }
+    return false;
+}
+
+bool nbtNext(const NbtView& view, NbtIterator& it, NbtTag& tag)
+{
+    if (it.next == NULL) {
+        return false;
+    }
+    if (it.remaining < 0) {
+        // compound child
+        if (readTagHeader(view, it.next, tag) == NULL) {
+            it.next = NULL;
+            return false;
+        }
+    }
+    else {
+        if (it.remaining == 0) {
+            return false;
+        }
+        it.remaining--;
+        tag.type = it.elementType;
+        tag.payload = it.next;
+        tag.name = NULL;
+        tag.nameLength = 0;
+    }
+    it.next = skipPayload(view, tag.type, tag.payload, 0);
+    return it.next != NULL;
+}
+
+bool nbtFindChild(const NbtView& view, const NbtTag& compound, const char* name, NbtTag& child)
+{
+    NbtIterator it;
+    if (compound.type != NBT_TAG_COMPOUND || !nbtIterate(view, compound, it)) {
+        return false;
+    }
+    while (nbtNext(view, it, child)) {
+        if (nbtNameIs(child, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool nbtGetArray(const NbtView& view, const NbtTag& tag, int& elementType, int& count, const unsigned char*& elements)
+{
+    const unsigned char* p = tag.payload;
+    switch (tag.type) {
+    case NBT_TAG_LIST:
+        if (!hasBytes(view, p, 5)) {
+            return false;
+        }
+        elementType = p[0];
+        p++;
+        break;
+    case NBT_TAG_BYTE_ARRAY:
+        elementType = NBT_TAG_BYTE;
+        break;
+    case NBT_TAG_INT_ARRAY:
+        elementType = NBT_TAG_INT;
+        break;
+    case NBT_TAG_LONG_ARRAY:
+        elementType = NBT_TAG_LONG;
+        break;
+    default:
+        return false;
+    }
+    if (!hasBytes(view, p, 4)) {
+        return false;
+    }
+    count = nbtReadInt(view, p);
+    if (count < 0) {
+        return false;
+    }
+    elements = p + 4;
+    // packed elements must all be there; others are checked as they are walked
+    int size = elementSize(elementType);
+    return size == 0 || hasBytes(view, elements, (size_t)count * size);
+}
+
+int nbtGetInt(const NbtView& view, const NbtTag& tag)
+{
+    switch (tag.type) {
+    case NBT_TAG_BYTE:
+        return (signed char)tag.payload[0];
+    case NBT_TAG_SHORT:
+        return nbtReadShort(view, tag.payload);
+    case NBT_TAG_INT:
+        return nbtReadInt(view, tag.payload);
+    case NBT_TAG_LONG:
+        // the low 32 bits are the first four bytes in little-endian, the last four in big-endian
+        return nbtReadInt(view, view.littleEndian ? tag.payload : tag.payload + 4);
+    default:
+        return 0;
+    }
+}
+
+bool nbtGetString(const NbtView& view, const NbtTag& tag, const char*& s, int& length)
+{
+    if (tag.type != NBT_TAG_STRING) {
+        return false;
+    }
+    // nbtNext() and nbtFindChild() have already checked that the whole string is there
+    length = (unsigned short)nbtReadShort(view, tag.payload);
+    s = (const char*)tag.payload + 2;
+    return true;
+}
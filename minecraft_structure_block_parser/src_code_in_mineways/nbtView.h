@@ -0,0 +1,72 @@
+// nbtView.h - walk NBT held in memory without copying it, in Java's big-endian or Bedrock's little-endian byte order
+
+#pragma once
+
+#include <stddef.h>
+
+#define NBT_TAG_END         0
+#define NBT_TAG_BYTE        1
+#define NBT_TAG_SHORT       2
+#define NBT_TAG_INT         3
+#define NBT_TAG_LONG        4
+#define NBT_TAG_FLOAT       5
+#define NBT_TAG_DOUBLE      6
+#define NBT_TAG_BYTE_ARRAY  7
+#define NBT_TAG_STRING      8
+#define NBT_TAG_LIST        9
+#define NBT_TAG_COMPOUND    10
+#define NBT_TAG_INT_ARRAY   11
+#define NBT_TAG_LONG_ARRAY  12
+
+// Tags point into the data, which must outlive them; nothing is allocated. Every read is checked against
+// the end of the data, so a damaged file gives false or 0 rather than reading past it.
+typedef struct NbtView {
+    const unsigned char* data;
+    size_t size;
+    bool littleEndian;      // Bedrock .mcstructure and level.dat; Java is big-endian
+} NbtView;
+
+typedef struct NbtTag {
+    int type;                       // NBT_TAG_*
+    const unsigned char* payload;   // in the view's data
+    const char* name;               // not terminated; NULL for list elements
+    int nameLength;
+} NbtTag;
+
+typedef struct NbtIterator {
+    const unsigned char* next;
+    int remaining;          // list elements left, or -1 for a compound
+    int elementType;
+} NbtIterator;
+
+// the unnamed root compound (Java files give it an empty name; its name is not checked)
+bool nbtGetRoot(const NbtView& view, NbtTag& root);
+// a compound's child by name
+bool nbtFindChild(const NbtView& view, const NbtTag& compound, const char* name, NbtTag& child);
+// step through a compound's children or a list's elements
+bool nbtIterate(const NbtView& view, const NbtTag& tag, NbtIterator& it);
+bool nbtNext(const NbtView& view, NbtIterator& it, NbtTag& tag);
+
+// Element type and count of a list, or the count of a byte, int or long array, with where the elements begin.
+// For lists of numbers and arrays the elements are packed, so they can be read in place with nbtReadInt() etc.
+bool nbtGetArray(const NbtView& view, const NbtTag& tag, int& elementType, int& count, const unsigned char*& elements);
+
+// Byte, short, int or long as an int (longs are cut to 32 bits); 0 for anything else.
+int nbtGetInt(const NbtView& view, const NbtTag& tag);
+bool nbtGetString(const NbtView& view, const NbtTag& tag, const char*& s, int& length);
+bool nbtNameIs(const NbtTag& tag, const char* name);
+
+// where a payload of this type starting at p ends, or NULL if it runs past the end of the data
+const unsigned char* nbtSkipPayload(const NbtView& view, int type, const unsigned char* p);
+
+inline int nbtReadShort(const NbtView& view, const unsigned char* p)
+{
+    return view.littleEndian ? (short)(p[0] | (p[1] << 8)) : (short)((p[0] << 8) | p[1]);
+}
+
+inline int nbtReadInt(const NbtView& view, const unsigned char* p)
+{
+    return view.littleEndian ?
+        (int)((unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24)) :
+        (int)(((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | (unsigned int)p[3]);
+}
@@ -0,0 +1,316 @@
+// propertyParser.cpp - recognize block property keys and values, and turn a block state into Mineways' type and data value
+
+#include "stdafx.h"
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "blockNames.h"
+#include "propertyVocabulary.h"
+#include "propertyParser.h"
+
+// longest state packBlockState() is built from, in properties
+#define MAX_STATE_PROPERTIES 32
+
+// keep in step with property_hash() in ../gen_property_vocabulary.py
+static unsigned int propertyHash(const char* s, int length, unsigned int seed)
+{
+    unsigned int hash = seed;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)s[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int findInTable(const char* s, int length, const char* const* names, const unsigned short* seeds, int bucketCount, const short* slots, int hashBits)
+{
+    int bucket = (int)(propertyHash(s, length, PROPERTY_BUCKET_SEED) % (unsigned int)bucketCount);
+    int id = slots[propertyHash(s, length, seeds[bucket]) >> (32 - hashBits)];
+    // length first, so a name with a '\0' in it never reads past the end of a shorter stored one
+    if (id < 0 || strlen(names[id]) != (size_t)length || memcmp(names[id], s, length) != 0) {
+        return -1;
+    }
+    return id;
+}
+
+int findPropertyKey(const char* key, int length)
+{
+    return findInTable(key, length, gPropertyKeyNames, gPropertyKeySeeds, PROPERTY_KEY_BUCKETS, gPropertyKeySlots, PROPERTY_KEY_HASH_BITS);
+}
+
+int findPropertyValue(const char* value, int length)
+{
+    if (length > 0 && length <= 3 && value[0] >= '0' && value[0] <= '9') {
+        int n = 0;
+        for (int i = 0; i < length; i++) {
+            if (value[i] < '0' || value[i] > '9') {
+                return -1;
+            }
+            n = n * 10 + (value[i] - '0');
+        }
+        return (n <= PROPERTY_NUMBER_MAX) ? PROPERTY_VALUE_COUNT + n : -1;
+    }
+    return findInTable(value, length, gPropertyValueNames, gPropertyValueSeeds, PROPERTY_VALUE_BUCKETS, gPropertyValueSlots, PROPERTY_VALUE_HASH_BITS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The packing table
+
+// a key and value in one number
+static unsigned int pairCode(int key, int value)
+{
+    return (unsigned int)key * (PROPERTY_VALUE_COUNT + PROPERTY_NUMBER_MAX + 1) + (unsigned int)value;
+}
+
+static unsigned long long mixCode(unsigned long long x)
+{
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+typedef struct PackState {
+    unsigned int typeData;  // type << 8 | dataVal
+    int firstPair;          // its pairs, sorted, in gPackStatePairs
+    int pairCount;
+} PackState;
+
+typedef struct PackName {
+    // pairs that some state of this name has, sorted; any other pair can't change the data value
+    std::vector<unsigned int> pairs;
+    // its distinct states, in type and dataVal order
+    std::vector<PackState> states;
+} PackName;
+
+static std::unordered_map<std::string, int> gPackNameIds;
+static std::vector<PackName> gPackNames;
+static std::vector<unsigned int> gPackStatePairs;
+// signature of name and pairs, to type << 8 | dataVal
+static std::unordered_map<unsigned long long, unsigned int> gPackStates;
+
+static int getPairKey(unsigned int code)
+{
+    return (int)(code / (PROPERTY_VALUE_COUNT + PROPERTY_NUMBER_MAX + 1));
+}
+
+// Signature of a state: the name's id and its pairs mixed, and summed so order doesn't matter.
+static unsigned long long stateSignature(int nameId, const unsigned int* codes, int count)
+{
+    unsigned long long signature = mixCode((unsigned long long)nameId << 32);
+    for (int i = 0; i < count; i++) {
+        signature += mixCode(codes[i] + 1);
+    }
+    return signature;
+}
+
+// Of a name's states, the one that agrees with the most of the given pairs and disagrees with the fewest;
+// a pair the state doesn't have counts as neither, as does a key the pairs don't give (it takes its default).
+static unsigned int closestState(const PackName& packName, const unsigned int* codes, int count)
+{
+    unsigned int best = packName.states[0].typeData;
+    int bestScore = -MAX_STATE_PROPERTIES - 1;
+    for (size_t s = 0; s < packName.states.size(); s++) {
+        const PackState& state = packName.states[s];
+        int score = 0;
+        for (int p = 0; p < state.pairCount; p++) {
+            unsigned int code = gPackStatePairs[state.firstPair + p];
+            for (int i = 0; i < count; i++) {
+                if (codes[i] == code) {
+                    score++;
+                    break;
+                }
+                if (getPairKey(codes[i]) == getPairKey(code)) {
+                    score--;
+                    break;
+                }
+            }
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            best = state.typeData;
+        }
+    }
+    return best;
+}
+
+// split "name[key=value,...]" into the name and property ids; false if it has too many properties
+static bool splitState(const char* state, std::string& name, int* keys, int* values, int& count)
+{
+    if (strncmp(state, "minecraft:", 10) == 0) {
+        state += 10;
+    }
+    const char* bracket = strchr(state, '[');
+    name.assign(state, bracket ? (size_t)(bracket - state) : strlen(state));
+    count = 0;
+    if (bracket == NULL) {
+        return true;
+    }
+    const char* p = bracket + 1;
+    while (*p != '\0' && *p != ']') {
+        const char* equals = strchr(p, '=');
+        if (equals == NULL || count >= MAX_STATE_PROPERTIES) {
+            return false;
+        }
+        const char* end = equals + 1;
+        while (*end != '\0' && *end != ',' && *end != ']') {
+            end++;
+        }
+        keys[count] = findPropertyKey(p, (int)(equals - p));
+        values[count] = findPropertyValue(equals + 1, (int)(end - equals - 1));
+        count++;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return true;
+}
+
+static int addPackName(const std::string& name)
+{
+    int nameId = (int)gPackNames.size();
+    gPackNameIds[name] = nameId;
+    gPackNames.push_back(PackName());
+    return nameId;
+}
+
+static void addPackState(int nameId, unsigned int typeData, const unsigned int* codes, int count)
+{
+    if (gPackStates.emplace(stateSignature(nameId, codes, count), typeData).second) {
+        PackState state = { typeData, (int)gPackStatePairs.size(), count };
+        gPackStatePairs.insert(gPackStatePairs.end(), codes, codes + count);
+        gPackNames[nameId].states.push_back(state);
+    }
+}
+
+static bool buildPackTable()
+{
+    // every state the reverse table can write, in type and dataVal order, so the first dataVal for a state wins
+    for (int type = 0; type < NUM_BLOCKS_DEFINED; type++) {
+        for (int dataVal = 0; dataVal < 256; dataVal++) {
+            const char* state = getBlockStateForType(type, dataVal);
+            std::string name;
+            int keys[MAX_STATE_PROPERTIES];
+            int values[MAX_STATE_PROPERTIES];
+            int count;
+            if (state == NULL || !splitState(state, name, keys, values, count)) {
+                continue;
+            }
+            std::unordered_map<std::string, int>::iterator it = gPackNameIds.find(name);
+            int nameId = (it == gPackNameIds.end()) ? addPackName(name) : it->second;
+            unsigned int codes[MAX_STATE_PROPERTIES];
+            int codeCount = 0;
+            for (int i = 0; i < count; i++) {
+                if (keys[i] >= 0 && values[i] >= 0) {
+                    codes[codeCount++] = pairCode(keys[i], values[i]);
+                }
+            }
+            std::sort(codes, codes + codeCount);
+            addPackState(nameId, (unsigned int)(type << 8 | dataVal), codes, codeCount);
+            gPackNames[nameId].pairs.insert(gPackNames[nameId].pairs.end(), codes, codes + codeCount);
+        }
+    }
+    for (size_t n = 0; n < gPackNames.size(); n++) {
+        std::vector<unsigned int>& pairs = gPackNames[n].pairs;
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    }
+
+    // Names that read fine but are never written, such as red_bed, whose cells all went to an earlier
+    // name (black_bed). Each gets the states of the name owning its cell, moved to its own type and data.
+    int translationCount = getBlockTranslationCount();
+    for (int i = 0; i < translationCount; i++) {
+        int type, dataVal;
+        unsigned long translateFlags;
+        const char* name = getBlockTranslation(i, type, dataVal, translateFlags);
+        if (name == NULL || type >= NUM_BLOCKS_DEFINED || gPackNameIds.find(name) != gPackNameIds.end()) {
+            continue;
+        }
+        const char* ownerName = getBlockNameForType(type, dataVal);
+        std::unordered_map<std::string, int>::iterator owner = (ownerName != NULL) ? gPackNameIds.find(ownerName) : gPackNameIds.end();
+        if (owner == gPackNameIds.end()) {
+            continue;
+        }
+        int ownerType = -1, ownerData = 0;
+        for (int j = 0; j < translationCount && ownerType < 0; j++) {
+            int t, d;
+            const char* n = getBlockTranslation(j, t, d, translateFlags);
+            if (n != NULL && strcmp(n, ownerName) == 0) {
+                ownerType = t;
+                ownerData = d;
+            }
+        }
+        if (ownerType < 0) {
+            continue;
+        }
+        int ownerId = owner->second;
+        int aliasId = addPackName(name);
+        gPackNames[aliasId].pairs = gPackNames[ownerId].pairs;
+        for (size_t s = 0; s < gPackNames[ownerId].states.size(); s++) {
+            PackState state = gPackNames[ownerId].states[s];
+            int stateType = (int)(state.typeData >> 8) + type - ownerType;
+            int stateData = ((int)(state.typeData & 0xff) & ~ownerData) | dataVal;
+            if (stateType >= 0 && stateType < NUM_BLOCKS_DEFINED) {
+                // copy the pairs first, as adding may move gPackStatePairs
+                std::vector<unsigned int> codes(gPackStatePairs.begin() + state.firstPair, gPackStatePairs.begin() + state.firstPair + state.pairCount);
+                addPackState(aliasId, (unsigned int)(stateType << 8 | (stateData & 0xff)), codes.data(), (int)codes.size());
+            }
+        }
+        if (gPackNames[aliasId].states.empty()) {
+            gPackNameIds.erase(name);
+        }
+    }
+    return true;
+}
+
+bool packBlockState(const char* name, int nameLength, const int* keys, const int* values, int count, int& type, int& dataVal)
+{
+    // built once, safely even if many threads ask at the same time
+    static bool built = buildPackTable();
+    (void)built;
+
+    if (nameLength >= 10 && strncmp(name, "minecraft:", 10) == 0) {
+        name += 10;
+        nameLength -= 10;
+    }
+    std::unordered_map<std::string, int>::const_iterator it = gPackNameIds.find(std::string(name, nameLength));
+    if (it == gPackNameIds.end()) {
+        return false;
+    }
+    const PackName& packName = gPackNames[it->second];
+
+    // pairs the name never has can't change the data value
+    unsigned int codes[MAX_STATE_PROPERTIES];
+    int codeCount = 0;
+    for (int i = 0; i < count && codeCount < MAX_STATE_PROPERTIES; i++) {
+        if (keys[i] >= 0 && values[i] >= 0) {
+            unsigned int code = pairCode(keys[i], values[i]);
+            if (std::binary_search(packName.pairs.begin(), packName.pairs.end(), code)) {
+                codes[codeCount++] = code;
+            }
+        }
+    }
+    // usually the pairs are exactly those of one state; if not, e.g. Bedrock leaving out waterlogged or
+    // a door's upper half giving facing, which Mineways keeps only on the lower half, find the closest
+    // the name alone, which could match a leftover cell with no properties, takes the first state instead
+    std::unordered_map<unsigned long long, unsigned int>::const_iterator state = gPackStates.end();
+    if (codeCount > 0 || packName.pairs.empty()) {
+        state = gPackStates.find(stateSignature(it->second, codes, codeCount));
+    }
+    unsigned int typeData = (state != gPackStates.end()) ? state->second : closestState(packName, codes, codeCount);
+    type = (int)(typeData >> 8);
+    dataVal = (int)(typeData & 0xff);
+    return true;
+}
+
+bool parseBlockState(const char* state, int& type, int& dataVal)
+{
+    std::string name;
+    int keys[MAX_STATE_PROPERTIES];
+    int values[MAX_STATE_PROPERTIES];
+    int count;
+    if (!splitState(state, name, keys, values, count)) {
+        return false;
+    }
+    return packBlockState(name.c_str(), (int)name.length(), keys, values, count, type, dataVal);
+}
@@ -0,0 +1,26 @@
+// propertyParser.h - recognize block property keys and values, and turn a block state into Mineways' type and data value
+
+#pragma once
+
+// Keys and values are the PK_* and PV_* ids of propertyVocabulary.h, which ../gen_property_vocabulary.py
+// makes from nbt.cpp. Each is found with two hashes and one string compare, using a perfect hash table.
+
+// whole-number values, such as age=3, are PROPERTY_VALUE_COUNT + the number, up to this
+#define PROPERTY_NUMBER_MAX 255
+
+// PK_* id, or -1 if the key is not one Mineways knows
+int findPropertyKey(const char* key, int length);
+// PV_* id, PROPERTY_VALUE_COUNT + n for the number n, or -1 if unknown
+int findPropertyValue(const char* value, int length);
+
+// Type and data value for a block name (with or without "minecraft:") and its properties, as ids from the
+// functions above. This is the reverse of getBlockStateForType() (blockNames.h), made into a table the
+// first time it's called: the name and the property pairs that matter for that name are hashed together
+// and looked up once. Pairs that don't change a name's data value, such as stairs' shape, are skipped,
+// and so are ids of -1. If no state has exactly the pairs given, as when some are left out, the state
+// agreeing with the most of them is used; missing ones take their first value. Returns false if the
+// name is not known.
+bool packBlockState(const char* name, int nameLength, const int* keys, const int* values, int count, int& type, int& dataVal);
+
+// same, from the text form "name[key=value,...]", as in Sponge schematic palettes
+bool parseBlockState(const char* state, int& type, int& dataVal);
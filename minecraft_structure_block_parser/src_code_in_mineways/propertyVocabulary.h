@@ -0,0 +1,208 @@
+// propertyVocabulary.h - block property keys and values, with perfect hash tables for them; made by
+// ../gen_property_vocabulary.py from nbt.cpp, so do not edit by hand
+
+#pragma once
+
+// Values that are whole numbers, such as age=3 and power=15, are not listed; see findPropertyValue().
+
+#define PROPERTY_BUCKET_SEED 2166136261u
+
+#define PROPERTY_KEY_COUNT 67
+#define PK_AGE                      0
+#define PK_ATTACHED                 1
+#define PK_ATTACHMENT               2
+#define PK_AXIS                     3
+#define PK_BERRIES                  4
+#define PK_BITES                    5
+#define PK_BOTTOM                   6
+#define PK_CANDLES                  7
+#define PK_CONDITIONAL              8
+#define PK_CREAKING_HEART_STATE     9
+#define PK_DELAY                    10
+#define PK_DELAYED                  11
+#define PK_DISARMED                 12
+#define PK_DISTANCE                 13
+#define PK_DOWN                     14
+#define PK_EAST                     15
+#define PK_EGGS                     16
+#define PK_ENABLED                  17
+#define PK_EXTENDED                 18
+#define PK_EYE                      19
+#define PK_FACE                     20
+#define PK_FACING                   21
+#define PK_FALLING                  22
+#define PK_FLOWER_AMOUNT            23
+#define PK_HALF                     24
+#define PK_HANGING                  25
+#define PK_HAS_BOOK                 26
+#define PK_HATCH                    27
+#define PK_HINGE                    28
+#define PK_IN_WALL                  29
+#define PK_INSTRUMENT               30
+#define PK_INVERTED                 31
+#define PK_LAYERS                   32
+#define PK_LEAVES                   33
+#define PK_LEVEL                    34
+#define PK_LIT                      35
+#define PK_LOCKED                   36
+#define PK_MODE                     37
+#define PK_MOISTURE                 38
+#define PK_NORTH                    39
+#define PK_NOTE                     40
+#define PK_OCCUPIED                 41
+#define PK_OLD                      42
+#define PK_OPEN                     43
+#define PK_ORIENTATION              44
+#define PK_PART                     45
+#define PK_PERSISTENT               46
+#define PK_PICKLES                  47
+#define PK_POWER                    48
+#define PK_POWERED                  49
+#define PK_ROTATION                 50
+#define PK_SCULK_SENSOR_PHASE       51
+#define PK_SEGMENT_AMOUNT           52
+#define PK_SHAPE                    53
+#define PK_SHORT                    54
+#define PK_SIGNAL_FIRE              55
+#define PK_SNOWY                    56
+#define PK_SOUTH                    57
+#define PK_STAGE                    58
+#define PK_THICKNESS                59
+#define PK_TILT                     60
+#define PK_TRIGGERED                61
+#define PK_TYPE                     62
+#define PK_UP                       63
+#define PK_VERTICAL_DIRECTION       64
+#define PK_WATERLOGGED              65
+#define PK_WEST                     66
+
+static const char* const gPropertyKeyNames[PROPERTY_KEY_COUNT] = {
+    "age", "attached", "attachment", "axis", "berries", "bites", "bottom", "candles",
+    "conditional", "creaking_heart_state", "delay", "delayed", "disarmed", "distance", "down", "east",
+    "eggs", "enabled", "extended", "eye", "face", "facing", "falling", "flower_amount",
+    "half", "hanging", "has_book", "hatch", "hinge", "in_wall", "instrument", "inverted",
+    "layers", "leaves", "level", "lit", "locked", "mode", "moisture", "north",
+    "note", "occupied", "old", "open", "orientation", "part", "persistent", "pickles",
+    "power", "powered", "rotation", "sculk_sensor_phase", "segment_amount", "shape", "short", "signal_fire",
+    "snowy", "south", "stage", "thickness", "tilt", "triggered", "type", "up",
+    "vertical_direction", "waterlogged", "west",
+};
+#define PROPERTY_KEY_BUCKETS 34
+static const unsigned short gPropertyKeySeeds[PROPERTY_KEY_BUCKETS] = {
+    1, 1, 1, 4, 1, 1, 3, 1, 1, 0, 2, 1, 2, 1, 0, 2,
+    1, 1, 1, 1, 1, 1, 1, 0, 2, 1, 2, 1, 0, 1, 1, 1,
+    1, 3,
+};
+#define PROPERTY_KEY_HASH_BITS 8
+static const short gPropertyKeySlots[1 << PROPERTY_KEY_HASH_BITS] = {
+    -1, -1, -1, -1, -1, -1, -1, 16, -1, -1, -1, -1, -1, 49, 12, -1,
+    -1, 30, 38, 22, -1, -1, 3, 57, -1, 31, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, 17, -1, 34, -1, 41, -1, -1, -1, -1,
+    -1, 37, -1, 51, -1, 62, -1, -1, -1, -1, -1, 0, -1, -1, -1, 29,
+    59, -1, -1, -1, -1, -1, -1, -1, -1, 54, -1, -1, -1, -1, -1, -1,
+    -1, 23, -1, 11, -1, -1, 19, -1, -1, -1, 7, 21, 64, 28, -1, -1,
+    36, 55, -1, -1, -1, -1, -1, 60, 58, -1, -1, 46, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 63, -1, -1, -1, -1,
+    44, -1, -1, -1, 65, 13, 42, -1, -1, 50, 53, -1, -1, -1, -1, -1,
+    -1, -1, 10, 6, -1, -1, -1, -1, -1, 5, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 14, -1, 20, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 56, -1, -1, -1, -1, 39,
+    -1, -1, 33, -1, -1, 4, -1, -1, -1, 8, -1, 66, -1, -1, -1, -1,
+    -1, -1, 15, 27, -1, -1, -1, 52, 32, 24, 2, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, 25, -1, -1, 35, 9, -1, -1, -1, 48, -1, -1, -1,
+    -1, 18, -1, 40, 45, 61, -1, -1, -1, 47, 43, -1, -1, -1, 26, -1,
+};
+
+#define PROPERTY_VALUE_COUNT 64
+#define PV_ACTIVE                   0
+#define PV_ASCENDING_EAST           1
+#define PV_ASCENDING_NORTH          2
+#define PV_ASCENDING_SOUTH          3
+#define PV_ASCENDING_WEST           4
+#define PV_BASE                     5
+#define PV_BOTTOM                   6
+#define PV_CEILING                  7
+#define PV_COMPARE                  8
+#define PV_COOLDOWN                 9
+#define PV_CORNER                   10
+#define PV_DATA                     11
+#define PV_DOUBLE                   12
+#define PV_DOUBLE_WALL              13
+#define PV_DOWN                     14
+#define PV_EAST                     15
+#define PV_EAST_WEST                16
+#define PV_FALSE                    17
+#define PV_FLOOR                    18
+#define PV_FOOT                     19
+#define PV_FRUSTUM                  20
+#define PV_FULL                     21
+#define PV_HEAD                     22
+#define PV_INACTIVE                 23
+#define PV_INNER_LEFT               24
+#define PV_INNER_RIGHT              25
+#define PV_LEFT                     26
+#define PV_LOAD                     27
+#define PV_LOW                      28
+#define PV_LOWER                    29
+#define PV_MIDDLE                   30
+#define PV_NONE                     31
+#define PV_NORMAL                   32
+#define PV_NORTH                    33
+#define PV_NORTH_EAST               34
+#define PV_NORTH_SOUTH              35
+#define PV_NORTH_WEST               36
+#define PV_OUTER_LEFT               37
+#define PV_OUTER_RIGHT              38
+#define PV_PARTIAL                  39
+#define PV_RIGHT                    40
+#define PV_SAVE                     41
+#define PV_SIDE                     42
+#define PV_SINGLE                   43
+#define PV_SINGLE_WALL              44
+#define PV_SOUTH                    45
+#define PV_SOUTH_EAST               46
+#define PV_SOUTH_WEST               47
+#define PV_STICKY                   48
+#define PV_STRAIGHT                 49
+#define PV_SUBTRACT                 50
+#define PV_TALL                     51
+#define PV_TIP                      52
+#define PV_TIP_MERGE                53
+#define PV_TOP                      54
+#define PV_TRUE                     55
+#define PV_UNSTABLE                 56
+#define PV_UP                       57
+#define PV_UPPER                    58
+#define PV_WALL                     59
+#define PV_WEST                     60
+#define PV_X                        61
+#define PV_Y                        62
+#define PV_Z                        63
+
+static const char* const gPropertyValueNames[PROPERTY_VALUE_COUNT] = {
+    "active", "ascending_east", "ascending_north", "ascending_south", "ascending_west", "base", "bottom", "ceiling",
+    "compare", "cooldown", "corner", "data", "double", "double_wall", "down", "east",
+    "east_west", "false", "floor", "foot", "frustum", "full", "head", "inactive",
+    "inner_left", "inner_right", "left", "load", "low", "lower", "middle", "none",
+    "normal", "north", "north_east", "north_south", "north_west", "outer_left", "outer_right", "partial",
+    "right", "save", "side", "single", "single_wall", "south", "south_east", "south_west",
+    "sticky", "straight", "subtract", "tall", "tip", "tip_merge", "top", "true",
+    "unstable", "up", "upper", "wall", "west", "x", "y", "z",
+};
+#define PROPERTY_VALUE_BUCKETS 32
+static const unsigned short gPropertyValueSeeds[PROPERTY_VALUE_BUCKETS] = {
+    8, 1, 1, 1, 2, 3, 0, 1, 3, 1, 1, 0, 0, 9, 1, 1,
+    1, 1, 4, 3, 17, 1, 1, 0, 1, 2, 1, 1, 2, 1, 1, 0,
+};
+#define PROPERTY_VALUE_HASH_BITS 7
+static const short gPropertyValueSlots[1 << PROPERTY_VALUE_HASH_BITS] = {
+    27, -1, -1, 36, -1, -1, -1, -1, 43, 59, 32, 45, -1, 3, 12, 31,
+    16, -1, 13, -1, 33, -1, -1, 56, -1, -1, 48, -1, 52, 7, -1, -1,
+    -1, 25, 50, 38, -1, 10, -1, -1, -1, -1, -1, -1, -1, 5, 42, -1,
+    0, -1, -1, -1, 62, -1, 26, -1, 1, 63, 44, 40, 61, 17, 55, 57,
+    -1, 46, -1, 19, 11, 22, -1, -1, -1, 6, -1, -1, 29, 39, -1, 15,
+    18, -1, 35, -1, -1, 14, 23, 8, 54, -1, -1, -1, 53, -1, 41, 34,
+    -1, -1, 9, -1, -1, 60, 30, -1, -1, -1, 51, -1, 4, -1, -1, -1,
+    -1, 49, 37, 28, 2, -1, -1, -1, 20, 58, 24, -1, 21, 47, -1, -1,
+};
+
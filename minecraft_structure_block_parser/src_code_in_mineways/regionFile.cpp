@@ -0,0 +1,147 @@
+// regionFile.cpp - read chunks from a Java world's .mca region file, mapped into memory
+
+#include "stdafx.h"
+#include <string.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "mappedFile.h"
+#include "chunkCompression.h"
+#include "regionFile.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+struct ExternalChunks {
+    std::mutex lock;
+    MappedFile files[REGION_CHUNKS];
+    bool tried[REGION_CHUNKS];
+};
+
+static unsigned int readBigInt(const unsigned char* p)
+{
+    return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+bool parseRegionFilename(const wchar_t* filename, std::wstring& directory, int& regionX, int& regionZ)
+{
+    std::wstring path(filename);
+    size_t nameStart = path.find_last_of(L"/\\");
+    nameStart = (nameStart == std::wstring::npos) ? 0 : nameStart + 1;
+    directory = path.substr(0, nameStart);
+    return swscanf(path.c_str() + nameStart, L"r.%d.%d.mca", &regionX, &regionZ) == 2;
+}
+
+std::wstring getExternalChunkFilename(const std::wstring& directory, int chunkX, int chunkZ)
+{
+    wchar_t name[64];
+    swprintf(name, 64, L"c.%d.%d.mcc", chunkX, chunkZ);
+    return directory + name;
+}
+
+int openRegionFile(const wchar_t* filename, RegionFile& region)
+{
+    region.external = NULL;
+    int retCode = openMappedFile(filename, region.file);
+    if (retCode < 0) {
+        return retCode;
+    }
+    // both tables, though a region with no chunks may be an empty file
+    if (region.file.size != 0 && region.file.size < 2 * REGION_SECTOR_SIZE) {
+        closeMappedFile(region.file);
+        return LINE_ERROR;
+    }
+    region.external = new (std::nothrow) ExternalChunks;
+    if (region.external == NULL) {
+        closeMappedFile(region.file);
+        return LINE_ERROR;
+    }
+    memset(region.external->tried, 0, sizeof(region.external->tried));
+    region.named = parseRegionFilename(filename, region.directory, region.regionX, region.regionZ);
+    return 0;
+}
+
+void closeRegionFile(RegionFile& region)
+{
+    closeMappedFile(region.file);
+    if (region.external != NULL) {
+        for (int i = 0; i < REGION_CHUNKS; i++) {
+            if (region.external->tried[i]) {
+                closeMappedFile(region.external->files[i]);
+            }
+        }
+        delete region.external;
+        region.external = NULL;
+    }
+}
+
+// the mapped .mcc file for chunk i, mapping it the first time; NULL if it can't be read
+static const MappedFile* getExternalChunk(const RegionFile& region, int i)
+{
+    ExternalChunks* external = region.external;
+    if (!region.named || external == NULL) {
+        return NULL;
+    }
+    std::lock_guard<std::mutex> guard(external->lock);
+    if (!external->tried[i]) {
+        std::wstring name = getExternalChunkFilename(region.directory, region.regionX * 32 + i % 32, region.regionZ * 32 + i / 32);
+        // on failure the file is left closed, with no data
+        openMappedFile(name.c_str(), external->files[i]);
+        external->tried[i] = true;
+    }
+    return (external->files[i].data != NULL) ? &external->files[i] : NULL;
+}
+
+int getRegionChunk(const RegionFile& region, int chunkX, int chunkZ, RegionChunk& chunk)
+{
+    if (chunkX < 0 || chunkX >= 32 || chunkZ < 0 || chunkZ >= 32) {
+        return LINE_ERROR;
+    }
+    if (region.file.size < 2 * REGION_SECTOR_SIZE) {
+        return 1;
+    }
+    int i = chunkZ * 32 + chunkX;
+    unsigned int location = readBigInt(region.file.data + i * 4);
+    if (location == 0) {
+        return 1;
+    }
+    size_t sector = location >> 8;
+    size_t sectorCount = location & 0xff;
+    // the first two sectors are the tables
+    if (sector < 2 || sectorCount == 0 || (sector + sectorCount) * REGION_SECTOR_SIZE > region.file.size) {
+        return LINE_ERROR;
+    }
+    const unsigned char* p = region.file.data + sector * REGION_SECTOR_SIZE;
+    size_t length = readBigInt(p);
+    if (length < 1 || length + 4 > sectorCount * REGION_SECTOR_SIZE) {
+        return LINE_ERROR;
+    }
+    chunk.compressionType = p[4] & ~CHUNK_COMPRESSION_EXTERNAL;
+    chunk.external = (p[4] & CHUNK_COMPRESSION_EXTERNAL) != 0;
+    if (chunk.external) {
+        const MappedFile* mcc = getExternalChunk(region, i);
+        if (mcc == NULL) {
+            return LINE_ERROR;
+        }
+        chunk.data = mcc->data;
+        chunk.size = mcc->size;
+    }
+    else {
+        chunk.data = p + 5;
+        chunk.size = length - 1;
+    }
+    chunk.timestamp = readBigInt(region.file.data + REGION_SECTOR_SIZE + i * 4);
+    chunk.sector = (unsigned int)sector;
+    chunk.sectorCount = (int)sectorCount;
+    return 0;
+}
+
+int readRegionChunk(const RegionFile& region, int chunkX, int chunkZ, std::vector<unsigned char>& nbt)
+{
+    RegionChunk chunk;
+    int retCode = getRegionChunk(region, chunkX, chunkZ, chunk);
+    if (retCode != 0) {
+        return retCode;
+    }
+    return decompressChunk(chunk.compressionType, chunk.data, chunk.size, nbt);
+}
@@ -0,0 +1,58 @@
+// regionFile.h - read chunks from a Java world's .mca region file, mapped into memory
+
+#pragma once
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "mappedFile.h"
+
+// A region file holds 32 x 32 chunks. It starts with a 4 KiB location table, one big-endian int per chunk
+// giving its first 4 KiB sector (top three bytes) and how many sectors it takes (low byte), then a 4 KiB
+// table of when each chunk was last saved, in seconds. Chunk i is at x = i % 32, z = i / 32. A stored chunk
+// is a big-endian length, a compression type (chunkCompression.h), and length - 1 bytes of compressed NBT.
+// A chunk too big for its sectors (over 1 MiB) has CHUNK_COMPRESSION_EXTERNAL added to its type and no data;
+// its compressed NBT is the whole of c.X.Z.mcc next to the region file, X and Z being the chunk's world
+// coordinates. Such files are mapped the first time they're asked for and stay mapped until the region is
+// closed, so they're read in place like any other chunk, from any number of threads.
+
+#define REGION_SECTOR_SIZE  4096
+#define REGION_CHUNKS       1024
+
+typedef struct ExternalChunks ExternalChunks;
+
+typedef struct RegionFile {
+    MappedFile file;
+    std::wstring directory;     // with its trailing separator, for .mcc files
+    int regionX;                // from the r.X.Z.mca name
+    int regionZ;
+    bool named;                 // false if the name wasn't r.X.Z.mca, so .mcc files can't be found
+    ExternalChunks* external;   // .mcc files mapped so far
+} RegionFile;
+
+// a chunk as stored, pointing into the mapped file
+typedef struct RegionChunk {
+    int compressionType;            // CHUNK_COMPRESSION_*, without CHUNK_COMPRESSION_EXTERNAL
+    bool external;                  // data is in a .mcc file
+    const unsigned char* data;
+    size_t size;
+    unsigned int timestamp;
+    unsigned int sector;            // as in the location table
+    int sectorCount;
+} RegionChunk;
+
+// The directory (with its trailing separator) and region coordinates of a file named r.X.Z.mca; false
+// if it's not named that way.
+bool parseRegionFilename(const wchar_t* filename, std::wstring& directory, int& regionX, int& regionZ);
+// the c.X.Z.mcc file for the chunk at world chunk coordinates chunkX, chunkZ
+std::wstring getExternalChunkFilename(const std::wstring& directory, int chunkX, int chunkZ);
+
+// Returns 0 on success, negative on error.
+int openRegionFile(const wchar_t* filename, RegionFile& region);
+void closeRegionFile(RegionFile& region);
+
+// Chunk x and z within the region, 0-31. Returns 0 on success, 1 if the chunk has not been saved,
+// negative if its location or length is damaged, or it's in a .mcc file that can't be read.
+int getRegionChunk(const RegionFile& region, int chunkX, int chunkZ, RegionChunk& chunk);
+// The chunk's NBT, decompressed. Returns 0 on success, 1 if the chunk has not been saved, negative on error.
+int readRegionChunk(const RegionFile& region, int chunkX, int chunkZ, std::vector<unsigned char>& nbt);
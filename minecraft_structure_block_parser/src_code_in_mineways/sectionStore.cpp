@@ -0,0 +1,330 @@
+// sectionStore.cpp - a big export box's blocks kept as Minecraft keeps them, a palette and packed indices per section, decoded as they're read
+
+#include "stdafx.h"
+#include <string.h>
+#include <vector>
+#include "nbtView.h"
+#include "modRegistry.h"
+#include "chunkSections.h"
+#include "javaStructure.h"
+#include "sectionStore.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// open addressing for finding a section's palette, twice the most entries it can have
+#define PALETTE_HASH_SIZE   (2 * SECTION_BLOCKS)
+
+int initSectionStore(SectionStore& store, int minX, int minZ, int maxX, int maxZ)
+{
+    store.sections = NULL;
+    if (maxX < minX || maxZ < minZ) {
+        return LINE_ERROR;
+    }
+    store.minChunkX = minX >> 4;
+    store.minChunkZ = minZ >> 4;
+    store.chunksX = (maxX >> 4) - store.minChunkX + 1;
+    store.chunksZ = (maxZ >> 4) - store.minChunkZ + 1;
+    size_t count = (size_t)store.chunksX * store.chunksZ * SECTION_STORE_LAYERS;
+    store.sections = new (std::nothrow) PackedSection[count];
+    if (store.sections == NULL) {
+        return LINE_ERROR;
+    }
+    memset(store.sections, 0, count * sizeof(PackedSection));
+    return 0;
+}
+
+static void clearPackedSection(PackedSection& section)
+{
+    delete[] section.words;
+    memset(&section, 0, sizeof(section));
+}
+
+void freeSectionStore(SectionStore& store)
+{
+    if (store.sections != NULL) {
+        size_t count = (size_t)store.chunksX * store.chunksZ * SECTION_STORE_LAYERS;
+        for (size_t i = 0; i < count; i++) {
+            delete[] store.sections[i].words;
+        }
+        delete[] store.sections;
+        store.sections = NULL;
+    }
+}
+
+static PackedSection* findStoreSection(SectionStore& store, int chunkX, int chunkZ, int sectionY)
+{
+    int cx = chunkX - store.minChunkX;
+    int cz = chunkZ - store.minChunkZ;
+    int layer = sectionY - ABSOLUTE_MIN_MAP_HEIGHT / 16;
+    if (store.sections == NULL || cx < 0 || cx >= store.chunksX || cz < 0 || cz >= store.chunksZ || layer < 0 || layer >= SECTION_STORE_LAYERS) {
+        return NULL;
+    }
+    return &store.sections[((size_t)cz * store.chunksX + cx) * SECTION_STORE_LAYERS + layer];
+}
+
+// Packs indices, each below paletteCount, with a palette already free of repeats. Returns 0, or negative
+// if out of memory, in which case the section is left as air.
+static int packSection(PackedSection& section, const unsigned int* palette, int paletteCount, const unsigned short* indices)
+{
+    clearPackedSection(section);
+    // nothing at all for a section of air
+    if (paletteCount == 1 && palette[0] == 0) {
+        return 0;
+    }
+    int bits = 0;
+    int indexShift = 0;
+    if (paletteCount > 1) {
+        bits = (paletteCount <= 2) ? 1 : (paletteCount <= 4) ? 2 : (paletteCount <= 16) ? 4 : (paletteCount <= 256) ? 8 : 16;
+        for (indexShift = 0; (bits << indexShift) < 64; indexShift++) {
+        }
+    }
+    size_t indexWords = (bits == 0) ? 0 : SECTION_BLOCKS >> indexShift;
+    unsigned long long* words = new (std::nothrow) unsigned long long[paletteCount + indexWords];
+    if (words == NULL) {
+        return LINE_ERROR;
+    }
+    for (int p = 0; p < paletteCount; p++) {
+        words[p] = palette[p];
+    }
+    int perLong = 1 << indexShift;
+    for (size_t w = 0; w < indexWords; w++) {
+        const unsigned short* in = indices + w * perLong;
+        unsigned long long word = 0;
+        for (int k = perLong - 1; k >= 0; k--) {
+            word = (word << bits) | in[k];
+        }
+        words[paletteCount + w] = word;
+    }
+    section.words = words;
+    section.paletteCount = (unsigned short)paletteCount;
+    section.bits = (unsigned char)bits;
+    section.indexShift = (unsigned char)indexShift;
+    return 0;
+}
+
+// the palette index for a block, adding it to the palette if new
+static unsigned short findPaletteIndex(unsigned int block, unsigned int* hashKeys, unsigned short* hashIndices, unsigned int* palette, int& paletteCount)
+{
+    unsigned int slot = (block * 2654435761u) >> 19;
+    // keys are stored plus one, so 0 is an empty slot
+    while (hashKeys[slot] != 0) {
+        if (hashKeys[slot] == block + 1) {
+            return hashIndices[slot];
+        }
+        slot = (slot + 1) & (PALETTE_HASH_SIZE - 1);
+    }
+    hashKeys[slot] = block + 1;
+    hashIndices[slot] = (unsigned short)paletteCount;
+    palette[paletteCount] = block;
+    return (unsigned short)paletteCount++;
+}
+
+int setStoreSection(SectionStore& store, int chunkX, int chunkZ, int sectionY, const unsigned short* types, const unsigned char* dataVals)
+{
+    PackedSection* section = findStoreSection(store, chunkX, chunkZ, sectionY);
+    if (section == NULL) {
+        return 1;
+    }
+    std::vector<unsigned int> hashKeys(PALETTE_HASH_SIZE, 0);
+    std::vector<unsigned short> hashIndices(PALETTE_HASH_SIZE);
+    unsigned int palette[SECTION_BLOCKS];
+    unsigned short indices[SECTION_BLOCKS];
+    int paletteCount = 0;
+    // runs of the same block are the usual case
+    unsigned int last = 0xffffffff;
+    unsigned short lastIndex = 0;
+    for (int i = 0; i < SECTION_BLOCKS; i++) {
+        unsigned int block = ((unsigned int)types[i] << 8) | dataVals[i];
+        if (block != last) {
+            last = block;
+            lastIndex = findPaletteIndex(block, hashKeys.data(), hashIndices.data(), palette, paletteCount);
+        }
+        indices[i] = lastIndex;
+    }
+    return packSection(*section, palette, paletteCount, indices);
+}
+
+// Translates and packs the sections of a chunk into its column, which must start as air.
+static int decodeSections(const NbtView& view, NbtIterator& it, PackedSection* column)
+{
+    unsigned short remap[SECTION_BLOCKS];
+    unsigned int palette[SECTION_BLOCKS];
+    unsigned short indices[SECTION_BLOCKS];
+    ModRegistryPin pin;
+    pinModRegistry(pin);
+    int retCode = 0;
+    ChunkSection section;
+    while (retCode >= 0 && nextChunkSection(view, it, section)) {
+        int layer = section.sectionY - ABSOLUTE_MIN_MAP_HEIGHT / 16;
+        if (layer < 0 || layer >= SECTION_STORE_LAYERS) {
+            continue;
+        }
+        // Java states that translate alike, such as stairs of different shapes, become one entry
+        int paletteCount = 0;
+        NbtIterator paletteIt;
+        NbtTag entry;
+        nbtIterate(view, section.palette, paletteIt);
+        int p = 0;
+        for (; p < section.paletteCount && nbtNext(view, paletteIt, entry); p++) {
+            unsigned short type;
+            unsigned char dataVal;
+            // untranslatable names come back as air
+            translateJavaPaletteEntry(view, entry, pin, type, dataVal);
+            unsigned int block = ((unsigned int)type << 8) | dataVal;
+            int q = 0;
+            while (q < paletteCount && palette[q] != block) {
+                q++;
+            }
+            if (q == paletteCount) {
+                palette[paletteCount++] = block;
+            }
+            remap[p] = (unsigned short)q;
+        }
+        // damaged entries, and indices past the palette, are air
+        int airIndex = -1;
+        for (; p < (1 << section.bits) || p < section.paletteCount; p++) {
+            if (airIndex < 0) {
+                int q = 0;
+                while (q < paletteCount && palette[q] != 0) {
+                    q++;
+                }
+                if (q == paletteCount) {
+                    palette[paletteCount++] = 0;
+                }
+                airIndex = q;
+            }
+            remap[p] = (unsigned short)airIndex;
+        }
+        unpackSectionIndices(section, indices);
+        for (int i = 0; i < SECTION_BLOCKS; i++) {
+            indices[i] = remap[indices[i]];
+        }
+        retCode = packSection(column[layer], palette, paletteCount, indices);
+    }
+    unpinModRegistry(pin);
+    return retCode;
+}
+
+int putChunkInStore(SectionStore& store, const unsigned char* nbt, size_t size)
+{
+    NbtView view = { nbt, size, false };
+    NbtTag sections;
+    NbtIterator it;
+    int chunkX, chunkZ;
+    if (!getChunkSections(view, chunkX, chunkZ, sections) || !nbtIterate(view, sections, it)) {
+        return LINE_ERROR;
+    }
+    PackedSection* column = findStoreSection(store, chunkX, chunkZ, ABSOLUTE_MIN_MAP_HEIGHT / 16);
+    if (column == NULL) {
+        return 1;
+    }
+    // sections the chunk doesn't have are air
+    freeChunkColumn(column);
+    int retCode = decodeSections(view, it, column);
+    return (retCode < 0) ? retCode : 0;
+}
+
+int decodeChunkColumn(const unsigned char* nbt, size_t size, int& chunkX, int& chunkZ, PackedSection* column)
+{
+    memset(column, 0, SECTION_STORE_LAYERS * sizeof(PackedSection));
+    NbtView view = { nbt, size, false };
+    NbtTag sections;
+    NbtIterator it;
+    if (!getChunkSections(view, chunkX, chunkZ, sections) || !nbtIterate(view, sections, it)) {
+        return LINE_ERROR;
+    }
+    int retCode = decodeSections(view, it, column);
+    if (retCode < 0) {
+        freeChunkColumn(column);
+        return retCode;
+    }
+    return 0;
+}
+
+void freeChunkColumn(PackedSection* column)
+{
+    for (int layer = 0; layer < SECTION_STORE_LAYERS; layer++) {
+        clearPackedSection(column[layer]);
+    }
+}
+
+void decodePackedSectionRow(const PackedSection* section, int x, int y, int z, int count, unsigned short* types, unsigned char* dataVals)
+{
+    if (section == NULL || section->words == NULL || section->bits == 0) {
+        unsigned int block = (section != NULL && section->words != NULL) ? (unsigned int)section->words[0] : 0;
+        for (int k = 0; k < count; k++) {
+            types[k] = (unsigned short)(block >> 8);
+            dataVals[k] = (unsigned char)block;
+        }
+        return;
+    }
+    const unsigned long long* palette = section->words;
+    const unsigned long long* indexWords = section->words + section->paletteCount;
+    const int bits = section->bits;
+    const unsigned int mask = (1u << bits) - 1;
+    const unsigned int perLongMask = (1u << section->indexShift) - 1;
+    unsigned int i = (unsigned int)((y << 8) | (z << 4) | x);
+    for (int k = 0; k < count; k++, i++) {
+        unsigned int index = (unsigned int)(indexWords[i >> section->indexShift] >> ((i & perLongMask) * bits)) & mask;
+        unsigned int block = (unsigned int)palette[index];
+        types[k] = (unsigned short)(block >> 8);
+        dataVals[k] = (unsigned char)block;
+    }
+}
+
+void decodeStoreRow(const SectionStore& store, int x, int y, int z, int count, unsigned short* types, unsigned char* dataVals)
+{
+    while (count > 0) {
+        // one section's part of the row at a time
+        int start = x & 15;
+        int n = (16 - start < count) ? 16 - start : count;
+        decodePackedSectionRow(getStoreSection(store, x, y, z), start, (y - ABSOLUTE_MIN_MAP_HEIGHT) & 15, z & 15, n, types, dataVals);
+        x += n;
+        types += n;
+        dataVals += n;
+        count -= n;
+    }
+}
+
+int readSectionStoreBox(const SectionStore& store, int minX, int minY, int minZ, int sizeX, int sizeY, int sizeZ, BlockLayout& layout)
+{
+    if (sizeX <= 0 || sizeY <= 0 || sizeZ <= 0) {
+        return LINE_ERROR;
+    }
+    layout.sizeX = sizeX;
+    layout.sizeY = sizeY;
+    layout.sizeZ = sizeZ;
+    size_t count = (size_t)sizeX * sizeY * sizeZ;
+    layout.type.resize(count);
+    layout.dataVal.resize(count);
+    for (int y = 0; y < sizeY; y++) {
+        for (int z = 0; z < sizeZ; z++) {
+            size_t row = getBlockLayoutIndex(layout, 0, y, z);
+            decodeStoreRow(store, minX, minY + y, minZ + z, sizeX, &layout.type[row], &layout.dataVal[row]);
+        }
+    }
+    return 0;
+}
+
+size_t getPackedSectionBytes(const PackedSection& section)
+{
+    if (section.words == NULL) {
+        return 0;
+    }
+    size_t indexWords = (section.bits == 0) ? 0 : SECTION_BLOCKS >> section.indexShift;
+    return (section.paletteCount + indexWords) * sizeof(unsigned long long);
+}
+
+size_t getSectionStoreBytes(const SectionStore& store)
+{
+    if (store.sections == NULL) {
+        return 0;
+    }
+    size_t count = (size_t)store.chunksX * store.chunksZ * SECTION_STORE_LAYERS;
+    size_t bytes = sizeof(store) + count * sizeof(PackedSection);
+    for (size_t i = 0; i < count; i++) {
+        bytes += getPackedSectionBytes(store.sections[i]);
+    }
+    return bytes;
+}
@@ -0,0 +1,105 @@
+// sectionStore.h - a big export box's blocks kept as Minecraft keeps them, a palette and packed indices per section, decoded as they're read
+
+#pragma once
+
+#include <stddef.h>
+#include "blockLayout.h"
+
+// A dense box of types and data values takes 3 bytes a block, which for the full height of a big export
+// is more memory than most machines have. Here each 16 x 16 x 16 section keeps only its palette, of
+// Mineways types and data values rather than Java states, and an index per block into it, using as few
+// bits as fit the palette. Unlike Minecraft, the bits are always 1, 2, 4, 8 or 16, so an index is found
+// with shifts alone and a 16-block row is one or a few whole longs; a typical section of under 16 blocks
+// takes 2 KiB instead of 12. Sections that are all air take no memory beyond their entry.
+
+// sections in a column, ABSOLUTE_MIN_MAP_HEIGHT up through ABSOLUTE_MAX_MAP_HEIGHT
+#define SECTION_STORE_LAYERS    ((ABSOLUTE_MAX_MAP_HEIGHT - ABSOLUTE_MIN_MAP_HEIGHT + 1) / 16)
+
+typedef struct PackedSection {
+    // paletteCount entries of (type << 8) | dataVal, then the indices, 64 / bits to a long, the first in
+    // the lowest bits, in sectionBlockIndex() order; NULL for a section of air
+    unsigned long long* words;
+    unsigned short paletteCount;
+    unsigned char bits;             // 0 if the palette has one entry, and there are no indices
+    unsigned char indexShift;       // log2(64 / bits), to find an index's long
+} PackedSection;
+
+typedef struct SectionStore {
+    int minChunkX;
+    int minChunkZ;
+    int chunksX;
+    int chunksZ;
+    // SECTION_STORE_LAYERS for each chunk column, lowest first; columns x fastest, then z
+    PackedSection* sections;
+} SectionStore;
+
+// A store of air covering the blocks minX through maxX and minZ through maxZ, in whole chunks, at every
+// height. Returns 0 on success, negative on error.
+int initSectionStore(SectionStore& store, int minX, int minZ, int maxX, int maxZ);
+void freeSectionStore(SectionStore& store);
+
+// Replaces a section with 4096 blocks in sectionBlockIndex() order (chunkSections.h), as chunk coordinates
+// and sectionY, the section's bottom y / 16. Returns 0 on success, 1 if it's outside the store, negative
+// if out of memory.
+int setStoreSection(SectionStore& store, int chunkX, int chunkZ, int sectionY, const unsigned short* types, const unsigned char* dataVals);
+// Replaces the sections of a chunk, from its NBT, translating each palette entry with
+// translateJavaPaletteEntry() (javaStructure.h), without ever filling a dense grid. Returns 0 on success,
+// 1 if the chunk is outside the store, negative if it can't be read or memory runs out.
+int putChunkInStore(SectionStore& store, const unsigned char* nbt, size_t size);
+
+// Decodes a chunk's NBT, as putChunkInStore() does, into a column of SECTION_STORE_LAYERS sections, lowest
+// first, for keeping apart from any store. Sections the chunk doesn't have are air. Returns 0 on success,
+// negative on error, in which case the column is all air. Free it with freeChunkColumn().
+int decodeChunkColumn(const unsigned char* nbt, size_t size, int& chunkX, int& chunkZ, PackedSection* column);
+void freeChunkColumn(PackedSection* column);
+
+// count blocks along x from x, y, z within a section, x + count at most 16, decoded into types and
+// dataVals; a NULL section is air
+void decodePackedSectionRow(const PackedSection* section, int x, int y, int z, int count, unsigned short* types, unsigned char* dataVals);
+// count blocks along x from x, y, z, decoded into types and dataVals; blocks outside the store are air
+void decodeStoreRow(const SectionStore& store, int x, int y, int z, int count, unsigned short* types, unsigned char* dataVals);
+// The box with corner minX, minY, minZ into a layout of sizeX x sizeY x sizeZ, a row at a time. Returns 0
+// on success, negative on error.
+int readSectionStoreBox(const SectionStore& store, int minX, int minY, int minZ, int sizeX, int sizeY, int sizeZ, BlockLayout& layout);
+
+// all the memory the store uses
+size_t getSectionStoreBytes(const SectionStore& store);
+// the memory a section's palette and indices use
+size_t getPackedSectionBytes(const PackedSection& section);
+
+// the section holding world block x, y, z, or NULL if it's outside the store
+inline const PackedSection* getStoreSection(const SectionStore& store, int x, int y, int z)
+{
+    int cx = (x >> 4) - store.minChunkX;
+    int cz = (z >> 4) - store.minChunkZ;
+    int layer = (y - ABSOLUTE_MIN_MAP_HEIGHT) >> 4;
+    if (cx < 0 || cx >= store.chunksX || cz < 0 || cz >= store.chunksZ || y < ABSOLUTE_MIN_MAP_HEIGHT || layer >= SECTION_STORE_LAYERS) {
+        return NULL;
+    }
+    return &store.sections[((size_t)cz * store.chunksX + cx) * SECTION_STORE_LAYERS + layer];
+}
+
+// (type << 8) | dataVal for one block of a section, at x, y, z within it
+inline unsigned int getPackedSectionBlock(const PackedSection& section, int x, int y, int z)
+{
+    if (section.words == NULL) {
+        return 0;
+    }
+    if (section.bits == 0) {
+        return (unsigned int)section.words[0];
+    }
+    unsigned int i = (unsigned int)((y << 8) | (z << 4) | x);
+    unsigned int perLongMask = (1u << section.indexShift) - 1;
+    unsigned long long word = section.words[section.paletteCount + (i >> section.indexShift)];
+    unsigned int index = (unsigned int)(word >> ((i & perLongMask) * section.bits)) & ((1u << section.bits) - 1);
+    return (unsigned int)section.words[index];
+}
+
+// One block, at world coordinates; air outside the store.
+inline void getStoreBlock(const SectionStore& store, int x, int y, int z, unsigned short& type, unsigned char& dataVal)
+{
+    const PackedSection* section = getStoreSection(store, x, y, z);
+    unsigned int block = (section != NULL) ? getPackedSectionBlock(*section, x & 15, (y - ABSOLUTE_MIN_MAP_HEIGHT) & 15, z & 15) : 0;
+    type = (unsigned short)(block >> 8);
+    dataVal = (unsigned char)block;
+}
@@ -0,0 +1,140 @@
+// tileColors.cpp - average and dominant colors of the tiles in the loaded resource pack, to replace the built-in read_color values
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "tileKernels.h"
+#include "tileColors.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// 4 bits per channel
+#define DOMINANT_BUCKETS    4096
+
+// a color whose channels are all within this of each other is taken as gray
+#define GRAY_SPREAD         12
+
+static void computeOneTileColor(const unsigned char* rgba, int width, int tileSize, int col, int row, unsigned int* bucketWeight, TileColor& tc)
+{
+    unsigned long long sums[4] = { 0, 0, 0, 0 };
+    for (int y = 0; y < tileSize; y++) {
+        sumAlphaWeightedRGBA(&rgba[(((size_t)row * tileSize + y) * width + (size_t)col * tileSize) * 4], tileSize, sums);
+    }
+    tc.present = (sums[3] > 0);
+    tc.alpha = (float)((double)sums[3] / (255.0 * tileSize * tileSize));
+    if (!tc.present) {
+        tc.average = tc.dominant = 0x000000;
+        return;
+    }
+    tc.average = 0;
+    for (int c = 0; c < 3; c++) {
+        tc.average = (tc.average << 8) | (unsigned int)((sums[c] + sums[3] / 2) / sums[3]);
+    }
+
+    // most common bucket, by alpha, then the mean of just the pixels in it
+    memset(bucketWeight, 0, DOMINANT_BUCKETS * sizeof(unsigned int));
+    int best = 0;
+    for (int y = 0; y < tileSize; y++) {
+        const unsigned char* px = &rgba[(((size_t)row * tileSize + y) * width + (size_t)col * tileSize) * 4];
+        for (int x = 0; x < tileSize; x++, px += 4) {
+            int bucket = ((px[0] >> 4) << 8) | ((px[1] >> 4) << 4) | (px[2] >> 4);
+            bucketWeight[bucket] += px[3];
+            if (bucketWeight[bucket] > bucketWeight[best]) {
+                best = bucket;
+            }
+        }
+    }
+    unsigned long long bucketSums[3] = { 0, 0, 0 };
+    for (int y = 0; y < tileSize; y++) {
+        const unsigned char* px = &rgba[(((size_t)row * tileSize + y) * width + (size_t)col * tileSize) * 4];
+        for (int x = 0; x < tileSize; x++, px += 4) {
+            if ((((px[0] >> 4) << 8) | ((px[1] >> 4) << 4) | (px[2] >> 4)) == best) {
+                for (int c = 0; c < 3; c++) {
+                    bucketSums[c] += (unsigned long long)px[c] * px[3];
+                }
+            }
+        }
+    }
+    unsigned int weight = bucketWeight[best];
+    tc.dominant = 0;
+    for (int c = 0; c < 3; c++) {
+        tc.dominant = (tc.dominant << 8) | (unsigned int)((bucketSums[c] + weight / 2) / weight);
+    }
+}
+
+int computeTileColors(const unsigned char* rgba, int width, int height, int tileSize, int threadCount, TileColor* colors)
+{
+    if (tileSize <= 0 || (width % tileSize) != 0 || (height % tileSize) != 0) {
+        return LINE_ERROR;
+    }
+    int tilesPerRow = width / tileSize;
+    int tileCount = tilesPerRow * (height / tileSize);
+
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+    // each tile is independent, so threads just take the next tile
+    std::atomic<int> nextTile(0);
+    auto worker = [&]() {
+        std::vector<unsigned int> bucketWeight(DOMINANT_BUCKETS);
+        int tile;
+        while ((tile = nextTile++) < tileCount) {
+            computeOneTileColor(rgba, width, tileSize, tile % tilesPerRow, tile / tilesPerRow, bucketWeight.data(), colors[tile]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount && t < tileCount; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    return tileCount;
+}
+
+static bool isGray(unsigned int rgb)
+{
+    int r = (rgb >> 16) & 0xff;
+    int g = (rgb >> 8) & 0xff;
+    int b = rgb & 0xff;
+    int hi = (r > g) ? ((r > b) ? r : b) : ((g > b) ? g : b);
+    int lo = (r < g) ? ((r < b) ? r : b) : ((g < b) ? g : b);
+    return (hi - lo) <= GRAY_SPREAD;
+}
+
+int setBlockColorsFromTiles(BlockDefinition* defs, const TileColor* colors, int tileCount, bool useDominant)
+{
+    int changed = 0;
+    for (int type = 0; type < NUM_BLOCKS_DEFINED; type++) {
+        BlockDefinition& def = defs[type];
+        if (def.flags & BLF_NONE) {
+            continue;
+        }
+        int slot = def.txrY * 16 + def.txrX;
+        if (slot < 0 || slot >= tileCount || !colors[slot].present) {
+            continue;
+        }
+        unsigned int newColor = useDominant ? colors[slot].dominant : colors[slot].average;
+        if (isGray(newColor) && !isGray(def.read_color)) {
+            continue;
+        }
+        def.read_color = newColor;
+        if (def.flags & BLF_TRANSPARENT) {
+            def.read_alpha = colors[slot].alpha;
+        }
+        def.color = def.read_color;
+        def.alpha = def.read_alpha;
+        unsigned int r = (unsigned int)(((def.color >> 16) & 0xff) * def.alpha + 0.5f);
+        unsigned int g = (unsigned int)(((def.color >> 8) & 0xff) * def.alpha + 0.5f);
+        unsigned int b = (unsigned int)((def.color & 0xff) * def.alpha + 0.5f);
+        def.pcolor = (r << 16) | (g << 8) | b;
+        changed++;
+    }
+    return changed;
+}
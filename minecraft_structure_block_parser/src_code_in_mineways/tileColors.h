@@ -0,0 +1,23 @@
+// tileColors.h - average and dominant colors of the tiles in the loaded resource pack, to replace the built-in read_color values
+
+#pragma once
+
+typedef struct TileColor {
+    unsigned int average;   // 0xRRGGBB, weighted by alpha, so only what shows counts
+    unsigned int dominant;  // 0xRRGGBB, mean of the most common color (12-bit buckets, weighted by alpha)
+    float alpha;            // mean alpha, 0.0 to 1.0
+    bool present;           // false if the tile is fully transparent, i.e. the pack has nothing there
+} TileColor;
+
+// Compute colors for every tile of an RGBA atlas laid out like terrainExt.png, indexed row*(width/tileSize)+column,
+// so txrY*16+txrX for the usual 16-wide atlas. colors needs room for all the tiles. Tiles are spread over
+// threadCount threads, 0 meaning all cores, and sums use the SIMD kernels of tileKernels.h.
+// Returns the number of tiles, or negative on error.
+int computeTileColors(const unsigned char* rgba, int width, int height, int tileSize, int threadCount, TileColor* colors);
+
+// Set read_color, and read_alpha for BLF_TRANSPARENT blocks, from each block's top tile (txrX, txrY), then color,
+// alpha and pcolor from those, the same as at startup; apply any color scheme after this. Blocks that are BLF_NONE
+// or whose tile is missing are left alone, as are blocks given a color (e.g. grass, leaves, water) whose tile is
+// gray: packs store biome-tinted tiles gray, so the tile's hue tells nothing. useDominant picks the dominant
+// color over the average, which suits flowers and other cutouts better. Returns the number of blocks changed.
+int setBlockColorsFromTiles(BlockDefinition* defs, const TileColor* colors, int tileCount, bool useDominant);
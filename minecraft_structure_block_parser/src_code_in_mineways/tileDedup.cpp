@@ -0,0 +1,141 @@
+// tileDedup.cpp - find byte-identical tiles, so that separate-tile export writes each distinct image only once
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "tiles.h"
+#include "tileDedup.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// 64-bit FNV-1a over the tile's rows; rows are not contiguous in the atlas
+static unsigned long long hashTile(const unsigned char* rgba, int width, int tileSize, int col, int row)
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (int y = 0; y < tileSize; y++) {
+        const unsigned char* px = &rgba[(((size_t)row * tileSize + y) * width + (size_t)col * tileSize) * 4];
+        for (int i = 0; i < tileSize * 4; i++) {
+            hash = (hash ^ px[i]) * 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+static bool tilesEqual(const unsigned char* rgba, int width, int tileSize, int tilesPerRow, int tileA, int tileB)
+{
+    for (int y = 0; y < tileSize; y++) {
+        const unsigned char* a = &rgba[(((size_t)(tileA / tilesPerRow) * tileSize + y) * width + (size_t)(tileA % tilesPerRow) * tileSize) * 4];
+        const unsigned char* b = &rgba[(((size_t)(tileB / tilesPerRow) * tileSize + y) * width + (size_t)(tileB % tilesPerRow) * tileSize) * 4];
+        if (memcmp(a, b, (size_t)tileSize * 4) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int dedupAtlasTiles(const unsigned char* rgba, int width, int height, int tileSize, const bool* used, int threadCount, TileDedupTable& table)
+{
+    table.tileCount = 0;
+    table.uniqueCount = 0;
+    table.canonical = NULL;
+    if (tileSize <= 0 || (width % tileSize) != 0 || (height % tileSize) != 0) {
+        return LINE_ERROR;
+    }
+    int tilesPerRow = width / tileSize;
+    int tileCount = tilesPerRow * (height / tileSize);
+    table.canonical = (int*)malloc(tileCount * sizeof(int));
+    if (table.canonical == NULL) {
+        return LINE_ERROR;
+    }
+    table.tileCount = tileCount;
+
+    // hashing is the expensive part, so do it in parallel
+    std::vector<unsigned long long> hashes(tileCount);
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+    std::atomic<int> nextTile(0);
+    auto worker = [&]() {
+        int tile;
+        while ((tile = nextTile++) < tileCount) {
+            if (used == NULL || used[tile]) {
+                hashes[tile] = hashTile(rgba, width, tileSize, tile % tilesPerRow, tile / tilesPerRow);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount && t < tileCount; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    // Group in slot order, so the first slot with a given image is the one written. Each hash
+    // keeps a list of the distinct images having it, which in practice is always just one.
+    std::unordered_map<unsigned long long, std::vector<int>> firstWithHash;
+    firstWithHash.reserve(tileCount);
+    for (int tile = 0; tile < tileCount; tile++) {
+        if (used != NULL && !used[tile]) {
+            table.canonical[tile] = -1;
+            continue;
+        }
+        std::vector<int>& candidates = firstWithHash[hashes[tile]];
+        table.canonical[tile] = tile;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (tilesEqual(rgba, width, tileSize, tilesPerRow, candidates[i], tile)) {
+                table.canonical[tile] = candidates[i];
+                break;
+            }
+        }
+        if (table.canonical[tile] == tile) {
+            candidates.push_back(tile);
+            table.uniqueCount++;
+        }
+    }
+    return 0;
+}
+
+void freeTileDedupTable(TileDedupTable& table)
+{
+    free(table.canonical);
+    table.canonical = NULL;
+    table.tileCount = 0;
+    table.uniqueCount = 0;
+}
+
+// slot (txrY*16+txrX) to gTilesTable index
+static int gSlotToTable[TOTAL_TILES];
+
+static bool makeSlotToTable()
+{
+    for (int i = 0; i < TOTAL_TILES; i++) {
+        gSlotToTable[i] = -1;
+    }
+    for (int i = 0; i < TOTAL_TILES; i++) {
+        int s = gTilesTable[i].txrY * 16 + gTilesTable[i].txrX;
+        if (gSlotToTable[s] < 0) {
+            gSlotToTable[s] = i;
+        }
+    }
+    return true;
+}
+
+int getDedupTilesTableIndex(const TileDedupTable& table, int slot)
+{
+    // made once, however many threads ask at the same time
+    static const bool made = makeSlotToTable();
+    (void)made;
+
+    if (slot < 0 || slot >= table.tileCount || slot >= TOTAL_TILES || table.canonical[slot] < 0) {
+        return -1;
+    }
+    return gSlotToTable[table.canonical[slot]];
+}
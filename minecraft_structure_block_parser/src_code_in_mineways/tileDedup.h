@@ -0,0 +1,22 @@
+// tileDedup.h - find byte-identical tiles, so that separate-tile export writes each distinct image only once
+
+#pragma once
+
+typedef struct TileDedupTable {
+    int tileCount;      // tile slots covered, normally TOTAL_TILES
+    int uniqueCount;    // number of distinct images among the used tiles
+    int* canonical;     // for each slot, the slot whose image (and file) it should use; itself if first of its kind, -1 if not used
+} TileDedupTable;
+
+// Hash each used tile of an RGBA atlas (tileSize x tileSize tiles, laid out like terrainExt.png, tiles indexed
+// row*(width/tileSize)+column) and group byte-identical ones. used[] says which tiles will be exported; pass NULL
+// for all. Identical hashes are confirmed with a full compare, so a hash collision can never merge two tiles.
+// Hashing is spread over threadCount threads, 0 meaning all cores. Returns 0 on success, negative on error.
+int dedupAtlasTiles(const unsigned char* rgba, int width, int height, int tileSize, const bool* used, int threadCount, TileDedupTable& table);
+
+// release the table's memory
+void freeTileDedupTable(TileDedupTable& table);
+
+// The gTilesTable entry whose file name should be used for a given tile slot (txrY*16+txrX), so that materials
+// for a duplicate tile point to the one file written. Returns -1 if the slot is unused.
+int getDedupTilesTableIndex(const TileDedupTable& table, int slot);
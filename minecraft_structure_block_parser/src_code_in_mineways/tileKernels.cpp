@@ -0,0 +1,491 @@
+// tileKernels.cpp - overlay compositing and tinting, with AVX2, SSE4.1 and plain C paths
+
+#include "stdafx.h"
+#include <chrono>
+#include <vector>
+#include "tileKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TILE_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC lets any intrinsic be used anywhere, so no per-function target is needed
+#define TARGET_SSE4
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_SSE4 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// -1 means "not yet determined"
+static int gKernelLevel = -1;
+static int gKernelMaxLevel = -1;
+
+// exact (x+127)/255 rounding for x in [0, 255*255]
+static inline int div255(int x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static int detectKernelLevel()
+{
+#ifdef TILE_KERNELS_X86
+    unsigned int info[4] = { 0, 0, 0, 0 };
+    int level = TILE_KERNEL_SCALAR;
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    int maxLeaf = regs[0];
+    __cpuid(regs, 1);
+    for (int i = 0; i < 4; i++) info[i] = (unsigned int)regs[i];
+#else
+    int maxLeaf = (int)__get_cpuid_max(0, NULL);
+    __get_cpuid(1, &info[0], &info[1], &info[2], &info[3]);
+#endif
+    // ecx bit 19 is SSE4.1
+    if (info[2] & (1 << 19)) {
+        level = TILE_KERNEL_SSE4;
+    }
+    // AVX2 also needs the OS to save the YMM registers: ecx bit 27 is OSXSAVE, then check XCR0
+    if (level == TILE_KERNEL_SSE4 && maxLeaf >= 7 && (info[2] & (1 << 27))) {
+        unsigned long long xcr0;
+#ifdef _MSC_VER
+        xcr0 = _xgetbv(0);
+        __cpuidex(regs, 7, 0);
+        for (int i = 0; i < 4; i++) info[i] = (unsigned int)regs[i];
+#else
+        unsigned int lo, hi;
+        __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        xcr0 = ((unsigned long long)hi << 32) | lo;
+        __cpuid_count(7, 0, info[0], info[1], info[2], info[3]);
+#endif
+        // ebx bit 5 is AVX2
+        if ((xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5))) {
+            level = TILE_KERNEL_AVX2;
+        }
+    }
+    return level;
+#else
+    return TILE_KERNEL_SCALAR;
+#endif
+}
+
+int getTileKernelLevel()
+{
+    if (gKernelLevel < 0) {
+        gKernelMaxLevel = detectKernelLevel();
+        gKernelLevel = gKernelMaxLevel;
+    }
+    return gKernelLevel;
+}
+
+int setTileKernelLevel(int level)
+{
+    getTileKernelLevel();
+    if (level < TILE_KERNEL_SCALAR) {
+        level = TILE_KERNEL_SCALAR;
+    }
+    gKernelLevel = (level > gKernelMaxLevel) ? gKernelMaxLevel : level;
+    return gKernelLevel;
+}
+
+void premultiplyRGBA(unsigned char* rgba, int pixelCount)
+{
+    for (int i = 0; i < pixelCount; i++, rgba += 4) {
+        int a = rgba[3];
+        if (a != 255) {
+            rgba[0] = (unsigned char)div255(rgba[0] * a);
+            rgba[1] = (unsigned char)div255(rgba[1] * a);
+            rgba[2] = (unsigned char)div255(rgba[2] * a);
+        }
+    }
+}
+
+void unpremultiplyRGBA(unsigned char* rgba, int pixelCount)
+{
+    for (int i = 0; i < pixelCount; i++, rgba += 4) {
+        int a = rgba[3];
+        if (a == 0) {
+            rgba[0] = rgba[1] = rgba[2] = 0;
+        }
+        else if (a != 255) {
+            for (int c = 0; c < 3; c++) {
+                int val = (rgba[c] * 255 + a / 2) / a;
+                rgba[c] = (unsigned char)(val > 255 ? 255 : val);
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////
+// Scalar versions, also used for the leftover pixels of the SIMD versions
+
+static void compositeOverlayScalar(unsigned char* dst, const unsigned char* overlay, int pixelCount)
+{
+    for (int i = 0; i < pixelCount; i++, dst += 4, overlay += 4) {
+        int inv = 255 - overlay[3];
+        for (int c = 0; c < 4; c++) {
+            dst[c] = (unsigned char)(overlay[c] + div255(dst[c] * inv));
+        }
+    }
+}
+
+static void tintMultiplyScalar(unsigned char* dst, int pixelCount, unsigned int tintColor)
+{
+    int tr = (tintColor >> 16) & 0xff;
+    int tg = (tintColor >> 8) & 0xff;
+    int tb = tintColor & 0xff;
+    for (int i = 0; i < pixelCount; i++, dst += 4) {
+        dst[0] = (unsigned char)div255(dst[0] * tr);
+        dst[1] = (unsigned char)div255(dst[1] * tg);
+        dst[2] = (unsigned char)div255(dst[2] * tb);
+    }
+}
+
+static void compositeTintedOverlayScalar(unsigned char* dst, const unsigned char* overlay, int pixelCount, unsigned int tintColor)
+{
+    int tint[4] = { (int)(tintColor >> 16) & 0xff, (int)(tintColor >> 8) & 0xff, (int)tintColor & 0xff, 255 };
+    for (int i = 0; i < pixelCount; i++, dst += 4, overlay += 4) {
+        int inv = 255 - overlay[3];
+        for (int c = 0; c < 4; c++) {
+            dst[c] = (unsigned char)(div255(overlay[c] * tint[c]) + div255(dst[c] * inv));
+        }
+    }
+}
+
+static void sumAlphaWeightedScalar(const unsigned char* rgba, int pixelCount, unsigned long long sums[4])
+{
+    unsigned long long r = 0, g = 0, b = 0, a = 0;
+    for (int i = 0; i < pixelCount; i++, rgba += 4) {
+        unsigned int alpha = rgba[3];
+        r += rgba[0] * alpha;
+        g += rgba[1] * alpha;
+        b += rgba[2] * alpha;
+        a += alpha;
+    }
+    sums[0] += r;
+    sums[1] += g;
+    sums[2] += b;
+    sums[3] += a;
+}
+
+#ifdef TILE_KERNELS_X86
+///////////////////////////////////////////////////////////////////
+// SSE4.1: four pixels at a time, widened to 16 bits per channel.
+// div255 on 16-bit lanes is ((x + 128) * 257) >> 16, same result as the scalar version.
+
+TARGET_SSE4 static inline __m128i div255_sse(__m128i x)
+{
+    return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+}
+
+// 255 - alpha, broadcast to all four channels of each 16-bit pixel
+TARGET_SSE4 static inline __m128i invAlpha_sse(__m128i px16)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_sub_epi16(_mm_set1_epi16(255), a);
+}
+
+TARGET_SSE4 static void compositeOverlaySSE4(unsigned char* dst, const unsigned char* overlay, int pixelCount)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+        __m128i o = _mm_loadu_si128((const __m128i*)(overlay + i * 4));
+        __m128i oLo = _mm_cvtepu8_epi16(o);
+        __m128i oHi = _mm_unpackhi_epi8(o, zero);
+        __m128i dLo = div255_sse(_mm_mullo_epi16(_mm_cvtepu8_epi16(d), invAlpha_sse(oLo)));
+        __m128i dHi = div255_sse(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), invAlpha_sse(oHi)));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(_mm_add_epi16(oLo, dLo), _mm_add_epi16(oHi, dHi)));
+    }
+    compositeOverlayScalar(dst + i * 4, overlay + i * 4, pixelCount - i);
+}
+
+TARGET_SSE4 static void tintMultiplySSE4(unsigned char* dst, int pixelCount, unsigned int tintColor)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i tint = _mm_setr_epi16((short)((tintColor >> 16) & 0xff), (short)((tintColor >> 8) & 0xff), (short)(tintColor & 0xff), 255,
+        (short)((tintColor >> 16) & 0xff), (short)((tintColor >> 8) & 0xff), (short)(tintColor & 0xff), 255);
+    int i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+        __m128i lo = div255_sse(_mm_mullo_epi16(_mm_cvtepu8_epi16(d), tint));
+        __m128i hi = div255_sse(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), tint));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    tintMultiplyScalar(dst + i * 4, pixelCount - i, tintColor);
+}
+
+TARGET_SSE4 static void compositeTintedOverlaySSE4(unsigned char* dst, const unsigned char* overlay, int pixelCount, unsigned int tintColor)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i tint = _mm_setr_epi16((short)((tintColor >> 16) & 0xff), (short)((tintColor >> 8) & 0xff), (short)(tintColor & 0xff), 255,
+        (short)((tintColor >> 16) & 0xff), (short)((tintColor >> 8) & 0xff), (short)(tintColor & 0xff), 255);
+    int i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+        __m128i o = _mm_loadu_si128((const __m128i*)(overlay + i * 4));
+        __m128i oLo = _mm_cvtepu8_epi16(o);
+        __m128i oHi = _mm_unpackhi_epi8(o, zero);
+        __m128i dLo = div255_sse(_mm_mullo_epi16(_mm_cvtepu8_epi16(d), invAlpha_sse(oLo)));
+        __m128i dHi = div255_sse(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), invAlpha_sse(oHi)));
+        oLo = div255_sse(_mm_mullo_epi16(oLo, tint));
+        oHi = div255_sse(_mm_mullo_epi16(oHi, tint));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(_mm_add_epi16(oLo, dLo), _mm_add_epi16(oHi, dHi)));
+    }
+    compositeTintedOverlayScalar(dst + i * 4, overlay + i * 4, pixelCount - i, tintColor);
+}
+
+// Each 32-bit lane gains at most 4*255*255 per step, so flush to 64 bits well before 2^32.
+#define SUM_FLUSH_STEPS 8192
+
+TARGET_SSE4 static void sumAlphaWeightedSSE4(const unsigned char* rgba, int pixelCount, unsigned long long sums[4])
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    int i = 0;
+    while (i + 4 <= pixelCount) {
+        __m128i acc = zero;
+        for (int step = 0; step < SUM_FLUSH_STEPS && i + 4 <= pixelCount; step++, i += 4) {
+            __m128i px = _mm_loadu_si128((const __m128i*)(rgba + i * 4));
+            __m128i lo = _mm_cvtepu8_epi16(px);
+            __m128i hi = _mm_unpackhi_epi8(px, zero);
+            // multiply r, g, b by alpha and alpha by 1; r*alpha is at most 65025, so it fits in 16 unsigned bits
+            __m128i aLo = _mm_blend_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), one, 0x88);
+            __m128i aHi = _mm_blend_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), one, 0x88);
+            __m128i pLo = _mm_mullo_epi16(lo, aLo);
+            __m128i pHi = _mm_mullo_epi16(hi, aHi);
+            // widen to 32 bits; the two pixels of each half land in the same four channel lanes
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_cvtepu16_epi32(pLo), _mm_unpackhi_epi16(pLo, zero)));
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_cvtepu16_epi32(pHi), _mm_unpackhi_epi16(pHi, zero)));
+        }
+        unsigned int lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        for (int c = 0; c < 4; c++) {
+            sums[c] += lanes[c];
+        }
+    }
+    sumAlphaWeightedScalar(rgba + i * 4, pixelCount - i, sums);
+}
+
+///////////////////////////////////////////////////////////////////
+// AVX2: eight pixels at a time. Unpack and pack both work within 128-bit lanes, so
+// unpacking against zero and packing back keeps the pixels in their original order.
+
+TARGET_AVX2 static inline __m256i div255_avx(__m256i x)
+{
+    return _mm256_mulhi_epu16(_mm256_add_epi16(x, _mm256_set1_epi16(128)), _mm256_set1_epi16(257));
+}
+
+TARGET_AVX2 static inline __m256i invAlpha_avx(__m256i px16)
+{
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+}
+
+TARGET_AVX2 static void compositeOverlayAVX2(unsigned char* dst, const unsigned char* overlay, int pixelCount)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+        __m256i o = _mm256_loadu_si256((const __m256i*)(overlay + i * 4));
+        __m256i oLo = _mm256_unpacklo_epi8(o, zero);
+        __m256i oHi = _mm256_unpackhi_epi8(o, zero);
+        __m256i dLo = div255_avx(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), invAlpha_avx(oLo)));
+        __m256i dHi = div255_avx(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), invAlpha_avx(oHi)));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(_mm256_add_epi16(oLo, dLo), _mm256_add_epi16(oHi, dHi)));
+    }
+    compositeOverlayScalar(dst + i * 4, overlay + i * 4, pixelCount - i);
+}
+
+TARGET_AVX2 static void tintMultiplyAVX2(unsigned char* dst, int pixelCount, unsigned int tintColor)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i tint = _mm256_set1_epi64x((long long)(((unsigned long long)255 << 48) | ((unsigned long long)(tintColor & 0xff) << 32) |
+        ((unsigned long long)((tintColor >> 8) & 0xff) << 16) | ((tintColor >> 16) & 0xff)));
+    int i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+        __m256i lo = div255_avx(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), tint));
+        __m256i hi = div255_avx(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), tint));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+    tintMultiplyScalar(dst + i * 4, pixelCount - i, tintColor);
+}
+
+TARGET_AVX2 static void compositeTintedOverlayAVX2(unsigned char* dst, const unsigned char* overlay, int pixelCount, unsigned int tintColor)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i tint = _mm256_set1_epi64x((long long)(((unsigned long long)255 << 48) | ((unsigned long long)(tintColor & 0xff) << 32) |
+        ((unsigned long long)((tintColor >> 8) & 0xff) << 16) | ((tintColor >> 16) & 0xff)));
+    int i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+        __m256i o = _mm256_loadu_si256((const __m256i*)(overlay + i * 4));
+        __m256i oLo = _mm256_unpacklo_epi8(o, zero);
+        __m256i oHi = _mm256_unpackhi_epi8(o, zero);
+        __m256i dLo = div255_avx(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), invAlpha_avx(oLo)));
+        __m256i dHi = div255_avx(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), invAlpha_avx(oHi)));
+        oLo = div255_avx(_mm256_mullo_epi16(oLo, tint));
+        oHi = div255_avx(_mm256_mullo_epi16(oHi, tint));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(_mm256_add_epi16(oLo, dLo), _mm256_add_epi16(oHi, dHi)));
+    }
+    compositeTintedOverlayScalar(dst + i * 4, overlay + i * 4, pixelCount - i, tintColor);
+}
+
+TARGET_AVX2 static void sumAlphaWeightedAVX2(const unsigned char* rgba, int pixelCount, unsigned long long sums[4])
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(1);
+    int i = 0;
+    while (i + 8 <= pixelCount) {
+        __m256i acc = zero;
+        for (int step = 0; step < SUM_FLUSH_STEPS && i + 8 <= pixelCount; step++, i += 8) {
+            __m256i px = _mm256_loadu_si256((const __m256i*)(rgba + i * 4));
+            __m256i lo = _mm256_unpacklo_epi8(px, zero);
+            __m256i hi = _mm256_unpackhi_epi8(px, zero);
+            __m256i aLo = _mm256_blend_epi16(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), one, 0x88);
+            __m256i aHi = _mm256_blend_epi16(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), one, 0x88);
+            __m256i pLo = _mm256_mullo_epi16(lo, aLo);
+            __m256i pHi = _mm256_mullo_epi16(hi, aHi);
+            acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_unpacklo_epi16(pLo, zero), _mm256_unpackhi_epi16(pLo, zero)));
+            acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_unpacklo_epi16(pHi, zero), _mm256_unpackhi_epi16(pHi, zero)));
+        }
+        unsigned int lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, acc);
+        for (int c = 0; c < 4; c++) {
+            sums[c] += (unsigned long long)lanes[c] + lanes[c + 4];
+        }
+    }
+    sumAlphaWeightedScalar(rgba + i * 4, pixelCount - i, sums);
+}
+#endif
+
+///////////////////////////////////////////////////////////////////
+// Dispatch
+
+void compositeOverlayRGBA(unsigned char* dst, const unsigned char* overlay, int pixelCount)
+{
+    switch (getTileKernelLevel()) {
+#ifdef TILE_KERNELS_X86
+    case TILE_KERNEL_AVX2:
+        compositeOverlayAVX2(dst, overlay, pixelCount);
+        break;
+    case TILE_KERNEL_SSE4:
+        compositeOverlaySSE4(dst, overlay, pixelCount);
+        break;
+#endif
+    default:
+        compositeOverlayScalar(dst, overlay, pixelCount);
+        break;
+    }
+}
+
+void tintMultiplyRGBA(unsigned char* dst, int pixelCount, unsigned int tintColor)
+{
+    switch (getTileKernelLevel()) {
+#ifdef TILE_KERNELS_X86
+    case TILE_KERNEL_AVX2:
+        tintMultiplyAVX2(dst, pixelCount, tintColor);
+        break;
+    case TILE_KERNEL_SSE4:
+        tintMultiplySSE4(dst, pixelCount, tintColor);
+        break;
+#endif
+    default:
+        tintMultiplyScalar(dst, pixelCount, tintColor);
+        break;
+    }
+}
+
+void compositeTintedOverlayRGBA(unsigned char* dst, const unsigned char* overlay, int pixelCount, unsigned int tintColor)
+{
+    switch (getTileKernelLevel()) {
+#ifdef TILE_KERNELS_X86
+    case TILE_KERNEL_AVX2:
+        compositeTintedOverlayAVX2(dst, overlay, pixelCount, tintColor);
+        break;
+    case TILE_KERNEL_SSE4:
+        compositeTintedOverlaySSE4(dst, overlay, pixelCount, tintColor);
+        break;
+#endif
+    default:
+        compositeTintedOverlayScalar(dst, overlay, pixelCount, tintColor);
+        break;
+    }
+}
+
+void sumAlphaWeightedRGBA(const unsigned char* rgba, int pixelCount, unsigned long long sums[4])
+{
+    switch (getTileKernelLevel()) {
+#ifdef TILE_KERNELS_X86
+    case TILE_KERNEL_AVX2:
+        sumAlphaWeightedAVX2(rgba, pixelCount, sums);
+        break;
+    case TILE_KERNEL_SSE4:
+        sumAlphaWeightedSSE4(rgba, pixelCount, sums);
+        break;
+#endif
+    default:
+        sumAlphaWeightedScalar(rgba, pixelCount, sums);
+        break;
+    }
+}
+
+///////////////////////////////////////////////////////////////////
+// Benchmark
+
+void benchmarkTileKernels(FILE* fh)
+{
+    // a 16-wide terrainExt.png at 256x256 tiles is 4096 x 18432; use one 4096 x 1024 strip, which stays out of cache like the real thing
+    const int pixelCount = 4096 * 1024;
+    const int passes = 20;
+    static const char* levelName[3] = { "scalar", "SSE4.1", "AVX2" };
+
+    std::vector<unsigned char> base(pixelCount * 4), overlay(pixelCount * 4), work(pixelCount * 4);
+    unsigned int seed = 12345;
+    for (int i = 0; i < pixelCount * 4; i++) {
+        seed = seed * 1664525 + 1013904223;
+        base[i] = (unsigned char)(seed >> 24);
+        overlay[i] = (unsigned char)(seed >> 16);
+    }
+    premultiplyRGBA(overlay.data(), pixelCount);
+
+    int savedLevel = getTileKernelLevel();
+    fprintf(fh, "Tile kernel benchmark, %d pixels x %d passes, one thread (megapixels per second)\n", pixelCount, passes);
+    for (int level = TILE_KERNEL_SCALAR; level <= gKernelMaxLevel; level++) {
+        setTileKernelLevel(level);
+        double mps[4];
+        unsigned long long sums[4] = { 0, 0, 0, 0 };
+        for (int kernel = 0; kernel < 4; kernel++) {
+            memcpy(work.data(), base.data(), work.size());
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            for (int pass = 0; pass < passes; pass++) {
+                switch (kernel) {
+                case 0:
+                    compositeOverlayRGBA(work.data(), overlay.data(), pixelCount);
+                    break;
+                case 1:
+                    tintMultiplyRGBA(work.data(), pixelCount, 0x8cbd57);
+                    break;
+                case 3:
+                    sumAlphaWeightedRGBA(work.data(), pixelCount, sums);
+                    break;
+                default:
+                    compositeTintedOverlayRGBA(work.data(), overlay.data(), pixelCount, 0x8cbd57);
+                    break;
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            mps[kernel] = (seconds > 0.0) ? (double)pixelCount * passes / seconds / 1.0e6 : 0.0;
+        }
+        fprintf(fh, "  %-7s composite %8.1f  tint %8.1f  tinted composite %8.1f  alpha-weighted sum %8.1f\n", levelName[level], mps[0], mps[1], mps[2], mps[3]);
+    }
+    setTileKernelLevel(savedLevel);
+}
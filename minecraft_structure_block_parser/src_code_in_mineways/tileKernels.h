@@ -0,0 +1,40 @@
+// tileKernels.h - per-pixel kernels used when building tiles: overlay compositing and biome tinting
+
+#pragma once
+
+// All kernels work on tightly packed 8-bit RGBA pixels, R first, as read from the .png files.
+// Compositing is done with premultiplied alpha, so call premultiplyRGBA() on both images first
+// and unpremultiplyRGBA() on the result if a straight-alpha image is wanted for output.
+
+// which code path the kernels use; the best one the CPU supports is picked the first time a kernel is called
+#define TILE_KERNEL_SCALAR  0
+#define TILE_KERNEL_SSE4    1
+#define TILE_KERNEL_AVX2    2
+
+// returns the level actually in use
+int getTileKernelLevel();
+// force a lower level, e.g. for testing or benchmarking; asking for more than the CPU has gives the best available. Returns level set.
+int setTileKernelLevel(int level);
+
+// rgb *= alpha, in place
+void premultiplyRGBA(unsigned char* rgba, int pixelCount);
+// rgb /= alpha, in place; fully transparent pixels are left black
+void unpremultiplyRGBA(unsigned char* rgba, int pixelCount);
+
+// dst = overlay + dst * (1 - overlay alpha), all premultiplied. This is how SBIT_ALPHA_OVERLAY tiles
+// such as grass_block_side_overlay get put on top of their base tile.
+void compositeOverlayRGBA(unsigned char* dst, const unsigned char* overlay, int pixelCount);
+
+// dst.rgb *= tint.rgb, with tint given as 0xRRGGBB like read_color; alpha is unchanged. Works on
+// either premultiplied or straight alpha, since it's just a scale. Used for the EXPT_BIOME grass, foliage and water colors.
+void tintMultiplyRGBA(unsigned char* dst, int pixelCount, unsigned int tintColor);
+
+// the usual grass side case in one pass: dst = tint(overlay) over dst, all premultiplied
+void compositeTintedOverlayRGBA(unsigned char* dst, const unsigned char* overlay, int pixelCount, unsigned int tintColor);
+
+// Add the alpha-weighted sums of r, g and b (each channel times alpha) and the sum of alpha to sums[0..3],
+// which are not cleared first, so a tile can be summed a row at a time. Used for tile average colors.
+void sumAlphaWeightedRGBA(const unsigned char* rgba, int pixelCount, unsigned long long sums[4]);
+
+// time each available code path on a tile-atlas-sized buffer, single threaded, and print pixels per second to the file
+void benchmarkTileKernels(FILE* fh);
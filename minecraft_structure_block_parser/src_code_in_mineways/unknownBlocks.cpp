@@ -0,0 +1,172 @@
+// unknownBlocks.cpp - remember block names that have no translation, and count them for one report at the end
+
+#include "stdafx.h"
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include "unknownBlocks.h"
+
+#define UNKNOWN_BLOCK_SHARDS 8
+
+typedef struct UnknownName {
+    std::string name;
+    std::atomic<unsigned long long> count;
+} UnknownName;
+
+typedef struct UnknownShard {
+    std::shared_mutex lock;
+    // keys are views of the entries' names; entries are never moved or freed until cleared
+    std::unordered_map<std::string_view, UnknownName*> names;
+    std::atomic<unsigned long long> lookups;
+    std::atomic<unsigned long long> hits;
+} UnknownShard;
+
+struct UnknownBlockLog {
+    UnknownShard shards[UNKNOWN_BLOCK_SHARDS];
+};
+
+static UnknownShard& getShard(UnknownBlockLog* log, const char* name, int length)
+{
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return log->shards[hash % UNKNOWN_BLOCK_SHARDS];
+}
+
+UnknownBlockLog* createUnknownBlockLog()
+{
+    UnknownBlockLog* log = new (std::nothrow) UnknownBlockLog;
+    if (log != NULL) {
+        for (int s = 0; s < UNKNOWN_BLOCK_SHARDS; s++) {
+            log->shards[s].lookups.store(0);
+            log->shards[s].hits.store(0);
+        }
+    }
+    return log;
+}
+
+void destroyUnknownBlockLog(UnknownBlockLog* log)
+{
+    if (log != NULL) {
+        clearUnknownBlockLog(log);
+        delete log;
+    }
+}
+
+void clearUnknownBlockLog(UnknownBlockLog* log)
+{
+    for (int s = 0; s < UNKNOWN_BLOCK_SHARDS; s++) {
+        UnknownShard& shard = log->shards[s];
+        std::unique_lock<std::shared_mutex> writeLock(shard.lock);
+        for (std::unordered_map<std::string_view, UnknownName*>::iterator it = shard.names.begin(); it != shard.names.end(); ++it) {
+            delete it->second;
+        }
+        shard.names.clear();
+        shard.lookups.store(0);
+        shard.hits.store(0);
+    }
+}
+
+bool isUnknownBlock(UnknownBlockLog* log, const char* name, int length)
+{
+    UnknownShard& shard = getShard(log, name, length);
+    shard.lookups.fetch_add(1, std::memory_order_relaxed);
+    std::shared_lock<std::shared_mutex> readLock(shard.lock);
+    if (shard.names.empty()) {
+        return false;
+    }
+    std::unordered_map<std::string_view, UnknownName*>::iterator it = shard.names.find(std::string_view(name, length));
+    if (it == shard.names.end()) {
+        return false;
+    }
+    it->second->count.fetch_add(1, std::memory_order_relaxed);
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool addUnknownBlock(UnknownBlockLog* log, const char* name, int length)
+{
+    UnknownShard& shard = getShard(log, name, length);
+    std::unique_lock<std::shared_mutex> writeLock(shard.lock);
+    std::unordered_map<std::string_view, UnknownName*>::iterator it = shard.names.find(std::string_view(name, length));
+    if (it != shard.names.end()) {
+        // another thread got here first
+        it->second->count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    UnknownName* entry = new UnknownName;
+    entry->name.assign(name, length);
+    entry->count.store(1, std::memory_order_relaxed);
+    shard.names[std::string_view(entry->name)] = entry;
+    return true;
+}
+
+void getUnknownBlockReport(UnknownBlockLog* log, std::vector<UnknownBlockCount>& report)
+{
+    report.clear();
+    for (int s = 0; s < UNKNOWN_BLOCK_SHARDS; s++) {
+        UnknownShard& shard = log->shards[s];
+        std::shared_lock<std::shared_mutex> readLock(shard.lock);
+        for (std::unordered_map<std::string_view, UnknownName*>::iterator it = shard.names.begin(); it != shard.names.end(); ++it) {
+            UnknownBlockCount entry;
+            entry.name = it->second->name;
+            entry.count = it->second->count.load(std::memory_order_relaxed);
+            report.push_back(entry);
+        }
+    }
+    std::sort(report.begin(), report.end(), [](const UnknownBlockCount& a, const UnknownBlockCount& b) {
+        return (a.count != b.count) ? (a.count > b.count) : (a.name < b.name);
+    });
+}
+
+int formatUnknownBlockReport(UnknownBlockLog* log, char* text, int textSize, int maxNames)
+{
+    std::vector<UnknownBlockCount> report;
+    getUnknownBlockReport(log, report);
+    if (textSize <= 0) {
+        return (int)report.size();
+    }
+    text[0] = '\0';
+    int length = 0;
+    int shown = 0;
+    for (size_t i = 0; i < report.size() && shown < maxNames; i++) {
+        // straight into the text, as a name can be far longer than any buffer here
+        int n = snprintf(text + length, textSize - length, "%s%s (%llu)", (i > 0) ? ", " : "", report[i].name.c_str(), report[i].count);
+        // leave room for the "and N more" ending, dropping the entry if there isn't
+        if (n < 0 || length + n + 24 >= textSize) {
+            text[length] = '\0';
+            break;
+        }
+        length += n;
+        shown++;
+    }
+    if (shown < (int)report.size()) {
+        snprintf(text + length, textSize - length, "%sand %d more", (shown > 0) ? ", " : "", (int)report.size() - shown);
+    }
+    return (int)report.size();
+}
+
+void getUnknownBlockStats(UnknownBlockLog* log, UnknownBlockStats& stats)
+{
+    stats.lookups = 0;
+    stats.hits = 0;
+    stats.names = 0;
+    for (int s = 0; s < UNKNOWN_BLOCK_SHARDS; s++) {
+        UnknownShard& shard = log->shards[s];
+        stats.lookups += shard.lookups.load(std::memory_order_relaxed);
+        stats.hits += shard.hits.load(std::memory_order_relaxed);
+        std::shared_lock<std::shared_mutex> readLock(shard.lock);
+        stats.names += (int)shard.names.size();
+    }
+}
+
+UnknownBlockLog* getSessionUnknownBlockLog()
+{
+    static UnknownBlockLog* log = createUnknownBlockLog();
+    return log;
+}
@@ -0,0 +1,45 @@
+// unknownBlocks.h - remember block names that have no translation, and count them for one report at the end
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A world from a newer Minecraft has the same few unknown names in every section. Once a name has failed
+// to translate, a palette reader checks here first and treats it as unknown at once, and instead of
+// reporting each time, everything is counted and summed up once the export is done. Safe for many threads.
+// The Java structure reader and the Bedrock palette translation use it; readPalette() should too.
+
+typedef struct UnknownBlockLog UnknownBlockLog;
+
+typedef struct UnknownBlockCount {
+    std::string name;
+    unsigned long long count;
+} UnknownBlockCount;
+
+typedef struct UnknownBlockStats {
+    unsigned long long lookups;     // isUnknownBlock() calls
+    unsigned long long hits;        // of which the name was known to be unknown
+    int names;                      // distinct unknown names
+} UnknownBlockStats;
+
+UnknownBlockLog* createUnknownBlockLog();
+void destroyUnknownBlockLog(UnknownBlockLog* log);
+// forget all names and counts, e.g. between exports
+void clearUnknownBlockLog(UnknownBlockLog* log);
+
+// True if the name has already failed to translate; it is then counted once more.
+bool isUnknownBlock(UnknownBlockLog* log, const char* name, int length);
+// Record a name that failed to translate, counting it. Returns true only the first time for a name,
+// so anything done per name, such as filling in readPalette()'s unknownBlock, need happen only once.
+bool addUnknownBlock(UnknownBlockLog* log, const char* name, int length);
+
+// every unknown name with its count, most frequent first
+void getUnknownBlockReport(UnknownBlockLog* log, std::vector<UnknownBlockCount>& report);
+// The same as text, "name (count), ...", for a message; names past maxNames are summed up as "and N more".
+// Returns the number of names.
+int formatUnknownBlockReport(UnknownBlockLog* log, char* text, int textSize, int maxNames);
+void getUnknownBlockStats(UnknownBlockLog* log, UnknownBlockStats& stats);
+
+// the log palette readers use for the current export, made on first use
+UnknownBlockLog* getSessionUnknownBlockLog();
@@ -0,0 +1,206 @@
+// worldIndex.cpp - where, when and with what blocks each chunk of a world was saved, so a later export can skip what hasn't changed
+
+#include "stdafx.h"
+#include <string.h>
+#include <vector>
+#include "portafile.h"
+#include "mappedFile.h"
+#include "nbtView.h"
+#include "chunkCompression.h"
+#include "regionFile.h"
+#include "worldIndex.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// records are written as their structs, so the structs must have no hidden padding
+static_assert(sizeof(WorldIndexHeader) == 32, "WorldIndexHeader layout changed");
+static_assert(sizeof(WorldIndexEntry) == 32, "WorldIndexEntry layout changed");
+
+static uint32_t fnv1a(const unsigned char* data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint64_t fnv1a64(const unsigned char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool isLittleEndian()
+{
+    const uint16_t one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+int loadWorldIndex(const wchar_t* filename, WorldIndex& index)
+{
+    index.entries.clear();
+    if (!isLittleEndian()) {
+        return LINE_ERROR;
+    }
+    MappedFile mf;
+    int retCode = openMappedFile(filename, mf);
+    if (retCode < 0) {
+        return retCode;
+    }
+    const WorldIndexHeader* header = (const WorldIndexHeader*)mf.data;
+    if (mf.size < sizeof(WorldIndexHeader) ||
+        memcmp(header->magic, WORLD_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+        header->versionMajor != WORLD_INDEX_VERSION_MAJOR ||
+        header->headerSize < sizeof(WorldIndexHeader) || header->headerSize > mf.size ||
+        header->entryStride < sizeof(WorldIndexEntry) || (header->entryStride & 7) != 0 || (header->entryOffset & 7) != 0 ||
+        header->entryOffset > mf.size || (unsigned long long)header->entryCount * header->entryStride > mf.size - header->entryOffset ||
+        fnv1a(mf.data + header->headerSize, mf.size - header->headerSize) != header->checksum) {
+        closeMappedFile(mf);
+        return LINE_ERROR;
+    }
+    index.entries.reserve(header->entryCount);
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        const WorldIndexEntry* entry = (const WorldIndexEntry*)(mf.data + header->entryOffset + (size_t)i * header->entryStride);
+        index.entries[worldIndexKey(entry->dimension, entry->chunkX, entry->chunkZ)] = *entry;
+    }
+    closeMappedFile(mf);
+    return 0;
+}
+
+int saveWorldIndex(const wchar_t* filename, const WorldIndex& index)
+{
+    // records are written as they sit in memory
+    if (!isLittleEndian()) {
+        return LINE_ERROR;
+    }
+    std::vector<WorldIndexEntry> entries;
+    entries.reserve(index.entries.size());
+    for (std::unordered_map<uint64_t, WorldIndexEntry>::const_iterator it = index.entries.begin(); it != index.entries.end(); ++it) {
+        entries.push_back(it->second);
+    }
+
+    WorldIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WORLD_INDEX_MAGIC, sizeof(header.magic));
+    header.versionMajor = WORLD_INDEX_VERSION_MAJOR;
+    header.versionMinor = WORLD_INDEX_VERSION_MINOR;
+    header.headerSize = sizeof(WorldIndexHeader);
+    header.entryCount = (uint32_t)entries.size();
+    header.entryStride = sizeof(WorldIndexEntry);
+    header.entryOffset = header.headerSize;
+    header.checksum = fnv1a((const unsigned char*)entries.data(), entries.size() * sizeof(WorldIndexEntry));
+
+    DWORD br;
+    PORTAFILE fh = PortaCreate(filename);
+    if (fh == INVALID_HANDLE_VALUE) {
+        return LINE_ERROR;
+    }
+    if (PortaWrite(fh, &header, sizeof(header)) ||
+        (!entries.empty() && PortaWrite(fh, entries.data(), (DWORD)(entries.size() * sizeof(WorldIndexEntry))))) {
+        PortaClose(fh);
+        return LINE_ERROR;
+    }
+    PortaClose(fh);
+    return 0;
+}
+
+// Hash of the chunk's sections list, where its blocks are: at the root since 1.18, in Level before.
+// A chunk without one is hashed whole. Returns false if the NBT is damaged.
+static bool hashSections(const std::vector<unsigned char>& nbt, uint64_t& hash)
+{
+    NbtView view = { nbt.data(), nbt.size(), false };
+    NbtTag root, level, sections;
+    if (!nbtGetRoot(view, root)) {
+        return false;
+    }
+    if (nbtFindChild(view, root, "sections", sections) ||
+        (nbtFindChild(view, root, "Level", level) && nbtFindChild(view, level, "Sections", sections))) {
+        const unsigned char* end = nbtSkipPayload(view, sections.type, sections.payload);
+        if (end == NULL) {
+            return false;
+        }
+        hash = fnv1a64(sections.payload, end - sections.payload);
+        return true;
+    }
+    hash = fnv1a64(nbt.data(), nbt.size());
+    return true;
+}
+
+static void addChange(std::vector<ChunkChange>& changes, int chunkX, int chunkZ, int change)
+{
+    ChunkChange c;
+    c.chunkX = chunkX;
+    c.chunkZ = chunkZ;
+    c.change = change;
+    changes.push_back(c);
+}
+
+int updateWorldIndex(WorldIndex& index, int dimension, const wchar_t* regionFilename, std::vector<ChunkChange>& changes)
+{
+    RegionFile region;
+    int retCode = openRegionFile(regionFilename, region);
+    if (retCode < 0) {
+        return retCode;
+    }
+    // world coordinates come from the name
+    if (!region.named) {
+        closeRegionFile(region);
+        return LINE_ERROR;
+    }
+    int chunkCount = 0;
+    std::vector<unsigned char> nbt;
+    for (int z = 0; z < 32; z++) {
+        for (int x = 0; x < 32; x++) {
+            int chunkX = region.regionX * 32 + x;
+            int chunkZ = region.regionZ * 32 + z;
+            uint64_t key = worldIndexKey(dimension, chunkX, chunkZ);
+            std::unordered_map<uint64_t, WorldIndexEntry>::iterator it = index.entries.find(key);
+            RegionChunk chunk;
+            retCode = getRegionChunk(region, x, z, chunk);
+            if (retCode == 1) {
+                if (it != index.entries.end()) {
+                    index.entries.erase(it);
+                    addChange(changes, chunkX, chunkZ, CHUNK_REMOVED);
+                }
+                continue;
+            }
+            chunkCount++;
+            uint8_t storedType = (uint8_t)(chunk.compressionType | (chunk.external ? CHUNK_COMPRESSION_EXTERNAL : 0));
+            if (retCode == 0 && it != index.entries.end() && it->second.timestamp == chunk.timestamp &&
+                it->second.sector == chunk.sector && it->second.sectorCount == chunk.sectorCount &&
+                it->second.compressionType == storedType) {
+                continue;
+            }
+
+            // moved or saved again, so see if its blocks changed
+            uint64_t hash;
+            if (retCode < 0 || decompressChunk(chunk.compressionType, chunk.data, chunk.size, nbt) < 0 || !hashSections(nbt, hash)) {
+                if (it != index.entries.end()) {
+                    index.entries.erase(it);
+                }
+                addChange(changes, chunkX, chunkZ, CHUNK_CHANGED);
+                continue;
+            }
+            int change = (it == index.entries.end()) ? CHUNK_ADDED : ((it->second.sectionsHash == hash) ? CHUNK_RESAVED : CHUNK_CHANGED);
+            WorldIndexEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.sectionsHash = hash;
+            entry.chunkX = chunkX;
+            entry.chunkZ = chunkZ;
+            entry.sector = chunk.sector;
+            entry.timestamp = chunk.timestamp;
+            entry.dimension = (int8_t)dimension;
+            entry.compressionType = storedType;
+            entry.sectorCount = (uint8_t)chunk.sectorCount;
+            index.entries[key] = entry;
+            addChange(changes, chunkX, chunkZ, change);
+        }
+    }
+    closeRegionFile(region);
+    return chunkCount;
+}
@@ -0,0 +1,80 @@
+// worldIndex.h - where, when and with what blocks each chunk of a world was saved, so a later export can skip what hasn't changed
+
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+// One small file per world, little-endian:
+//   WorldIndexHeader
+//   entries: entryCount records of entryStride bytes, each starting with a WorldIndexEntry, in no order
+// As for block packs (blockPack.h), a minor version only adds fields to the ends of records, so readers step
+// by the stride.
+//
+// A chunk whose region location and timestamp are as indexed is taken to be unchanged without reading it.
+// Any other chunk is decoded and its sections hashed; if the hash is as indexed, the chunk was saved again
+// without its blocks changing (as when only entities moved), and needn't be exported again either.
+
+#define WORLD_INDEX_MAGIC           "MWWLDIDX"
+#define WORLD_INDEX_VERSION_MAJOR   1
+#define WORLD_INDEX_VERSION_MINOR   0
+
+typedef struct WorldIndexHeader {
+    char magic[8];
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    uint32_t headerSize;
+    uint32_t entryCount;
+    uint32_t entryStride;
+    uint32_t entryOffset;
+    uint32_t checksum;          // FNV-1a of everything after the header
+} WorldIndexHeader;
+
+typedef struct WorldIndexEntry {
+    uint64_t sectionsHash;      // 64-bit FNV-1a of the chunk's decoded sections list
+    int32_t chunkX;             // world chunk coordinates
+    int32_t chunkZ;
+    uint32_t sector;            // where the chunk is in its region file, from the location table
+    uint32_t timestamp;         // from the timestamp table
+    int8_t dimension;           // 0 overworld, -1 nether, 1 end
+    uint8_t compressionType;    // CHUNK_COMPRESSION_*, with CHUNK_COMPRESSION_EXTERNAL for .mcc chunks
+    uint8_t sectorCount;
+    uint8_t pad;
+    uint32_t reserved;
+} WorldIndexEntry;
+
+typedef struct WorldIndex {
+    // by worldIndexKey()
+    std::unordered_map<uint64_t, WorldIndexEntry> entries;
+} WorldIndex;
+
+inline uint64_t worldIndexKey(int dimension, int chunkX, int chunkZ)
+{
+    // chunk coordinates fit in 24 bits, as the world is 60 million blocks across
+    return ((uint64_t)(uint8_t)dimension << 48) | ((uint64_t)(chunkX & 0xffffff) << 24) | (uint64_t)(chunkZ & 0xffffff);
+}
+
+// what updateWorldIndex() found for a chunk
+#define CHUNK_UNCHANGED     0   // same place and timestamp; not read
+#define CHUNK_RESAVED       1   // saved again, but its sections hash the same
+#define CHUNK_CHANGED       2
+#define CHUNK_ADDED         3
+#define CHUNK_REMOVED       4
+
+typedef struct ChunkChange {
+    int chunkX;
+    int chunkZ;
+    int change;                 // CHUNK_*
+} ChunkChange;
+
+// Returns 0 on success, negative on error; the index is left empty on error, as for a first run.
+int loadWorldIndex(const wchar_t* filename, WorldIndex& index);
+// Returns 0 on success, negative on error.
+int saveWorldIndex(const wchar_t* filename, const WorldIndex& index);
+
+// Compare one region file, named r.X.Z.mca, with the index, decoding only chunks whose location or timestamp
+// differ, and bring the index up to date. Every chunk but the unchanged ones is added to changes; those
+// CHUNK_CHANGED or CHUNK_ADDED need exporting again. Returns the number of chunks in the region file, or
+// negative on error. A chunk that can't be decoded is left out of the index, so it's tried again next time.
+int updateWorldIndex(WorldIndex& index, int dimension, const wchar_t* regionFilename, std::vector<ChunkChange>& changes);
@@ -0,0 +1,314 @@
+// worldStats.cpp - count every block of a world by name and by type, per dimension and per height, from section palettes
+
+#include "stdafx.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "nbtView.h"
+#include "modRegistry.h"
+#include "regionFile.h"
+#include "chunkSections.h"
+#include "javaStructure.h"
+#include "worldStats.h"
+
+// return a negative number, giving the line of the code where it returned
+#define LINE_ERROR (-(__LINE__))
+
+// one thread's histograms for a dimension
+typedef struct DimensionCounts {
+    DimensionStats stats;
+    std::unordered_map<std::string, int> nameIndex;     // into stats.names
+    std::vector<int> typeIndex;                         // into stats.types, by type; -1 if not seen
+} DimensionCounts;
+
+// what a thread reuses from section to section
+typedef struct SectionScratch {
+    std::string key;
+    std::vector<unsigned int> layerCounts;      // 16 layers of 1 << bits
+    int nameOf[SECTION_BLOCKS];                 // for each palette entry, its BlockCount in names, or -1
+    int typeOf[SECTION_BLOCKS];                 // and in types
+} SectionScratch;
+
+int getWorldStatsDimensionIndex(int dimension)
+{
+    switch (dimension) {
+    case 0:
+        return 0;
+    case -1:
+        return 1;
+    case 1:
+        return 2;
+    default:
+        return -1;
+    }
+}
+
+static void clearDimensionStats(DimensionStats& stats, int dimension)
+{
+    stats.dimension = dimension;
+    stats.regionCount = 0;
+    stats.regionErrors = 0;
+    stats.chunkCount = 0;
+    stats.chunkErrors = 0;
+    stats.sectionCount = 0;
+    stats.uniformSectionCount = 0;
+    stats.blockCount = 0;
+    stats.names.clear();
+    stats.types.clear();
+}
+
+static int addBlockCount(std::vector<BlockCount>& counts, const char* name, int nameLength, int type)
+{
+    counts.push_back(BlockCount());
+    BlockCount& count = counts.back();
+    count.name.assign(name, nameLength);
+    count.type = type;
+    count.count = 0;
+    memset(count.byLevel, 0, sizeof(count.byLevel));
+    return (int)counts.size() - 1;
+}
+
+static void addToCount(BlockCount& count, int level, unsigned long long n)
+{
+    count.count += n;
+    if (level >= 0 && level < WORLD_STATS_HEIGHT) {
+        count.byLevel[level] += n;
+    }
+}
+
+// finds each palette entry's histograms, adding them the first time a name or type is seen
+static void findPaletteCounts(const NbtView& view, const ChunkSection& section, DimensionCounts& counts, SectionScratch& scratch)
+{
+    ModRegistryPin pin;
+    pinModRegistry(pin);
+    NbtIterator it;
+    NbtTag entry;
+    nbtIterate(view, section.palette, it);
+    int p = 0;
+    for (; p < section.paletteCount && nbtNext(view, it, entry); p++) {
+        const char* name;
+        int length;
+        scratch.nameOf[p] = scratch.typeOf[p] = -1;
+        if (!getPaletteEntryName(view, entry, name, length)) {
+            continue;
+        }
+        scratch.key.assign(name, length);
+        std::unordered_map<std::string, int>::iterator found = counts.nameIndex.find(scratch.key);
+        unsigned short type;
+        unsigned char dataVal;
+        bool known = translateJavaPaletteEntry(view, entry, pin, type, dataVal) && type < NUM_BLOCKS_DEFINED;
+        if (found == counts.nameIndex.end()) {
+            // a name's type is what its first state translates to; the same for nearly all names
+            int index = addBlockCount(counts.stats.names, name, length, known ? type : -1);
+            found = counts.nameIndex.insert(std::make_pair(scratch.key, index)).first;
+        }
+        scratch.nameOf[p] = found->second;
+        // but types are counted state by state, as a slab's type=double is a different type
+        if (known) {
+            if (counts.typeIndex[type] < 0) {
+                const char* typeName = gBlockDefinitions[type].name;
+                counts.typeIndex[type] = addBlockCount(counts.stats.types, typeName, (int)strlen(typeName), type);
+            }
+            scratch.typeOf[p] = counts.typeIndex[type];
+        }
+    }
+    for (; p < section.paletteCount; p++) {
+        scratch.nameOf[p] = scratch.typeOf[p] = -1;
+    }
+    unpinModRegistry(pin);
+}
+
+static void countSection(const NbtView& view, const ChunkSection& section, DimensionCounts& counts, SectionScratch& scratch)
+{
+    DimensionStats& stats = counts.stats;
+    stats.sectionCount++;
+    findPaletteCounts(view, section, counts, scratch);
+    int baseLevel = section.sectionY * 16 - ABSOLUTE_MIN_MAP_HEIGHT;
+    if (section.bits == 0) {
+        // the whole section is the one entry, with no data to read
+        stats.uniformSectionCount++;
+        for (int y = 0; y < 16; y++) {
+            if (scratch.nameOf[0] >= 0) {
+                addToCount(stats.names[scratch.nameOf[0]], baseLevel + y, SECTION_BLOCKS / 16);
+                stats.blockCount += SECTION_BLOCKS / 16;
+            }
+            if (scratch.typeOf[0] >= 0) {
+                addToCount(stats.types[scratch.typeOf[0]], baseLevel + y, SECTION_BLOCKS / 16);
+            }
+        }
+        return;
+    }
+    scratch.layerCounts.resize((size_t)16 << section.bits);
+    countSectionIndices(section, scratch.layerCounts.data());
+    // indices past the palette are damage, and aren't counted
+    for (int y = 0; y < 16; y++) {
+        const unsigned int* layer = scratch.layerCounts.data() + (y << section.bits);
+        for (int p = 0; p < section.paletteCount; p++) {
+            if (layer[p] == 0) {
+                continue;
+            }
+            if (scratch.nameOf[p] >= 0) {
+                addToCount(stats.names[scratch.nameOf[p]], baseLevel + y, layer[p]);
+                stats.blockCount += layer[p];
+            }
+            if (scratch.typeOf[p] >= 0) {
+                addToCount(stats.types[scratch.typeOf[p]], baseLevel + y, layer[p]);
+            }
+        }
+    }
+}
+
+static void countRegion(const wchar_t* filename, DimensionCounts& counts, SectionScratch& scratch, std::vector<unsigned char>& nbt)
+{
+    DimensionStats& stats = counts.stats;
+    RegionFile region;
+    if (openRegionFile(filename, region) < 0) {
+        stats.regionErrors++;
+        return;
+    }
+    stats.regionCount++;
+    for (int z = 0; z < 32; z++) {
+        for (int x = 0; x < 32; x++) {
+            int retCode = readRegionChunk(region, x, z, nbt);
+            if (retCode == 1) {
+                continue;
+            }
+            NbtView view = { nbt.data(), nbt.size(), false };
+            NbtTag sections;
+            NbtIterator it;
+            int chunkX, chunkZ;
+            if (retCode < 0 || !getChunkSections(view, chunkX, chunkZ, sections) || !nbtIterate(view, sections, it)) {
+                stats.chunkErrors++;
+                continue;
+            }
+            stats.chunkCount++;
+            ChunkSection section;
+            while (nextChunkSection(view, it, section)) {
+                countSection(view, section, counts, scratch);
+            }
+        }
+    }
+    closeRegionFile(region);
+}
+
+static bool moreCommon(const BlockCount& a, const BlockCount& b)
+{
+    return (a.count != b.count) ? a.count > b.count : a.name < b.name;
+}
+
+static void addCounts(BlockCount& total, const BlockCount& count)
+{
+    total.count += count.count;
+    for (int level = 0; level < WORLD_STATS_HEIGHT; level++) {
+        total.byLevel[level] += count.byLevel[level];
+    }
+}
+
+// adds one thread's histograms to the totals, matching names up by name and types by type
+static void mergeCounts(DimensionCounts& totals, const DimensionStats& counts)
+{
+    for (size_t i = 0; i < counts.names.size(); i++) {
+        const BlockCount& count = counts.names[i];
+        std::unordered_map<std::string, int>::iterator found = totals.nameIndex.find(count.name);
+        if (found == totals.nameIndex.end()) {
+            totals.nameIndex.insert(std::make_pair(count.name, (int)totals.stats.names.size()));
+            totals.stats.names.push_back(count);
+        }
+        else {
+            addCounts(totals.stats.names[found->second], count);
+        }
+    }
+    for (size_t i = 0; i < counts.types.size(); i++) {
+        const BlockCount& count = counts.types[i];
+        if (totals.typeIndex[count.type] < 0) {
+            totals.typeIndex[count.type] = (int)totals.stats.types.size();
+            totals.stats.types.push_back(count);
+        }
+        else {
+            addCounts(totals.stats.types[totals.typeIndex[count.type]], count);
+        }
+    }
+}
+
+int gatherWorldStats(const wchar_t* const* regionFilenames, const int* dimensions, int fileCount, int threadCount, WorldStats& stats)
+{
+    static const int dimensionOf[WORLD_STATS_DIMENSIONS] = { 0, -1, 1 };
+    for (int d = 0; d < WORLD_STATS_DIMENSIONS; d++) {
+        clearDimensionStats(stats.dimensions[d], dimensionOf[d]);
+    }
+    for (int f = 0; f < fileCount; f++) {
+        if (getWorldStatsDimensionIndex(dimensions[f]) < 0) {
+            return LINE_ERROR;
+        }
+    }
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+    if (threadCount > fileCount) {
+        threadCount = (fileCount > 0) ? fileCount : 1;
+    }
+
+    // each thread has its own histograms, so counting needs no locks at all
+    std::vector<std::vector<DimensionCounts>> threadCounts(threadCount, std::vector<DimensionCounts>(WORLD_STATS_DIMENSIONS));
+    for (int t = 0; t < threadCount; t++) {
+        for (int d = 0; d < WORLD_STATS_DIMENSIONS; d++) {
+            clearDimensionStats(threadCounts[t][d].stats, dimensionOf[d]);
+            threadCounts[t][d].typeIndex.assign(NUM_BLOCKS_DEFINED, -1);
+        }
+    }
+    // region files are all about the same amount of work, so threads just take the next one
+    std::atomic<int> nextFile(0);
+    auto worker = [&](int t) {
+        SectionScratch* scratch = new (std::nothrow) SectionScratch;
+        if (scratch == NULL) {
+            return;
+        }
+        std::vector<unsigned char> nbt;
+        int f;
+        while ((f = nextFile++) < fileCount) {
+            countRegion(regionFilenames[f], threadCounts[t][getWorldStatsDimensionIndex(dimensions[f])], *scratch, nbt);
+        }
+        delete scratch;
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.push_back(std::thread(worker, t));
+    }
+    worker(0);
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    // a thread that couldn't get its scratch space left its files for the others, unless it was the last
+    if (nextFile < fileCount) {
+        return LINE_ERROR;
+    }
+
+    for (int d = 0; d < WORLD_STATS_DIMENSIONS; d++) {
+        DimensionCounts totals;
+        totals.typeIndex.assign(NUM_BLOCKS_DEFINED, -1);
+        DimensionStats& total = stats.dimensions[d];
+        for (int t = 0; t < threadCount; t++) {
+            const DimensionStats& counts = threadCounts[t][d].stats;
+            total.regionCount += counts.regionCount;
+            total.regionErrors += counts.regionErrors;
+            total.chunkCount += counts.chunkCount;
+            total.chunkErrors += counts.chunkErrors;
+            total.sectionCount += counts.sectionCount;
+            total.uniformSectionCount += counts.uniformSectionCount;
+            total.blockCount += counts.blockCount;
+            mergeCounts(totals, counts);
+        }
+        total.names.swap(totals.stats.names);
+        total.types.swap(totals.stats.types);
+        std::sort(total.names.begin(), total.names.end(), moreCommon);
+        std::sort(total.types.begin(), total.types.end(), moreCommon);
+    }
+    return 0;
+}
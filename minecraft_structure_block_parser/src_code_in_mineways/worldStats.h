@@ -0,0 +1,49 @@
+// worldStats.h - count every block of a world by name and by type, per dimension and per height, from section palettes
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Each section's indices are counted layer by layer straight from its packed data (chunkSections.h), so no
+// block grid is ever filled, and a section whose palette has one entry counts as 4096 of it without reading
+// anything more. Region files are shared out among threads, each counting into its own histograms, which
+// are merged at the end. Each section's palette entries are translated to types as the section is counted;
+// after a state's first time, that is a lookup in the palette state cache (blockStateCache.h).
+
+// heights counted level by level; blocks above or below are in the totals only
+#define WORLD_STATS_HEIGHT      (ABSOLUTE_MAX_MAP_HEIGHT - ABSOLUTE_MIN_MAP_HEIGHT + 1)
+// overworld, nether and end, at dimension index 0, 1 and 2
+#define WORLD_STATS_DIMENSIONS  3
+
+typedef struct BlockCount {
+    std::string name;           // Java name without "minecraft:", or the gBlockDefinitions name for type counts
+    int type;                   // index into gBlockDefinitions, or -1 if Mineways doesn't know the name
+    unsigned long long count;
+    unsigned long long byLevel[WORLD_STATS_HEIGHT];     // count at each y, ABSOLUTE_MIN_MAP_HEIGHT first
+} BlockCount;
+
+typedef struct DimensionStats {
+    int dimension;              // 0 overworld, -1 nether, 1 end
+    int regionCount;
+    int regionErrors;           // region files that couldn't be opened
+    long long chunkCount;
+    int chunkErrors;            // chunks that couldn't be read, or have no palettes, as before 1.13
+    long long sectionCount;
+    long long uniformSectionCount;  // of one block, counted without reading their data
+    unsigned long long blockCount;
+    std::vector<BlockCount> names;  // most common first
+    std::vector<BlockCount> types;  // the names Mineways knows, summed by type, most common first
+} DimensionStats;
+
+typedef struct WorldStats {
+    DimensionStats dimensions[WORLD_STATS_DIMENSIONS];
+} WorldStats;
+
+// index into WorldStats::dimensions for a dimension, or -1 if not one of the three
+int getWorldStatsDimensionIndex(int dimension);
+
+// Counts the blocks of the region files, each in the dimension given for it. threadCount of 0 means use
+// all cores. Returns 0 on success, negative if a dimension is not one of the three; region files and
+// chunks that can't be read are counted in the stats as errors and skipped.
+int gatherWorldStats(const wchar_t* const* regionFilenames, const int* dimensions, int fileCount, int threadCount, WorldStats& stats);